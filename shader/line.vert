@@ -6,7 +6,11 @@ uniform vec2 scale;
 uniform mat2 rotation;
 uniform vec2 translation;
 
+// camera, world to clip space
+uniform vec2 view_translation;
+uniform float view_scale;
+
 void main()
 {
-    gl_Position = vec4(vec2((rotation * (Position * scale)) + translation), 0.0f, 1.0f);
+    gl_Position = vec4(((rotation * (Position * scale)) + translation + view_translation) * view_scale, 0.0f, 1.0f);
 }
\ No newline at end of file
@@ -0,0 +1,17 @@
+#version 330 core
+
+noperspective in float edge_distance;
+
+out vec4 result;
+
+uniform vec3 color;
+
+const float HALF_WIDTH = 0.5f;
+
+void main()
+{
+    // coverage of the pixel by the line, a box filter one pixel wide
+    float coverage = clamp(HALF_WIDTH + 0.5f - abs(edge_distance), 0.0f, 1.0f);
+
+    result = vec4(color, coverage);
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#version 330 core
+
+// Rock outlines in their stored form, 16 bit fractions of normalized polar
+// coordinates the attribute setup already maps to [0, 1], decoded as
+// decode_polar in src/PolarVertex.hpp does it
+
+layout(location = 0) in vec2 Polar;
+
+uniform vec2 scale;
+uniform mat2 rotation;
+uniform vec2 translation;
+
+// camera, world to clip space
+uniform vec2 view_translation;
+uniform float view_scale;
+
+void main()
+{
+    float radius = Polar.x * 0.3f + 0.7f;
+    float angle = Polar.y * 6.283f;
+
+    vec2 Position = radius * vec2(cos(angle), sin(angle));
+
+    gl_Position = vec4(((rotation * (Position * scale)) + translation + view_translation) * view_scale, 0.0f, 1.0f);
+}
\ No newline at end of file
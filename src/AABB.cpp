@@ -22,13 +22,15 @@ void position_size_from_AABB(const AABB & aabb, Vec2 & position, Vec2 & size)
     size.y = (max.y - min.y) / 2.0f;
 }
 
-AABB compute_AABB_from_polygon(const std::vector<Vec2> & polygon)
+AABB compute_AABB_from_polygon(const Vec2 * polygon, std::size_t count)
 {
     Vec2 mn{  std::numeric_limits<float>::infinity(),  std::numeric_limits<float>::infinity() };
     Vec2 mx{ -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity() };
 
-    for (const auto & v : polygon)
+    for (std::size_t i = 0; i < count; ++i)
     {
+        const auto & v = polygon[i];
+
         mn.x = std::min(mn.x, v.x);
         mn.y = std::min(mn.y, v.y);
 
@@ -39,6 +41,11 @@ AABB compute_AABB_from_polygon(const std::vector<Vec2> & polygon)
     return { mn, mx };
 }
 
+AABB compute_AABB_from_polygon(const std::vector<Vec2> & polygon)
+{
+    return compute_AABB_from_polygon(polygon.data(), polygon.size());
+}
+
 Vec2 AABB_to_size(const AABB & aabb)
 {
     const auto mn = aabb.getMin();
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <cstdint>
 #include "Vec2.hpp"
 
 struct AABB
@@ -35,6 +36,76 @@ AABB operator + (const AABB & aabb, const Vec2 & v);
 
 void position_size_from_AABB(const AABB & aabb, Vec2 & position, Vec2 & size);
 
+AABB compute_AABB_from_polygon(const Vec2 * polygon, std::size_t count);
+
 AABB compute_AABB_from_polygon(const std::vector<Vec2> & polygon);
 
-Vec2 AABB_to_size(const AABB & aabb);
\ No newline at end of file
+Vec2 AABB_to_size(const AABB & aabb);
+
+// Copy of a body on the other side of the seam of the wrapping
+// [-world_size, world_size] square, tested in the broad phase as if the body were at its position plus
+// offset. Only bodies whose box crosses the seam get ghosts.
+struct GhostProxy
+{
+    std::uint32_t index;
+    Vec2 offset;
+};
+
+// Per axis the offset to the copy of aabb across the seam it crosses, 0 if it crosses none
+inline Vec2 seam_crossing(const AABB & aabb, float world_size)
+{
+    const auto mn = aabb.getMin();
+    const auto mx = aabb.getMax();
+    const auto period = 2.0f * world_size;
+
+    return {
+        mx.x > world_size ? -period : mn.x < -world_size ? period : 0.0f,
+        mx.y > world_size ? -period : mn.y < -world_size ? period : 0.0f
+    };
+}
+
+// Offsets of the ghosts of a body with the given crossing, one per crossed
+// seam and the diagonal one at a corner, returns their count (at most 3)
+inline std::size_t ghost_offsets(const Vec2 & crossing, Vec2 offsets[3])
+{
+    std::size_t count = 0;
+
+    if (crossing.x != 0.0f) offsets[count++] = Vec2{ crossing.x, 0.0f };
+    if (crossing.y != 0.0f) offsets[count++] = Vec2{ 0.0f, crossing.y };
+    if (crossing.x != 0.0f && crossing.y != 0.0f) offsets[count++] = crossing;
+
+    return count;
+}
+
+// Whether a body with the given crossing has a ghost at offset
+inline bool has_ghost(const Vec2 & crossing, const Vec2 & offset)
+{
+    if (offset.x == 0.0f && offset.y == 0.0f)
+        return false;
+
+    return (offset.x == 0.0f || offset.x == crossing.x) && (offset.y == 0.0f || offset.y == crossing.y);
+}
+
+// Offsets of a rock against a body where the rock crosses one seam and the
+// body the other, so the pair only meets at the corner: the rock is moved
+// across its seam and, instead of the body, across the body's seam the other
+// way. Offsets the ghosts of either already cover are left out, returns their
+// count (at most 2)
+inline std::size_t corner_offsets(const Vec2 & body_crossing, const Vec2 & rock_crossing, Vec2 offsets[2])
+{
+    std::size_t count = 0;
+
+    const Vec2 corners[2]{
+        Vec2{ rock_crossing.x, -body_crossing.y },
+        Vec2{ -body_crossing.x, rock_crossing.y }
+    };
+
+    for (const auto & corner : corners)
+    {
+        if (corner.x != 0.0f && corner.y != 0.0f &&
+            !has_ghost(rock_crossing, corner) && !has_ghost(body_crossing, Vec2{ 0.0f, 0.0f } - corner))
+            offsets[count++] = corner;
+    }
+
+    return count;
+}
@@ -0,0 +1,58 @@
+#include "AllocationCounter.hpp"
+
+#ifdef ASTEROIDS_COUNT_ALLOCATIONS
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    std::atomic<std::uint64_t> s_allocations{ 0 };
+
+    //==========================================================================
+    void * counted_allocate(std::size_t size)
+    {
+        s_allocations.fetch_add(1, std::memory_order_relaxed);
+
+        if (void * p = std::malloc(size == 0 ? 1 : size))
+            return p;
+
+        throw std::bad_alloc{};
+    }
+}
+
+void * operator new(std::size_t size) { return counted_allocate(size); }
+void * operator new[](std::size_t size) { return counted_allocate(size); }
+void operator delete(void * p) noexcept { std::free(p); }
+void operator delete[](void * p) noexcept { std::free(p); }
+void operator delete(void * p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void * p, std::size_t) noexcept { std::free(p); }
+
+//==============================================================================
+std::uint64_t heap_allocation_count()
+{
+    return s_allocations.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+bool heap_allocation_counting()
+{
+    return true;
+}
+
+#else
+
+//==============================================================================
+std::uint64_t heap_allocation_count()
+{
+    return 0;
+}
+
+//==============================================================================
+bool heap_allocation_counting()
+{
+    return false;
+}
+
+#endif
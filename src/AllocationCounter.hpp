@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+
+// Global operator new calls since program start. Only counted when built with
+// ASTEROIDS_COUNT_ALLOCATIONS (cmake -DASTEROIDS_COUNT_ALLOCATIONS=ON),
+// otherwise always 0.
+std::uint64_t heap_allocation_count();
+
+bool heap_allocation_counting();
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <new>
+#include <algorithm>
+
+// Bump allocator for data that only lives for one tick. Deallocation is a
+// no-op, everything is released at once by reset(). If a tick needs more than
+// the current capacity, overflow chunks are taken from the heap and merged
+// into one larger block on the next reset, so a steady state tick allocates
+// nothing from the heap and reset() only rewinds an offset.
+class MonotonicArena
+{
+public:
+    //==========================================================================
+    struct Statistics
+    {
+        std::size_t capacity{ 0 };
+        std::size_t used{ 0 };
+        std::size_t peak{ 0 };
+        std::uint64_t upstream_allocations{ 0 };
+    };
+
+    //==========================================================================
+    explicit MonotonicArena(std::size_t capacity = 64 * 1024) :
+        m_buffer{ new unsigned char[capacity] },
+        m_capacity{ capacity }
+    {
+        m_statistics.upstream_allocations++;
+    }
+
+    MonotonicArena(const MonotonicArena &) = delete;
+    MonotonicArena & operator = (const MonotonicArena &) = delete;
+
+    //==========================================================================
+    void * allocate(std::size_t size, std::size_t alignment)
+    {
+        const auto base = reinterpret_cast<std::uintptr_t>(m_buffer.get());
+        const auto aligned = (base + m_offset + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+        const auto offset = static_cast<std::size_t>(aligned - base);
+
+        if (offset + size <= m_capacity)
+        {
+            m_offset = offset + size;
+            m_used += size;
+            return reinterpret_cast<void *>(aligned);
+        }
+
+        // overflow, served by the heap until the next reset grows the buffer
+        m_statistics.upstream_allocations++;
+        m_overflow.emplace_back(new unsigned char[size + alignment]);
+        m_overflow_size += size + alignment;
+        m_used += size;
+
+        const auto overflow = reinterpret_cast<std::uintptr_t>(m_overflow.back().get());
+        return reinterpret_cast<void *>((overflow + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1));
+    }
+
+    //==========================================================================
+    // Release everything allocated since the last reset
+    void reset()
+    {
+        m_statistics.peak = std::max(m_statistics.peak, m_used);
+
+        if (m_overflow.empty() == false)
+        {
+            // grow so the same load fits next time
+            m_capacity = m_capacity * 2 + m_overflow_size;
+            m_buffer.reset(new unsigned char[m_capacity]);
+            m_statistics.upstream_allocations++;
+
+            m_overflow.clear();
+            m_overflow_size = 0;
+        }
+
+        m_offset = 0;
+        m_used = 0;
+    }
+
+    //==========================================================================
+    Statistics statistics() const
+    {
+        Statistics s = m_statistics;
+        s.capacity = m_capacity;
+        s.used = m_used;
+        return s;
+    }
+
+private:
+    std::unique_ptr<unsigned char[]> m_buffer;
+    std::size_t m_capacity;
+    std::size_t m_offset{ 0 };
+    std::size_t m_used{ 0 };
+
+    std::vector<std::unique_ptr<unsigned char[]>> m_overflow;
+    std::size_t m_overflow_size{ 0 };
+
+    Statistics m_statistics;
+
+};
+
+// Standard allocator on top of a MonotonicArena, falls back to the heap
+// without an arena so containers can be used either way
+template <typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    ArenaAllocator(MonotonicArena * arena = nullptr) : m_arena{ arena } {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> & other) : m_arena{ other.arena() } {}
+
+    //==========================================================================
+    T * allocate(std::size_t n)
+    {
+        if (m_arena == nullptr)
+            return static_cast<T *>(::operator new(n * sizeof(T)));
+
+        return static_cast<T *>(m_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    //==========================================================================
+    void deallocate(T * p, std::size_t)
+    {
+        if (m_arena == nullptr)
+            ::operator delete(p);
+    }
+
+    MonotonicArena * arena() const { return m_arena; }
+
+private:
+    MonotonicArena * m_arena;
+
+};
+
+template <typename T, typename U>
+bool operator == (const ArenaAllocator<T> & a, const ArenaAllocator<U> & b) { return a.arena() == b.arena(); }
+
+template <typename T, typename U>
+bool operator != (const ArenaAllocator<T> & a, const ArenaAllocator<U> & b) { return a.arena() != b.arena(); }
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
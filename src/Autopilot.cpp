@@ -0,0 +1,178 @@
+#include "Autopilot.hpp"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "World.hpp"
+
+namespace
+{
+    // radians, the aim is never better than this
+    constexpr float MIN_FIRE_TOLERANCE = 0.02f;
+
+    // ship sizes of room a passing rock has to leave
+    constexpr float DODGE_CLEARANCE = 3.0f;
+
+    //==========================================================================
+    // Shortest offset from a to b on the wrapping [-world_size, world_size] square
+    Vec2 wrapped_delta(const Vec2 & a, const Vec2 & b, float world_size)
+    {
+        Vec2 d = b - a;
+
+        if (d.x >  world_size) d.x -= 2.0f * world_size;
+        if (d.x < -world_size) d.x += 2.0f * world_size;
+        if (d.y >  world_size) d.y -= 2.0f * world_size;
+        if (d.y < -world_size) d.y += 2.0f * world_size;
+
+        return d;
+    }
+
+    //==========================================================================
+    float dot2(const Vec2 & a, const Vec2 & b)
+    {
+        return a.x * b.x + a.y * b.y;
+    }
+
+    //==========================================================================
+    // Time until a projectile fired now at speed meets a body at offset moving
+    // with velocity, the flight time to the current position if it never does
+    float intercept_time(const Vec2 & offset, const Vec2 & velocity, float speed)
+    {
+        const float a = dot2(velocity, velocity) - speed * speed;
+        const float b = 2.0f * dot2(offset, velocity);
+        const float c = dot2(offset, offset);
+
+        const float direct = std::sqrt(c) / speed;
+
+        if (std::fabs(a) < 1e-6f)
+            return b < 0.0f ? std::max(0.0f, -c / b) : direct;
+
+        const float discriminant = b * b - 4.0f * a * c;
+        if (discriminant < 0.0f)
+            return direct;
+
+        const float root = std::sqrt(discriminant);
+        const float t0 = (-b - root) / (2.0f * a);
+        const float t1 = (-b + root) / (2.0f * a);
+
+        const float t = t0 > 0.0f && (t0 < t1 || t1 <= 0.0f) ? t0 : t1;
+        return t > 0.0f ? t : direct;
+    }
+
+    //==========================================================================
+    // Signed angle from direction to target, positive is counter clockwise
+    float angle_to(const Vec2 & direction, const Vec2 & target)
+    {
+        const float cross = direction.x * target.y - direction.y * target.x;
+        return std::atan2(cross, dot2(direction, target));
+    }
+}
+
+constexpr float Autopilot::DODGE_HORIZON;
+
+//==============================================================================
+InputFrame Autopilot::next(const World & world, std::size_t ship)
+{
+    InputFrame input;
+
+    if (ship >= world.shipCount() || world.shipDestroyed(ship))
+        return input;
+
+    const auto & rocks = world.rocks();
+    if (rocks.empty())
+        return input;
+
+    const auto & s = world.scenario();
+    const auto & own = world.ship(ship);
+    const Vec2 position = own.position();
+    const Vec2 direction = own.direction();
+
+    // nearest rock, and the rock that comes closest soonest within the horizon
+    std::size_t nearest = 0;
+    float nearest_distance = std::numeric_limits<float>::max();
+
+    std::size_t threat = rocks.size();
+    float threat_time = std::numeric_limits<float>::max();
+    Vec2 threat_miss{ 0.0f, 0.0f };
+
+    for (std::size_t i = 0; i < rocks.size(); ++i)
+    {
+        const auto & r = rocks[i];
+        const Vec2 offset = wrapped_delta(position, r.position(), s.world_size);
+        const float distance = dot2(offset, offset);
+
+        if (distance < nearest_distance)
+        {
+            nearest_distance = distance;
+            nearest = i;
+        }
+
+        // closest approach of the rock path to the ship
+        const Vec2 velocity = r.velocity();
+        const float speed2 = dot2(velocity, velocity);
+        const float t = speed2 > 0.0f ? std::min(DODGE_HORIZON, std::max(0.0f, -dot2(offset, velocity) / speed2)) : 0.0f;
+        const Vec2 miss = offset + velocity * t;
+        const float clearance = r.scale() + s.ship_size * DODGE_CLEARANCE;
+
+        if (dot2(miss, miss) < clearance * clearance && t < threat_time)
+        {
+            threat_time = t;
+            threat = i;
+            threat_miss = miss;
+        }
+    }
+
+    const std::size_t target = threat < rocks.size() ? threat : nearest;
+    const auto & rock = rocks[target];
+
+    // aim where the projectile meets the target
+    const Vec2 offset = wrapped_delta(position, rock.position(), s.world_size);
+    const float flight = intercept_time(offset, rock.velocity(), s.projectile_speed);
+    const Vec2 aim = offset + rock.velocity() * flight;
+
+    const float error = angle_to(direction, aim);
+
+    // fire when the aim is inside the outline and the projectile lives long enough to get there
+    const float aim_distance = std::sqrt(dot2(aim, aim));
+    const float tolerance = std::max(MIN_FIRE_TOLERANCE, std::atan2(rock.scale(), aim_distance));
+    if (std::fabs(error) < tolerance && flight < s.projectile_life_time)
+    {
+        input.held[static_cast<std::size_t>(Action::FIRE)] = 1.0f;
+        input.first_down[static_cast<std::size_t>(Action::FIRE)] = 0.0f;
+    }
+
+    // turn to the aim, or when dodging to the escape axis, forward or backward whichever is closer
+    float turn_error = error;
+
+    if (threat < rocks.size())
+    {
+        m_dodge_ticks++;
+
+        // away from the closest approach, sideways off the path of a head on rock
+        Vec2 away = threat_miss * -1.0f;
+        if (dot2(away, away) < 1e-8f)
+            away = Vec2{ -rock.velocity().y, rock.velocity().x };
+
+        const bool forward = dot2(direction, away) >= 0.0f;
+        const auto thrust_action = static_cast<std::size_t>(forward ? Action::FORWARD : Action::BACKWARD);
+        input.held[thrust_action] = 1.0f;
+        input.first_down[thrust_action] = 0.0f;
+
+        // keep aiming at the threat if a projectile gets there before the rock does
+        if (flight > threat_time)
+            turn_error = angle_to(direction, forward ? away : away * -1.0f);
+    }
+
+    // turn for the fraction of the tick that lands on the target angle instead of overshooting
+    const float max_turn = 6.2831853f * s.ship_rotation_speed * world.deltaTime();
+    const float turn = max_turn > 0.0f ? std::min(1.0f, std::fabs(turn_error) / max_turn) : 0.0f;
+    const auto turn_action = static_cast<std::size_t>(turn_error > 0.0f ? Action::LEFT : Action::RIGHT);
+    if (turn > 0.0f)
+    {
+        input.held[turn_action] = turn;
+        input.first_down[turn_action] = 0.0f;
+    }
+
+    return input;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+#include "InputSource.hpp"
+
+// Scripted pilot for unattended sessions.
+//
+// Every tick it picks a target, aims ahead of it at the interception point of
+// a projectile and fires once the aim is within the target's outline. A rock
+// that will pass closer than a ship length within DODGE_HORIZON becomes the
+// target instead and the ship thrusts away from its path while turning to
+// shoot it. The input depends only on the world state, so a session with
+// the autopilot replays exactly from the same scenario.
+class Autopilot : public InputSource
+{
+public:
+    // seconds ahead that rock paths are checked for collisions with the ship
+    static constexpr float DODGE_HORIZON = 0.75f;
+
+    InputFrame next(const World & world, std::size_t ship) override;
+
+    // ticks spent dodging so far
+    std::uint64_t dodgeTicks() const { return m_dodge_ticks; }
+
+private:
+    std::uint64_t m_dodge_ticks{ 0 };
+
+};
@@ -0,0 +1,841 @@
+#include "BatchWorld.hpp"
+
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+#include <utility>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "World.hpp"
+#include "Trace.hpp"
+
+namespace
+{
+    // simd lanes, slot blocks are padded to a multiple
+    constexpr std::size_t LANES = 4;
+
+    // worlds per task of the worker pool
+    constexpr std::size_t CHUNK_WORLDS = 32;
+
+    //==========================================================================
+    std::size_t padded(std::size_t count)
+    {
+        return (count + LANES - 1) / LANES * LANES;
+    }
+
+    //==========================================================================
+    // Euler step with wrap around of count slots (a multiple of LANES), the
+    // same arithmetic as integrate_wrapped so the results are bit-identical
+    void integrate(float * x, float * y, const float * vx, const float * vy,
+                   const float * size_x, const float * size_y, std::size_t count, float delta_time, float world_size)
+    {
+#if defined(__SSE2__)
+        const __m128 dt = _mm_set1_ps(delta_time);
+        const __m128 upper = _mm_set1_ps(world_size);
+        const __m128 lower = _mm_set1_ps(-world_size);
+        const __m128 period = _mm_set1_ps(2.0f * world_size);
+        const __m128 two = _mm_set1_ps(2.0f);
+
+        const auto select = [] (__m128 mask, __m128 a, __m128 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); };
+
+        for (std::size_t i = 0; i < count; i += LANES)
+        {
+            const __m128 sx = _mm_loadu_ps(size_x + i);
+            const __m128 sy = _mm_loadu_ps(size_y + i);
+
+            __m128 px = _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(_mm_loadu_ps(vx + i), dt));
+            __m128 py = _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(_mm_loadu_ps(vy + i), dt));
+
+            // wrap_around, lower bounds first
+            const __m128 span_x = _mm_add_ps(period, _mm_mul_ps(two, sx));
+            const __m128 span_y = _mm_add_ps(period, _mm_mul_ps(two, sy));
+
+            px = select(_mm_cmplt_ps(px, _mm_sub_ps(lower, sx)), _mm_add_ps(px, span_x), px);
+            py = select(_mm_cmplt_ps(py, _mm_sub_ps(lower, sy)), _mm_add_ps(py, span_y), py);
+            px = select(_mm_cmpgt_ps(px, _mm_add_ps(upper, sx)), _mm_sub_ps(px, span_x), px);
+            py = select(_mm_cmpgt_ps(py, _mm_add_ps(upper, sy)), _mm_sub_ps(py, span_y), py);
+
+            _mm_storeu_ps(x + i, px);
+            _mm_storeu_ps(y + i, py);
+        }
+#else
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            Vec2 position{ x[i], y[i] };
+            integrate_wrapped(position, Vec2{ vx[i], vy[i] }, delta_time, Vec2{ size_x[i], size_y[i] }, world_size);
+
+            x[i] = position.x;
+            y[i] = position.y;
+        }
+#endif
+    }
+
+    //==========================================================================
+    // Seams crossed by the boxes of the rock slots [first, first + LANES), the
+    // lane bits of max x > world_size, min x < -world_size, max y > world_size
+    // and min y < -world_size in that order of nibbles, the tests of seam_crossing
+    unsigned crossed_seams(const float * x, const float * y,
+                           const float * box_min_x, const float * box_min_y, const float * box_max_x, const float * box_max_y,
+                           std::size_t first, float world_size)
+    {
+#if defined(__SSE2__)
+        const __m128 px = _mm_loadu_ps(x + first);
+        const __m128 py = _mm_loadu_ps(y + first);
+        const __m128 upper = _mm_set1_ps(world_size);
+        const __m128 lower = _mm_set1_ps(-world_size);
+
+        const auto bits = [] (__m128 mask) { return static_cast<unsigned>(_mm_movemask_ps(mask)); };
+
+        return bits(_mm_cmpgt_ps(_mm_add_ps(_mm_loadu_ps(box_max_x + first), px), upper))
+            | bits(_mm_cmplt_ps(_mm_add_ps(_mm_loadu_ps(box_min_x + first), px), lower)) << 4
+            | bits(_mm_cmpgt_ps(_mm_add_ps(_mm_loadu_ps(box_max_y + first), py), upper)) << 8
+            | bits(_mm_cmplt_ps(_mm_add_ps(_mm_loadu_ps(box_min_y + first), py), lower)) << 12;
+#else
+        unsigned seams = 0;
+
+        for (std::size_t lane = 0; lane < LANES; ++lane)
+        {
+            const auto i = first + lane;
+            seams |= static_cast<unsigned>(box_max_x[i] + x[i] > world_size) << lane;
+            seams |= static_cast<unsigned>(box_min_x[i] + x[i] < -world_size) << (4 + lane);
+            seams |= static_cast<unsigned>(box_max_y[i] + y[i] > world_size) << (8 + lane);
+            seams |= static_cast<unsigned>(box_min_y[i] + y[i] < -world_size) << (12 + lane);
+        }
+
+        return seams;
+#endif
+    }
+
+    //==========================================================================
+    // aabb + offset written out so it inlines, the same arithmetic
+    AABB shifted(const AABB & aabb, const Vec2 & offset)
+    {
+        const auto mn = aabb.getMin();
+        const auto mx = aabb.getMax();
+
+        return AABB{ Vec2{ mn.x + offset.x, mn.y + offset.y }, Vec2{ mx.x + offset.x, mx.y + offset.y } };
+    }
+
+#if defined(__SSE2__)
+    //==========================================================================
+    // Lanes whose boxes overlap the box min, max, the test of AABB::intersect
+    // with that box as the first one
+    unsigned overlap_mask(const Vec2 & min, const Vec2 & max, __m128 box_min_x, __m128 box_min_y, __m128 box_max_x, __m128 box_max_y)
+    {
+        __m128 mask = _mm_cmple_ps(_mm_set1_ps(min.x), box_max_x);
+        mask = _mm_and_ps(mask, _mm_cmpge_ps(_mm_set1_ps(max.x), box_min_x));
+        mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_set1_ps(min.y), box_max_y));
+        mask = _mm_and_ps(mask, _mm_cmpge_ps(_mm_set1_ps(max.y), box_min_y));
+
+        return static_cast<unsigned>(_mm_movemask_ps(mask));
+    }
+#endif
+
+    //==========================================================================
+    // Lanes of the ghost boxes [first, first + LANES) that overlap the given
+    // box, as overlapping() for boxes that are already in world space
+    unsigned overlapping(const float * box_min_x, const float * box_min_y, const float * box_max_x, const float * box_max_y,
+                         std::size_t first, const AABB & box)
+    {
+        const Vec2 min = box.getMin();
+        const Vec2 max = box.getMax();
+
+#if defined(__SSE2__)
+        return overlap_mask(min, max, _mm_loadu_ps(box_min_x + first), _mm_loadu_ps(box_min_y + first),
+                            _mm_loadu_ps(box_max_x + first), _mm_loadu_ps(box_max_y + first));
+#else
+        unsigned mask = 0;
+
+        for (std::size_t lane = 0; lane < LANES; ++lane)
+        {
+            const auto i = first + lane;
+            if (AABB::intersect(box, AABB{ Vec2{ box_min_x[i], box_min_y[i] }, Vec2{ box_max_x[i], box_max_y[i] } }))
+                mask |= 1u << lane;
+        }
+
+        return mask;
+#endif
+    }
+
+    //==========================================================================
+    // Lanes of the rock slots [first, first + LANES) whose boxes overlap the
+    // given box, the test of AABB::intersect with the given box as the first one
+    unsigned overlapping(const float * x, const float * y,
+                         const float * box_min_x, const float * box_min_y, const float * box_max_x, const float * box_max_y,
+                         std::size_t first, const AABB & box)
+    {
+        const Vec2 min = box.getMin();
+        const Vec2 max = box.getMax();
+
+#if defined(__SSE2__)
+        const __m128 px = _mm_loadu_ps(x + first);
+        const __m128 py = _mm_loadu_ps(y + first);
+
+        const __m128 rock_min_x = _mm_add_ps(_mm_loadu_ps(box_min_x + first), px);
+        const __m128 rock_min_y = _mm_add_ps(_mm_loadu_ps(box_min_y + first), py);
+        const __m128 rock_max_x = _mm_add_ps(_mm_loadu_ps(box_max_x + first), px);
+        const __m128 rock_max_y = _mm_add_ps(_mm_loadu_ps(box_max_y + first), py);
+
+        return overlap_mask(min, max, rock_min_x, rock_min_y, rock_max_x, rock_max_y);
+#else
+        unsigned mask = 0;
+
+        for (std::size_t lane = 0; lane < LANES; ++lane)
+        {
+            const auto i = first + lane;
+            const AABB rock{ Vec2{ box_min_x[i] + x[i], box_min_y[i] + y[i] }, Vec2{ box_max_x[i] + x[i], box_max_y[i] + y[i] } };
+
+            if (AABB::intersect(box, rock))
+                mask |= 1u << lane;
+        }
+
+        return mask;
+#endif
+    }
+}
+
+//==============================================================================
+BatchWorld::BatchWorld(const Scenario & scenario, std::size_t world_count, std::size_t thread_count) :
+    m_scenario{ scenario },
+    m_delta_time{ scenario.deltaTime() },
+    m_world_count{ world_count },
+    m_base_seed{ World::resolveSeed(scenario.seed) },
+    m_pool{ thread_count }
+{
+    if (scenario.sector_size > 0.0f)
+        throw std::runtime_error("Batch worlds don't support sector streaming.");
+
+    // a game never has more rocks than the fragments of its initial rocks
+    std::size_t fragments = 1;
+    for (const auto & tier : scenario.vertex_tiers)
+        fragments = std::max(fragments, Rock::maxFragments(static_cast<std::size_t>(tier.vertex_count)));
+
+    m_rock_capacity = padded(scenario.rock_count * fragments);
+
+    // one shot per tick at most and one per weapon cool down, each living at
+    // most its life time and the part of a tick it was back dated by
+    const float life = scenario.projectile_life_time + m_delta_time;
+    const auto per_tick = static_cast<std::size_t>(std::ceil(life / m_delta_time)) + 1;
+    const auto per_cool_down = static_cast<std::size_t>(std::ceil(life * scenario.fire_rate)) + 2;
+
+    m_projectile_capacity = padded(std::min(per_tick, per_cool_down));
+
+    const auto rock_slots = m_rock_capacity * world_count;
+    const auto projectile_slots = m_projectile_capacity * world_count;
+
+    m_rocks.forEachField([rock_slots] (auto & field) { field.resize(rock_slots); });
+    m_projectiles.forEachField([projectile_slots] (auto & field) { field.resize(projectile_slots); });
+
+    m_rock_counts.resize(world_count, 0);
+    m_projectile_counts.resize(world_count, 0);
+
+    const auto player = World::newPlayer(scenario);
+    m_ships.resize(world_count, player.ship);
+    m_invincibility.resize(world_count, player.invincibility_left);
+    m_destroyed.resize(world_count, 0);
+
+    m_rngs.resize(world_count);
+    m_seeds.resize(world_count, 0);
+    m_games.resize(world_count, 0);
+    m_tick_counts.resize(world_count, 0);
+    m_scores.resize(world_count, 0);
+    m_finished.resize(world_count);
+
+    for (std::size_t i = 0; i < m_pool.threadCount(); ++i)
+        m_scratch.push_back(std::make_unique<Scratch>());
+
+    for (std::size_t w = 0; w < world_count; ++w)
+        resetWorld(w, *m_scratch[0]);
+}
+
+//==============================================================================
+Vec2 BatchWorld::rockPosition(std::size_t world, std::size_t i) const
+{
+    const auto slot = world * m_rock_capacity + i;
+    return Vec2{ m_rocks.x[slot], m_rocks.y[slot] };
+}
+
+//==============================================================================
+Vec2 BatchWorld::rockVelocity(std::size_t world, std::size_t i) const
+{
+    const auto slot = world * m_rock_capacity + i;
+    return Vec2{ m_rocks.vx[slot], m_rocks.vy[slot] };
+}
+
+//==============================================================================
+Vec2 BatchWorld::projectilePosition(std::size_t world, std::size_t i) const
+{
+    const auto slot = world * m_projectile_capacity + i;
+    return Vec2{ m_projectiles.x[slot], m_projectiles.y[slot] };
+}
+
+//==============================================================================
+Vec2 BatchWorld::projectileVelocity(std::size_t world, std::size_t i) const
+{
+    const auto slot = world * m_projectile_capacity + i;
+    return Vec2{ m_projectiles.vx[slot], m_projectiles.vy[slot] };
+}
+
+//==============================================================================
+BatchWorld::Statistics BatchWorld::statistics() const
+{
+    Statistics total;
+
+    for (const auto & s : m_finished)
+    {
+        total.games += s.games;
+        total.cleared += s.cleared;
+        total.score += s.score;
+        total.ticks += s.ticks;
+    }
+
+    return total;
+}
+
+//==============================================================================
+void BatchWorld::reset(std::size_t world)
+{
+    resetWorld(world, *m_scratch[0]);
+}
+
+//==============================================================================
+void BatchWorld::tick(const InputFrame * inputs, const Observation * observation)
+{
+    TRACE_SCOPE("batch tick");
+
+    const auto chunks = (m_world_count + CHUNK_WORLDS - 1) / CHUNK_WORLDS;
+
+    // two pointers of capture fit the small buffer of std::function, a tick never allocates
+    const std::pair<const InputFrame *, const Observation *> arguments{ inputs, observation };
+
+    m_pool.run(chunks, [this, &arguments] (std::size_t chunk, std::size_t worker)
+    {
+        const auto first = chunk * CHUNK_WORLDS;
+        const auto last = std::min(m_world_count, first + CHUNK_WORLDS);
+
+        tickChunk(first, last, arguments.first, arguments.second, *m_scratch[worker]);
+    });
+}
+
+//==============================================================================
+void BatchWorld::observe(std::size_t w, const Observation & observation) const
+{
+    const auto rock_count = m_rock_counts[w];
+    const auto projectile_count = m_projectile_counts[w];
+
+    if (observation.rocks)
+    {
+        const auto & r = m_rocks;
+        auto * out = observation.rocks + w * m_rock_capacity * Observation::ROCK_FLOATS;
+
+        for (auto i = w * m_rock_capacity; i < w * m_rock_capacity + rock_count; ++i)
+        {
+            *out++ = r.x[i];
+            *out++ = r.y[i];
+            *out++ = r.vx[i];
+            *out++ = r.vy[i];
+            *out++ = r.size[i];
+        }
+    }
+
+    if (observation.projectiles)
+    {
+        const auto & p = m_projectiles;
+        auto * out = observation.projectiles + w * m_projectile_capacity * Observation::PROJECTILE_FLOATS;
+
+        for (auto i = w * m_projectile_capacity; i < w * m_projectile_capacity + projectile_count; ++i)
+        {
+            *out++ = p.x[i];
+            *out++ = p.y[i];
+            *out++ = p.vx[i];
+            *out++ = p.vy[i];
+        }
+    }
+
+    if (observation.ships)
+    {
+        const auto & ship = m_ships[w];
+        auto * out = observation.ships + w * Observation::SHIP_FLOATS;
+
+        out[0] = ship.position().x;
+        out[1] = ship.position().y;
+        out[2] = ship.direction().x;
+        out[3] = ship.direction().y;
+        out[4] = m_invincibility[w];
+        out[5] = m_destroyed[w] ? 1.0f : 0.0f;
+    }
+
+    if (observation.rock_counts) observation.rock_counts[w] = rock_count;
+    if (observation.projectile_counts) observation.projectile_counts[w] = projectile_count;
+    if (observation.scores) observation.scores[w] = m_scores[w];
+}
+
+//==============================================================================
+void BatchWorld::tickChunk(std::size_t first, std::size_t last, const InputFrame * inputs, const Observation * observation, Scratch & scratch)
+{
+    const float delta_time = m_delta_time;
+
+    // move ships and shoot
+    for (std::size_t w = first; w < last; ++w)
+    {
+        if (m_destroyed[w])
+            continue;
+
+        const InputFrame input = inputs ? inputs[w] : InputFrame{};
+
+        m_ships[w].move(delta_time, input, m_scenario.world_size);
+        const auto shot = m_ships[w].shoot(delta_time, input, m_scenario.auto_fire);
+        if (std::get<0>(shot) == true)
+            addProjectile(w, std::get<1>(shot));
+    }
+
+    // move the rocks and projectiles of all worlds of the chunk at once, free slots included
+    {
+        auto & r = m_rocks;
+        const auto begin = first * m_rock_capacity;
+        const auto count = (last - first) * m_rock_capacity;
+
+        integrate(&r.x[begin], &r.y[begin], &r.vx[begin], &r.vy[begin], &r.size[begin], &r.size[begin], count, delta_time, m_scenario.world_size);
+    }
+    {
+        auto & p = m_projectiles;
+        const auto begin = first * m_projectile_capacity;
+        const auto count = (last - first) * m_projectile_capacity;
+
+        integrate(&p.x[begin], &p.y[begin], &p.vx[begin], &p.vy[begin], &p.size_x[begin], &p.size_y[begin], count, delta_time, m_scenario.world_size);
+
+        for (std::size_t i = begin; i < begin + count; ++i)
+            p.time_left[i] -= delta_time;
+    }
+
+    for (std::size_t w = first; w < last; ++w)
+    {
+        tickWorld(w, scratch);
+
+        const bool cleared = m_rock_counts[w] == 0;
+        if (cleared || m_destroyed[w])
+        {
+            auto & finished = m_finished[w];
+            finished.games++;
+            finished.cleared += cleared ? 1 : 0;
+            finished.score += m_scores[w];
+            finished.ticks += m_tick_counts[w];
+
+            resetWorld(w, scratch);
+
+            if (observation && observation->done)
+                observation->done[w] = 1;
+        }
+
+        // while the world is still in cache
+        if (observation)
+            observe(w, *observation);
+    }
+}
+
+//==============================================================================
+void BatchWorld::tickWorld(std::size_t w, Scratch & scratch)
+{
+    const float delta_time = m_delta_time;
+
+    auto & r = m_rocks;
+    auto & p = m_projectiles;
+
+    const auto rocks = w * m_rock_capacity;
+    const auto projectiles = w * m_projectile_capacity;
+
+    // remove projectiles that reached end of life
+    m_projectile_counts[w] = static_cast<std::uint32_t>(
+        compact(p, projectiles, m_projectile_counts[w], [&p] (std::size_t i) { return p.time_left[i] <= 0.0f; })
+    );
+
+    // projectile-rock collisions, the candidates of each projectile in the order of
+    // World (rocks, rock ghosts, projectile ghosts, corners), so the narrow phase sees the
+    // same pairs in the same order
+    const auto rock_count = m_rock_counts[w];
+    auto & hit_rocks = scratch.hit_rocks;
+    hit_rocks.clear();
+
+    const auto rock_box = [this] (std::size_t i) { return rockBox(i); };
+    const auto & g = scratch.ghosts;
+
+    const bool ghosts_made = m_projectile_counts[w] != 0;
+    if (ghosts_made)
+        makeRockGhosts(w, scratch);
+
+    for (std::size_t ip = projectiles; ip < projectiles + m_projectile_counts[w]; ++ip)
+    {
+        const Vec2 position{ p.x[ip], p.y[ip] };
+        const AABB box{ Vec2{ p.box_min_x[ip], p.box_min_y[ip] } + position, Vec2{ p.box_max_x[ip], p.box_max_y[ip] } + position };
+
+        bool dead = false;
+
+        // narrow phase against rock slot ir at its position plus offset
+        const auto test = [&] (std::size_t ir, const Vec2 & offset)
+        {
+            if (r.hit[ir])
+                return;
+
+            const float rotation[4]{ p.m0[ip], p.m1[ip], p.m2[ip], p.m3[ip] };
+            const auto polygon = Projectile::polygonSRT(position, Vec2{ p.size_x[ip], p.size_y[ip] }, rotation);
+
+            if (scratch.narrow_phase.intersect(p.id[ip], polygon, r.id[ir], *r.shape[ir], r.size[ir], Vec2{ r.x[ir], r.y[ir] } + offset))
+            {
+                r.hit[ir] = 1;
+                hit_rocks.push_back(static_cast<std::uint32_t>(ir));
+
+                // mark used projectile dead
+                p.time_left[ip] = -1.0f;
+                dead = true;
+            }
+        };
+
+        for (std::size_t block = 0; block < rock_count && !dead; block += LANES)
+        {
+            auto mask = overlapping(r.x.data(), r.y.data(), r.box_min_x.data(), r.box_min_y.data(),
+                                    r.box_max_x.data(), r.box_max_y.data(), rocks + block, box);
+
+            // free slots past the live rocks
+            if (block + LANES > rock_count)
+                mask &= (1u << (rock_count - block)) - 1;
+
+            for (; mask != 0 && !dead; mask &= mask - 1)
+                test(rocks + block + static_cast<std::size_t>(__builtin_ctz(mask)), Vec2{ 0.0f, 0.0f });
+        }
+
+        for (std::size_t block = 0; block < g.count && !dead; block += LANES)
+        {
+            // the padding lanes hold empty boxes
+            for (auto mask = overlapping(g.min_x.data(), g.min_y.data(), g.max_x.data(), g.max_y.data(), block, box); mask != 0 && !dead; mask &= mask - 1)
+            {
+                const auto & ghost = g.proxies[block + static_cast<std::size_t>(__builtin_ctz(mask))];
+                test(rocks + ghost.index, ghost.offset);
+            }
+        }
+
+        const auto crossing = seam_crossing(box, m_scenario.world_size);
+
+        Vec2 offsets[3];
+        const auto count = ghost_offsets(crossing, offsets);
+
+        for (std::size_t k = 0; k < count && !dead; ++k)
+        {
+            const Vec2 offset = Vec2{ 0.0f, 0.0f } - offsets[k];
+
+            for (std::size_t i = rocks; i < rocks + rock_count && !dead; ++i)
+            {
+                const auto rock = rock_box(i);
+                if (!has_ghost(seam_crossing(rock, m_scenario.world_size), offset) && AABB::intersect(box, shifted(rock, offset)))
+                    test(i, offset);
+            }
+        }
+
+        for (std::size_t i = rocks; i < rocks + rock_count && count != 0 && !dead; ++i)
+        {
+            const auto rock = rock_box(i);
+
+            Vec2 corners[2];
+            const auto corner_count = corner_offsets(crossing, seam_crossing(rock, m_scenario.world_size), corners);
+
+            for (std::size_t k = 0; k < corner_count && !dead; ++k)
+                if (AABB::intersect(box, shifted(rock, corners[k])))
+                    test(i, corners[k]);
+        }
+    }
+
+    if (hit_rocks.empty() == false)
+    {
+        // split hit rocks in the order they were hit
+        auto & new_rocks = scratch.new_rocks;
+
+        for (const auto ir : hit_rocks)
+        {
+            const auto fragments = Rock::split(m_rngs[w], new_rocks, r.shape[ir]->polygon.size(), r.size[ir], Vec2{ r.x[ir], r.y[ir] },
+                                               m_scenario.split_speed_max, &scratch.arena);
+            m_scores[w] += World::rockPoints(fragments);
+        }
+
+        // remove hit rocks, keeping the order of the others, then append the fragments
+        const auto kept = compact(r, rocks, rock_count, [&r] (std::size_t i) { return r.hit[i] != 0; });
+        for (auto i = rocks + kept; i < rocks + rock_count; ++i)
+            r.shape[i].reset();
+
+        m_rock_counts[w] = static_cast<std::uint32_t>(kept);
+
+        for (const auto & rock : new_rocks)
+            addRock(w, rock);
+
+        new_rocks.clear();
+    }
+
+    // remove projectiles that have hit rocks
+    m_projectile_counts[w] = static_cast<std::uint32_t>(
+        compact(p, projectiles, m_projectile_counts[w], [&p] (std::size_t i) { return p.time_left[i] <= 0.0f; })
+    );
+
+    // ship-rock collisions
+    if (m_destroyed[w] == 0)
+    {
+        m_invincibility[w] -= delta_time;
+
+        if (m_invincibility[w] < 0.0f)
+        {
+            const auto & ship = m_ships[w];
+            const auto box = ship.boundingBox();
+            const auto count = m_rock_counts[w];
+
+            // unless still valid, nothing has moved but rocks may have been split
+            if (!ghosts_made || !hit_rocks.empty())
+                makeRockGhosts(w, scratch);
+
+            const auto hits = [&] (std::size_t ir, const Vec2 & offset)
+            {
+                return scratch.narrow_phase.intersect(ship, r.id[ir], *r.shape[ir], r.size[ir], Vec2{ r.x[ir], r.y[ir] } + offset);
+            };
+
+            bool hit = false;
+
+            for (std::size_t block = 0; block < count && !hit; block += LANES)
+            {
+                auto mask = overlapping(r.x.data(), r.y.data(), r.box_min_x.data(), r.box_min_y.data(),
+                                        r.box_max_x.data(), r.box_max_y.data(), rocks + block, box);
+
+                if (block + LANES > count)
+                    mask &= (1u << (count - block)) - 1;
+
+                for (; mask != 0 && !hit; mask &= mask - 1)
+                    hit = hits(rocks + block + static_cast<std::size_t>(__builtin_ctz(mask)), Vec2{ 0.0f, 0.0f });
+            }
+
+            for (std::size_t block = 0; block < g.count && !hit; block += LANES)
+            {
+                for (auto mask = overlapping(g.min_x.data(), g.min_y.data(), g.max_x.data(), g.max_y.data(), block, box); mask != 0 && !hit; mask &= mask - 1)
+                {
+                    const auto & ghost = g.proxies[block + static_cast<std::size_t>(__builtin_ctz(mask))];
+                    hit = hits(rocks + ghost.index, ghost.offset);
+                }
+            }
+
+            const auto crossing = seam_crossing(box, m_scenario.world_size);
+
+            Vec2 offsets[3];
+            const auto ghost_count = ghost_offsets(crossing, offsets);
+
+            for (std::size_t k = 0; k < ghost_count && !hit; ++k)
+            {
+                const Vec2 offset = Vec2{ 0.0f, 0.0f } - offsets[k];
+
+                for (std::size_t i = rocks; i < rocks + count && !hit; ++i)
+                {
+                    const auto rock = rock_box(i);
+                    hit = !has_ghost(seam_crossing(rock, m_scenario.world_size), offset) && AABB::intersect(box, shifted(rock, offset)) && hits(i, offset);
+                }
+            }
+
+            for (std::size_t i = rocks; i < rocks + count && ghost_count != 0 && !hit; ++i)
+            {
+                const auto rock = rock_box(i);
+
+                Vec2 corners[2];
+                const auto corner_count = corner_offsets(crossing, seam_crossing(rock, m_scenario.world_size), corners);
+
+                for (std::size_t k = 0; k < corner_count && !hit; ++k)
+                    hit = AABB::intersect(box, shifted(rock, corners[k])) && hits(i, corners[k]);
+            }
+
+            if (hit)
+                m_destroyed[w] = 1;
+        }
+    }
+
+    m_tick_counts[w]++;
+
+    scratch.arena.reset();
+}
+
+//==============================================================================
+AABB BatchWorld::rockBox(std::size_t slot) const
+{
+    // the same arithmetic as Rock::boundingBox, written out so it inlines
+    const auto & r = m_rocks;
+
+    return AABB{
+        Vec2{ r.box_min_x[slot] + r.x[slot], r.box_min_y[slot] + r.y[slot] },
+        Vec2{ r.box_max_x[slot] + r.x[slot], r.box_max_y[slot] + r.y[slot] }
+    };
+}
+
+//==============================================================================
+void BatchWorld::makeRockGhosts(std::size_t w, Scratch & scratch) const
+{
+    const auto first = w * m_rock_capacity;
+    const auto count = m_rock_counts[w];
+
+    // Whether a rock crosses the seam changes from tick to tick and world to
+    // world, so every rock writes all its possible ghosts and only keeps those
+    // that exist, there are no branches to mispredict. That needs room for
+    // three ghosts of every slot of the blocks and the padding.
+    auto & g = scratch.ghosts;
+    g.reserve(3 * padded(count) + LANES);
+
+    // crossing of an axis by its bits of (max > world_size, min < -world_size), as seam_crossing
+    const float period = 2.0f * m_scenario.world_size;
+    const float crossings[4]{ 0.0f, period, -period, -period };
+
+    std::size_t n = 0;
+
+    for (std::size_t block = 0; block < count; block += LANES)
+    {
+        const auto seams = crossed_seams(m_rocks.x.data(), m_rocks.y.data(), m_rocks.box_min_x.data(), m_rocks.box_min_y.data(),
+                                         m_rocks.box_max_x.data(), m_rocks.box_max_y.data(), first + block, m_scenario.world_size);
+
+        for (std::size_t lane = 0; lane < LANES; ++lane)
+        {
+            const auto i = block + lane;
+            const auto side = [seams, lane] (unsigned nibble) { return (seams >> (4 * nibble + lane)) & 1u; };
+
+            const Vec2 crossing{ crossings[side(0) << 1 | side(1)], crossings[side(2) << 1 | side(3)] };
+            const std::size_t live = i < count ? 1 : 0;
+            const std::size_t has_x = live & (crossing.x != 0.0f ? 1 : 0);
+            const std::size_t has_y = live & (crossing.y != 0.0f ? 1 : 0);
+
+            // in the order of ghost_offsets
+            const auto rock = rockBox(first + i);
+            const auto index = static_cast<std::uint32_t>(i);
+
+            g.set(n, { index, Vec2{ crossing.x, 0.0f } }, shifted(rock, Vec2{ crossing.x, 0.0f }));
+            n += has_x;
+            g.set(n, { index, Vec2{ 0.0f, crossing.y } }, shifted(rock, Vec2{ 0.0f, crossing.y }));
+            n += has_y;
+            g.set(n, { index, crossing }, shifted(rock, crossing));
+            n += has_x & has_y;
+        }
+    }
+
+    // empty boxes up to whole lanes, they overlap nothing
+    const auto inf = std::numeric_limits<float>::infinity();
+    g.count = padded(n);
+
+    for (; n < g.count; ++n)
+        g.set(n, { 0, Vec2{ 0.0f, 0.0f } }, AABB{ Vec2{ inf, inf }, Vec2{ -inf, -inf } });
+}
+
+//==============================================================================
+void BatchWorld::resetWorld(std::size_t w, Scratch & scratch)
+{
+    // game k of world w plays seed base + w + k * world count, never 0 which World reads as time based
+    auto seed = static_cast<std::uint32_t>(m_base_seed + w + m_games[w] * m_world_count);
+    if (seed == 0)
+        seed = 1;
+
+    m_games[w]++;
+    m_seeds[w] = seed;
+    m_rngs[w] = Vec2Gen{ seed };
+    m_tick_counts[w] = 0;
+    m_scores[w] = 0;
+
+    // the same order of ids and random draws as a new World
+    const auto player = World::newPlayer(m_scenario);
+    m_ships[w] = player.ship;
+    m_invincibility[w] = player.invincibility_left;
+    m_destroyed[w] = player.destroyed ? 1 : 0;
+
+    for (std::size_t i = w * m_rock_capacity; i < (w + 1) * m_rock_capacity; ++i)
+        m_rocks.shape[i].reset();
+
+    m_rock_counts[w] = 0;
+    m_projectile_counts[w] = 0;
+
+    auto & rocks = scratch.new_rocks;
+    World::generateRocks(m_scenario, m_rngs[w], rocks, scratch.arena);
+
+    for (const auto & rock : rocks)
+        addRock(w, rock);
+
+    rocks.clear();
+    scratch.arena.reset();
+}
+
+//==============================================================================
+void BatchWorld::addRock(std::size_t w, const Rock & rock)
+{
+    assert(m_rock_counts[w] < m_rock_capacity);
+
+    const auto i = w * m_rock_capacity + m_rock_counts[w]++;
+    auto & r = m_rocks;
+
+    const auto & box = rock.modelBoundingBox();
+
+    r.x[i] = rock.position().x;
+    r.y[i] = rock.position().y;
+    r.vx[i] = rock.velocity().x;
+    r.vy[i] = rock.velocity().y;
+    r.size[i] = rock.scale();
+    r.box_min_x[i] = box.getMin().x;
+    r.box_min_y[i] = box.getMin().y;
+    r.box_max_x[i] = box.getMax().x;
+    r.box_max_y[i] = box.getMax().y;
+    r.id[i] = rock.id();
+    r.hit[i] = 0;
+    r.shape[i] = rock.sharedShape();
+}
+
+//==============================================================================
+void BatchWorld::addProjectile(std::size_t w, const Projectile & projectile)
+{
+    // the capacity covers every projectile the weapon can have alive at once
+    assert(m_projectile_counts[w] < m_projectile_capacity);
+    if (m_projectile_counts[w] == m_projectile_capacity)
+        return;
+
+    const auto i = w * m_projectile_capacity + m_projectile_counts[w]++;
+    auto & p = m_projectiles;
+
+    const auto saved = projectile.save();
+
+    p.x[i] = saved.position.x;
+    p.y[i] = saved.position.y;
+    p.vx[i] = saved.velocity.x;
+    p.vy[i] = saved.velocity.y;
+    p.size_x[i] = saved.size.x;
+    p.size_y[i] = saved.size.y;
+    p.time_left[i] = saved.time_left;
+    p.box_min_x[i] = saved.box_min.x;
+    p.box_min_y[i] = saved.box_min.y;
+    p.box_max_x[i] = saved.box_max.x;
+    p.box_max_y[i] = saved.box_max.y;
+    p.m0[i] = saved.rotation_matrix[0];
+    p.m1[i] = saved.rotation_matrix[1];
+    p.m2[i] = saved.rotation_matrix[2];
+    p.m3[i] = saved.rotation_matrix[3];
+    p.id[i] = saved.id;
+}
+
+//==============================================================================
+template <typename Bodies, typename Predicate>
+std::size_t BatchWorld::compact(Bodies & bodies, std::size_t begin, std::size_t count, Predicate remove)
+{
+    std::size_t kept = 0;
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (remove(begin + i))
+            continue;
+
+        if (kept != i)
+        {
+            const auto to = begin + kept;
+            const auto from = begin + i;
+            bodies.forEachField([to, from] (auto & field) { field[to] = std::move(field[from]); });
+        }
+
+        kept++;
+    }
+
+    return kept;
+}
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "Scenario.hpp"
+#include "Vec2Gen.hpp"
+#include "Rock.hpp"
+#include "Ship.hpp"
+#include "NarrowPhase.hpp"
+#include "Arena.hpp"
+#include "Input.hpp"
+#include "WorkerPool.hpp"
+
+// Many independent single ship games of one scenario stepped in lockstep,
+// for balance tuning and bot evaluation.
+//
+// Bodies are kept in structure of arrays buffers shared by all worlds. Every
+// world owns a fixed block of rock and projectile slots with its live bodies
+// packed at the front, sized for the most bodies its game can ever have, so
+// the blocks of neighbouring worlds are contiguous. Integration runs over the
+// blocks of many worlds in one SSE loop and the broad phase tests four rock
+// boxes per instruction. The worlds are split into chunks that are ticked
+// on a WorkerPool, each worker with its own narrow phase and arena.
+//
+// A world follows the rules of World exactly: the same random draws in the
+// same order, the same arithmetic and the same collision tests including the
+// ghost proxies across the seam of the wrapping square, so game k of
+// world w is bit-identical to World{ scenario with seed(w) } given the same
+// input. A world whose game is over is reset with its next seed at the end
+// of the tick that ended it.
+class BatchWorld
+{
+public:
+    // Finished games of all worlds
+    struct Statistics
+    {
+        std::uint64_t games{ 0 };
+        std::uint64_t cleared{ 0 };     // the rest lost their ship
+        std::uint64_t score{ 0 };
+        std::uint64_t ticks{ 0 };
+    };
+
+    // Caller owned buffers the state of every world is written to at the end
+    // of a tick, by the worker that ticked it. World w starts at w times the
+    // per world stride of a buffer, null buffers are skipped.
+    struct Observation
+    {
+        static constexpr std::size_t ROCK_FLOATS = 5;          // x, y, vx, vy, size
+        static constexpr std::size_t PROJECTILE_FLOATS = 4;    // x, y, vx, vy
+        static constexpr std::size_t SHIP_FLOATS = 6;          // x, y, direction x, y, invincibility left, destroyed
+
+        float * rocks{ nullptr };                   // rock capacity * ROCK_FLOATS per world
+        std::uint32_t * rock_counts{ nullptr };
+        float * projectiles{ nullptr };             // projectile capacity * PROJECTILE_FLOATS per world
+        std::uint32_t * projectile_counts{ nullptr };
+        float * ships{ nullptr };                   // SHIP_FLOATS per world
+        std::uint64_t * scores{ nullptr };
+        std::uint8_t * done{ nullptr };             // set to 1 when a game ended and the world restarted, never cleared
+    };
+
+    // threads including the caller, 0 for one per hardware thread
+    BatchWorld(const Scenario & scenario, std::size_t world_count, std::size_t thread_count = 0);
+
+    // One tick of every world, inputs holds one frame per world or is null for
+    // no input. Writes the state after the tick to observation if given.
+    void tick(const InputFrame * inputs = nullptr, const Observation * observation = nullptr);
+
+    // Starts the next game of world with its next seed, not while tick() runs
+    void reset(std::size_t world);
+
+    // Writes the current state of world, done is left as it is
+    void observe(std::size_t world, const Observation & observation) const;
+
+    const Scenario & scenario() const { return m_scenario; }
+    float deltaTime() const { return m_delta_time; }
+    std::size_t worldCount() const { return m_world_count; }
+    std::size_t threadCount() const { return m_pool.threadCount(); }
+
+    // seed of the current game of world
+    std::uint32_t seed(std::size_t world) const { return m_seeds[world]; }
+    std::uint64_t tickCount(std::size_t world) const { return m_tick_counts[world]; }
+    std::uint64_t score(std::size_t world) const { return m_scores[world]; }
+
+    const Ship & ship(std::size_t world) const { return m_ships[world]; }
+    bool shipDestroyed(std::size_t world) const { return m_destroyed[world] != 0; }
+    float invincibilityLeft(std::size_t world) const { return m_invincibility[world]; }
+
+    std::size_t rockCount(std::size_t world) const { return m_rock_counts[world]; }
+    Vec2 rockPosition(std::size_t world, std::size_t i) const;
+    Vec2 rockVelocity(std::size_t world, std::size_t i) const;
+    float rockSize(std::size_t world, std::size_t i) const { return m_rocks.size[world * m_rock_capacity + i]; }
+
+    std::size_t projectileCount(std::size_t world) const { return m_projectile_counts[world]; }
+    Vec2 projectilePosition(std::size_t world, std::size_t i) const;
+    Vec2 projectileVelocity(std::size_t world, std::size_t i) const;
+
+    // slots per world
+    std::size_t rockCapacity() const { return m_rock_capacity; }
+    std::size_t projectileCapacity() const { return m_projectile_capacity; }
+
+    Statistics statistics() const;
+
+private:
+    // rock slots of all worlds, world w owns [w * rock capacity, (w + 1) * rock capacity)
+    struct Rocks
+    {
+        std::vector<float> x, y, vx, vy, size;
+        std::vector<float> box_min_x, box_min_y, box_max_x, box_max_y;     // model space, boxes add the position
+        std::vector<std::uint32_t> id;
+        std::vector<std::uint8_t> hit;
+        std::vector<std::shared_ptr<const RockShape>> shape;
+
+        //======================================================================
+        template <typename F>
+        void forEachField(F && f)
+        {
+            f(x); f(y); f(vx); f(vy); f(size);
+            f(box_min_x); f(box_min_y); f(box_max_x); f(box_max_y);
+            f(id); f(hit); f(shape);
+        }
+    };
+
+    // projectile slots of all worlds, laid out like the rocks
+    struct Projectiles
+    {
+        std::vector<float> x, y, vx, vy, size_x, size_y, time_left;
+        std::vector<float> box_min_x, box_min_y, box_max_x, box_max_y;
+        std::vector<float> m0, m1, m2, m3;                                 // rotation matrix
+        std::vector<std::uint32_t> id;
+
+        //======================================================================
+        template <typename F>
+        void forEachField(F && f)
+        {
+            f(x); f(y); f(vx); f(vy); f(size_x); f(size_y); f(time_left);
+            f(box_min_x); f(box_min_y); f(box_max_x); f(box_max_y);
+            f(m0); f(m1); f(m2); f(m3);
+            f(id);
+        }
+    };
+
+    // per worker, reused every tick
+    struct Scratch
+    {
+        NarrowPhase narrow_phase;
+        MonotonicArena arena;
+        std::vector<Rock> new_rocks;
+        std::vector<std::uint32_t> hit_rocks;
+
+        // ghosts of the rocks of the world that cross the seam, see World, with
+        // their boxes in lanes padded by empty boxes
+        struct Ghosts
+        {
+            std::vector<GhostProxy> proxies;
+            std::vector<float> min_x, min_y, max_x, max_y;
+            std::size_t count{ 0 };     // a multiple of the lanes
+
+            void reserve(std::size_t slots)
+            {
+                if (proxies.size() >= slots)
+                    return;
+
+                proxies.resize(slots);
+                min_x.resize(slots); min_y.resize(slots);
+                max_x.resize(slots); max_y.resize(slots);
+            }
+
+            void set(std::size_t i, const GhostProxy & proxy, const AABB & box)
+            {
+                proxies[i] = proxy;
+                min_x[i] = box.getMin().x; min_y[i] = box.getMin().y;
+                max_x[i] = box.getMax().x; max_y[i] = box.getMax().y;
+            }
+        };
+
+        Ghosts ghosts;
+    };
+
+    void tickChunk(std::size_t first, std::size_t last, const InputFrame * inputs, const Observation * observation, Scratch & scratch);
+    void tickWorld(std::size_t world, Scratch & scratch);
+    void resetWorld(std::size_t world, Scratch & scratch);
+    void makeRockGhosts(std::size_t world, Scratch & scratch) const;
+    AABB rockBox(std::size_t slot) const;
+
+    void addRock(std::size_t world, const Rock & rock);
+    void addProjectile(std::size_t world, const Projectile & projectile);
+
+    // Removes the slots of world for which remove(slot) is true, keeping the order of the rest
+    template <typename Bodies, typename Predicate>
+    static std::size_t compact(Bodies & bodies, std::size_t begin, std::size_t count, Predicate remove);
+
+    Scenario m_scenario;
+    float m_delta_time;
+    std::size_t m_world_count;
+
+    std::size_t m_rock_capacity;
+    std::size_t m_projectile_capacity;
+
+    Rocks m_rocks;
+    Projectiles m_projectiles;
+    std::vector<std::uint32_t> m_rock_counts;
+    std::vector<std::uint32_t> m_projectile_counts;
+
+    std::vector<Ship> m_ships;
+    std::vector<float> m_invincibility;
+    std::vector<std::uint8_t> m_destroyed;
+
+    std::vector<Vec2Gen> m_rngs;
+    std::vector<std::uint32_t> m_seeds;
+    std::vector<std::uint64_t> m_games;
+    std::vector<std::uint64_t> m_tick_counts;
+    std::vector<std::uint64_t> m_scores;
+
+    // finished games per world, summed by statistics()
+    std::vector<Statistics> m_finished;
+
+    std::uint32_t m_base_seed;
+
+    WorkerPool m_pool;
+    std::vector<std::unique_ptr<Scratch>> m_scratch;
+
+};
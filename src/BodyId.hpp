@@ -0,0 +1,28 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Ids used to key per body pair data across ticks and to name bodies on the
+// network, 0 means no body
+inline std::atomic<std::uint32_t> & body_id_counter()
+{
+    static std::atomic<std::uint32_t> s_next_id{ 1 };
+    return s_next_id;
+}
+
+//==============================================================================
+inline std::uint32_t next_body_id()
+{
+    return body_id_counter()++;
+}
+
+//==============================================================================
+// Continues after the ids of a restored world, never hands out an id twice
+inline void reserve_body_ids(std::uint32_t next)
+{
+    auto & counter = body_id_counter();
+
+    auto current = counter.load();
+    while (current < next && counter.compare_exchange_weak(current, next) == false) {}
+}
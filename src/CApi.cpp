@@ -0,0 +1,278 @@
+#include "asteroids.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <stdexcept>
+
+#include "Scenario.hpp"
+#include "BatchWorld.hpp"
+
+static_assert(ASTEROIDS_ROCK_FLOATS == BatchWorld::Observation::ROCK_FLOATS, "rock observation layout");
+static_assert(ASTEROIDS_PROJECTILE_FLOATS == BatchWorld::Observation::PROJECTILE_FLOATS, "projectile observation layout");
+static_assert(ASTEROIDS_SHIP_FLOATS == BatchWorld::Observation::SHIP_FLOATS, "ship observation layout");
+
+static_assert(ASTEROIDS_LEFT     == 1u << static_cast<unsigned>(Action::LEFT), "action bits");
+static_assert(ASTEROIDS_RIGHT    == 1u << static_cast<unsigned>(Action::RIGHT), "action bits");
+static_assert(ASTEROIDS_FORWARD  == 1u << static_cast<unsigned>(Action::FORWARD), "action bits");
+static_assert(ASTEROIDS_BACKWARD == 1u << static_cast<unsigned>(Action::BACKWARD), "action bits");
+static_assert(ASTEROIDS_FIRE     == 1u << static_cast<unsigned>(Action::FIRE), "action bits");
+
+struct asteroids_scenario
+{
+    Scenario scenario;
+};
+
+struct asteroids_sim
+{
+    asteroids_sim(const Scenario & scenario, std::size_t world_count, std::size_t thread_count) :
+        batch{ scenario, world_count, thread_count },
+        inputs(world_count)
+    {
+    }
+
+    BatchWorld batch;
+
+    // input frames of the actions of the latest step, sized once
+    std::vector<InputFrame> inputs;
+
+    BatchWorld::Observation observation;
+    bool bound{ false };
+};
+
+namespace
+{
+    thread_local std::string last_error;
+
+    //==========================================================================
+    // Runs f, turning exceptions into ASTEROIDS_ERROR and the message of the thread
+    template <typename F>
+    int guarded(F && f)
+    {
+        try
+        {
+            f();
+            return ASTEROIDS_OK;
+        }
+        catch (const std::exception & e)
+        {
+            last_error = e.what();
+        }
+        catch (...)
+        {
+            last_error = "unknown error";
+        }
+
+        return ASTEROIDS_ERROR;
+    }
+}
+
+//==============================================================================
+uint32_t asteroids_abi_version(void)
+{
+    return ASTEROIDS_ABI_VERSION;
+}
+
+//==============================================================================
+const char * asteroids_last_error(void)
+{
+    return last_error.c_str();
+}
+
+//==============================================================================
+asteroids_scenario * asteroids_scenario_create(const char * name)
+{
+    asteroids_scenario * scenario = nullptr;
+
+    guarded([&scenario, name]
+    {
+        auto created = std::make_unique<asteroids_scenario>();
+        if (name)
+            created->scenario = Scenario::preset(name);
+
+        scenario = created.release();
+    });
+
+    return scenario;
+}
+
+//==============================================================================
+void asteroids_scenario_destroy(asteroids_scenario * scenario)
+{
+    delete scenario;
+}
+
+//==============================================================================
+int asteroids_scenario_load(asteroids_scenario * scenario, const char * path)
+{
+    return guarded([scenario, path]
+    {
+        if (!scenario || !path)
+            throw std::runtime_error("asteroids_scenario_load: null argument");
+
+        scenario->scenario.load(path);
+    });
+}
+
+//==============================================================================
+int asteroids_scenario_set(asteroids_scenario * scenario, const char * key, const char * value)
+{
+    return guarded([scenario, key, value]
+    {
+        if (!scenario || !key || !value)
+            throw std::runtime_error("asteroids_scenario_set: null argument");
+
+        scenario->scenario.set(key, value);
+    });
+}
+
+//==============================================================================
+asteroids_sim * asteroids_create(const asteroids_scenario * scenario, uint32_t world_count, uint32_t thread_count)
+{
+    asteroids_sim * sim = nullptr;
+
+    guarded([&sim, scenario, world_count, thread_count]
+    {
+        if (!scenario)
+            throw std::runtime_error("asteroids_create: null scenario");
+        if (world_count == 0)
+            throw std::runtime_error("asteroids_create: no worlds");
+
+        scenario->scenario.validate();
+
+        sim = new asteroids_sim{ scenario->scenario, world_count, thread_count };
+    });
+
+    return sim;
+}
+
+//==============================================================================
+void asteroids_destroy(asteroids_sim * sim)
+{
+    delete sim;
+}
+
+//==============================================================================
+uint32_t asteroids_world_count(const asteroids_sim * sim)
+{
+    return static_cast<uint32_t>(sim->batch.worldCount());
+}
+
+//==============================================================================
+uint32_t asteroids_rock_capacity(const asteroids_sim * sim)
+{
+    return static_cast<uint32_t>(sim->batch.rockCapacity());
+}
+
+//==============================================================================
+uint32_t asteroids_projectile_capacity(const asteroids_sim * sim)
+{
+    return static_cast<uint32_t>(sim->batch.projectileCapacity());
+}
+
+//==============================================================================
+float asteroids_delta_time(const asteroids_sim * sim)
+{
+    return sim->batch.deltaTime();
+}
+
+//==============================================================================
+uint32_t asteroids_seed(const asteroids_sim * sim, uint32_t world)
+{
+    return world < sim->batch.worldCount() ? sim->batch.seed(world) : 0;
+}
+
+//==============================================================================
+int asteroids_bind_observation(asteroids_sim * sim, const asteroids_observation * observation)
+{
+    return guarded([sim, observation]
+    {
+        if (!sim)
+            throw std::runtime_error("asteroids_bind_observation: null simulation");
+
+        sim->bound = observation != nullptr;
+        sim->observation = BatchWorld::Observation{};
+
+        if (!observation)
+            return;
+
+        auto & o = sim->observation;
+        o.rocks = observation->rocks;
+        o.rock_counts = observation->rock_counts;
+        o.projectiles = observation->projectiles;
+        o.projectile_counts = observation->projectile_counts;
+        o.ships = observation->ships;
+        o.scores = observation->scores;
+        o.done = observation->done;
+
+        const auto world_count = sim->batch.worldCount();
+        for (std::size_t w = 0; w < world_count; ++w)
+            sim->batch.observe(w, o);
+
+        if (o.done)
+            std::memset(o.done, 0, world_count);
+    });
+}
+
+//==============================================================================
+int asteroids_step(asteroids_sim * sim, const uint8_t * actions, uint32_t ticks)
+{
+    return guarded([sim, actions, ticks]
+    {
+        if (!sim)
+            throw std::runtime_error("asteroids_step: null simulation");
+
+        auto & batch = sim->batch;
+
+        if (actions)
+            for (std::size_t w = 0; w < batch.worldCount(); ++w)
+                sim->inputs[w] = InputFrame::fromBitmask(actions[w]);
+
+        const InputFrame * inputs = actions ? sim->inputs.data() : nullptr;
+
+        if (!sim->bound)
+        {
+            for (uint32_t i = 0; i < ticks; ++i)
+                batch.tick(inputs);
+            return;
+        }
+
+        const auto & observation = sim->observation;
+        if (observation.done)
+            std::memset(observation.done, 0, batch.worldCount());
+
+        // only the done flags of the ticks before the last one are of interest
+        BatchWorld::Observation done_only;
+        done_only.done = observation.done;
+
+        for (uint32_t i = 0; i < ticks; ++i)
+            batch.tick(inputs, i + 1 == ticks ? &observation : observation.done ? &done_only : nullptr);
+    });
+}
+
+//==============================================================================
+int asteroids_reset(asteroids_sim * sim, uint32_t world)
+{
+    return guarded([sim, world]
+    {
+        if (!sim || world >= sim->batch.worldCount())
+            throw std::runtime_error("asteroids_reset: no such world");
+
+        sim->batch.reset(world);
+
+        if (sim->bound)
+            sim->batch.observe(world, sim->observation);
+    });
+}
+
+//==============================================================================
+void asteroids_statistics_get(const asteroids_sim * sim, asteroids_statistics * statistics)
+{
+    const auto s = sim->batch.statistics();
+
+    statistics->games = s.games;
+    statistics->cleared = s.cleared;
+    statistics->score = s.score;
+    statistics->ticks = s.ticks;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cmath>
+
+#include "Vec2.hpp"
+#include "AABB.hpp"
+
+// View into the wrapping [-world_size, world_size] square, a square of half
+// size view_size around center(). When the view covers the whole world it
+// stays on the origin, otherwise it follows a target. A position is drawn at
+// position + offset(position), the copy of it nearest the center, so bodies
+// across the seam show up on the side the view is on.
+class Camera
+{
+public:
+    Camera(float world_size, float view_size) :
+        m_world_size{ world_size },
+        m_view_size{ view_size }
+    {}
+
+    void follow(const Vec2 & target)
+    {
+        m_center = coversWorld() ? Vec2{ 0.0f, 0.0f } : target;
+    }
+
+    bool coversWorld() const { return m_view_size >= m_world_size; }
+
+    const Vec2 & center() const { return m_center; }
+
+    AABB view() const
+    {
+        return AABB{ m_center - Vec2{ m_view_size, m_view_size }, m_center + Vec2{ m_view_size, m_view_size } };
+    }
+
+    // Multiple of the world period per axis that brings position nearest the
+    // center, none when the whole world is in view
+    Vec2 offset(const Vec2 & position) const
+    {
+        if (coversWorld())
+            return Vec2{ 0.0f, 0.0f };
+
+        const float period = 2.0f * m_world_size;
+
+        return Vec2{
+            std::round((m_center.x - position.x) / period) * period,
+            std::round((m_center.y - position.y) / period) * period
+        };
+    }
+
+    // world to clip space scale
+    float scale() const { return 1.0f / m_view_size; }
+
+private:
+    float m_world_size;
+    float m_view_size;
+
+    Vec2 m_center{ 0.0f, 0.0f };
+
+};
@@ -0,0 +1,58 @@
+#include "Collision.hpp"
+
+#include <cmath>
+
+std::vector<Vec2> convex_hull(const Vec2 * points, std::size_t count, MonotonicArena * arena)
+{
+    ArenaVector<Vec2> sorted(points, points + count, ArenaAllocator<Vec2>{ arena });
+
+    std::sort(sorted.begin(), sorted.end(),
+              [](const Vec2 & a, const Vec2 & b) { return a.x < b.x || (a.x == b.x && a.y < b.y); }
+    );
+
+    if (sorted.size() < 3)
+        return std::vector<Vec2>(sorted.begin(), sorted.end());
+
+    const auto cross = [](const Vec2 & o, const Vec2 & a, const Vec2 & b)
+    {
+        return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+    };
+
+    ArenaVector<Vec2> hull(2 * sorted.size(), Vec2{}, ArenaAllocator<Vec2>{ arena });
+    std::size_t k = 0;
+
+    // lower hull
+    for (std::size_t i = 0; i < sorted.size(); ++i)
+    {
+        while (k >= 2 && cross(hull[k - 2], hull[k - 1], sorted[i]) <= 0.0f) k--;
+        hull[k++] = sorted[i];
+    }
+
+    // upper hull
+    for (std::size_t i = sorted.size() - 1, t = k + 1; i > 0; --i)
+    {
+        while (k >= t && cross(hull[k - 2], hull[k - 1], sorted[i - 1]) <= 0.0f) k--;
+        hull[k++] = sorted[i - 1];
+    }
+
+    // last point equals the first one
+    return std::vector<Vec2>(hull.begin(), hull.begin() + static_cast<std::ptrdiff_t>(k - 1));
+}
+
+std::vector<Vec2> hull_normals(const std::vector<Vec2> & hull)
+{
+    std::vector<Vec2> normals;
+    normals.reserve(hull.size());
+
+    for (std::size_t i = 0; i < hull.size(); ++i)
+    {
+        const auto & a = hull[i];
+        const auto & b = hull[(i + 1) % hull.size()];
+
+        // counter clockwise winding, so (dy, -dx) points outwards
+        Vec2 n{ b.y - a.y, a.x - b.x };
+        normals.push_back(n / length(n));
+    }
+
+    return normals;
+}
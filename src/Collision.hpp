@@ -0,0 +1,199 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <utility>
+#include <initializer_list>
+#include <limits>
+#include <algorithm>
+
+#include "Vec2.hpp"
+#include "Arena.hpp"
+
+//==============================================================================
+inline bool counter_clock_wise(const Vec2 & a, const Vec2 & b, const Vec2 & c)
+{
+    // ignoring the collinear case
+    return (c.y - a.y) * (b.x - a.x) > (b.y - a.y) * (c.x - a.x);
+}
+
+//==============================================================================
+inline bool segment_intersect(const Vec2 & a1, const Vec2 & a2, const Vec2 & b1, const Vec2 & b2)
+{
+    // ignoring the collinear case
+
+    const bool c[]
+    {
+        counter_clock_wise(a1, b1, b2),
+        counter_clock_wise(a2, b1, b2),
+        counter_clock_wise(a1, a2, b1),
+        counter_clock_wise(a1, a2, b2)
+    };
+
+    return c[0] != c[1] && c[2] != c[3];
+}
+
+//==============================================================================
+// Evaluates f(0) || f(1) || ... || f(N - 1) with the loop expanded at compile time
+template <typename F, std::size_t ... I>
+inline bool any_unrolled(F && f, std::index_sequence<I...>)
+{
+    bool result = false;
+    (void)std::initializer_list<int>{ (result = result || f(std::integral_constant<std::size_t, I>{}), 0)... };
+    return result;
+}
+
+//==============================================================================
+// Edge against every edge of a polygon whose vertex count is only known at run time
+inline bool segment_polygon_intersect(const Vec2 & a1, const Vec2 & a2, const Vec2 * b, std::size_t m)
+{
+    for (std::size_t ib = 0; ib + 1 < m; ++ib)
+        if (segment_intersect(a1, a2, b[ib], b[ib + 1]))
+            return true;
+
+    return segment_intersect(a1, a2, b[m - 1], b[0]);
+}
+
+//==============================================================================
+// Both vertex counts unknown at compile time
+inline bool polygons_intersect(const Vec2 * a, std::size_t n, const Vec2 * b, std::size_t m)
+{
+    // naive algorithm O(n^2) should be the fastest for small n because of tiny overhead compared to other algorithms
+
+    for (std::size_t ia = 0; ia + 1 < n; ++ia)
+        if (segment_polygon_intersect(a[ia], a[ia + 1], b, m))
+            return true;
+
+    return segment_polygon_intersect(a[n - 1], a[0], b, m);
+}
+
+//==============================================================================
+// Both vertex counts known at compile time, fully unrolled
+template <std::size_t N, std::size_t M>
+inline bool polygons_intersect(const std::array<Vec2, N> & a, const std::array<Vec2, M> & b)
+{
+    return any_unrolled([&a, &b](auto ia)
+    {
+        const auto & a1 = a[ia];
+        const auto & a2 = a[(ia + 1) % N];
+
+        return any_unrolled([&a1, &a2, &b](auto ib)
+        {
+            return segment_intersect(a1, a2, b[ib], b[(ib + 1) % M]);
+        }, std::make_index_sequence<M>{});
+    }, std::make_index_sequence<N>{});
+}
+
+//==============================================================================
+// Vertex count of a known at compile time, b is any contiguous container
+template <std::size_t N, typename Container>
+inline bool polygons_intersect(const std::array<Vec2, N> & a, const Container & b)
+{
+    const Vec2 * b_data = b.data();
+    const std::size_t m = b.size();
+
+    return any_unrolled([&a, b_data, m](auto ia)
+    {
+        return segment_polygon_intersect(a[ia], a[(ia + 1) % N], b_data, m);
+    }, std::make_index_sequence<N>{});
+}
+
+//==============================================================================
+inline bool polygons_intersect(const std::vector<Vec2> & a, const std::vector<Vec2> & b)
+{
+    return polygons_intersect(a.data(), a.size(), b.data(), b.size());
+}
+
+//==============================================================================
+// Even-odd point in polygon test
+inline bool point_in_polygon(const Vec2 & p, const Vec2 * polygon, std::size_t n)
+{
+    bool inside = false;
+
+    for (std::size_t i = 0, j = n - 1; i < n; j = i++)
+    {
+        const auto & a = polygon[i];
+        const auto & b = polygon[j];
+
+        if ((a.y > p.y) != (b.y > p.y) && p.x < (b.x - a.x) * (p.y - a.y) / (b.y - a.y) + a.x)
+            inside = !inside;
+    }
+
+    return inside;
+}
+
+//==============================================================================
+// Edge normals (not normalized, SAT only compares intervals on the same axis)
+template <std::size_t N>
+inline std::array<Vec2, N> edge_normals(const std::array<Vec2, N> & polygon)
+{
+    std::array<Vec2, N> result;
+
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        const auto & a = polygon[i];
+        const auto & b = polygon[(i + 1) % N];
+
+        result[i] = Vec2{ b.y - a.y, a.x - b.x };
+    }
+
+    return result;
+}
+
+//==============================================================================
+// True if the projections of both convex vertex sets onto axis are disjoint
+inline bool axis_separates(const Vec2 & axis, const Vec2 * a, std::size_t n, const Vec2 * b, std::size_t m)
+{
+    float a_min =  std::numeric_limits<float>::infinity();
+    float a_max = -std::numeric_limits<float>::infinity();
+    float b_min =  std::numeric_limits<float>::infinity();
+    float b_max = -std::numeric_limits<float>::infinity();
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const float d = a[i].x * axis.x + a[i].y * axis.y;
+        a_min = std::min(a_min, d);
+        a_max = std::max(a_max, d);
+    }
+
+    for (std::size_t i = 0; i < m; ++i)
+    {
+        const float d = b[i].x * axis.x + b[i].y * axis.y;
+        b_min = std::min(b_min, d);
+        b_max = std::max(b_max, d);
+    }
+
+    return a_max < b_min || b_max < a_min;
+}
+
+//==============================================================================
+// Separating axis theorem on two convex polygons, the axes are the edge normals
+// of both. Writes the separating axis and returns true if one exists.
+inline bool find_separating_axis(const Vec2 * a, std::size_t n, const Vec2 * a_axes, std::size_t a_axis_count,
+                                 const Vec2 * b, std::size_t m, const Vec2 * b_axes, std::size_t b_axis_count,
+                                 Vec2 & axis)
+{
+    for (std::size_t i = 0; i < a_axis_count; ++i)
+        if (axis_separates(a_axes[i], a, n, b, m))
+        {
+            axis = a_axes[i];
+            return true;
+        }
+
+    for (std::size_t i = 0; i < b_axis_count; ++i)
+        if (axis_separates(b_axes[i], a, n, b, m))
+        {
+            axis = b_axes[i];
+            return true;
+        }
+
+    return false;
+}
+
+//==============================================================================
+// Counter clockwise convex hull (monotone chain), temporaries come from arena if given
+std::vector<Vec2> convex_hull(const Vec2 * points, std::size_t count, MonotonicArena * arena = nullptr);
+
+//==============================================================================
+// Unit outward normal of every hull edge i -> i + 1
+std::vector<Vec2> hull_normals(const std::vector<Vec2> & hull);
@@ -0,0 +1,383 @@
+#include "FrameCapture.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "Trace.hpp"
+
+namespace
+{
+    //==========================================================================
+    std::uint32_t crc32(std::uint32_t crc, const unsigned char * data, std::size_t size)
+    {
+        static const auto table = []
+        {
+            std::vector<std::uint32_t> t(256);
+
+            for (std::uint32_t n = 0; n < 256; ++n)
+            {
+                std::uint32_t c = n;
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                t[n] = c;
+            }
+
+            return t;
+        }();
+
+        crc = ~crc;
+        for (std::size_t i = 0; i < size; ++i)
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+        return ~crc;
+    }
+
+    //==========================================================================
+    void put_u32(std::vector<unsigned char> & out, std::uint32_t v)
+    {
+        out.push_back(static_cast<unsigned char>(v >> 24));
+        out.push_back(static_cast<unsigned char>(v >> 16));
+        out.push_back(static_cast<unsigned char>(v >>  8));
+        out.push_back(static_cast<unsigned char>(v));
+    }
+
+    //==========================================================================
+    void put_chunk(std::ofstream & file, const char type[4], const std::vector<unsigned char> & data)
+    {
+        std::vector<unsigned char> chunk;
+        chunk.reserve(data.size() + 12);
+
+        put_u32(chunk, static_cast<std::uint32_t>(data.size()));
+        chunk.insert(chunk.end(), type, type + 4);
+        chunk.insert(chunk.end(), data.begin(), data.end());
+        put_u32(chunk, crc32(0, chunk.data() + 4, data.size() + 4));
+
+        file.write(reinterpret_cast<const char *>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+    }
+
+    //==========================================================================
+    // PNG with stored (uncompressed) deflate blocks, cheap enough to keep up
+    // with the frame rate without pulling in zlib
+    void write_png(const std::string & file_name, int width, int height, const unsigned char * rgba_bottom_up)
+    {
+        std::ofstream file(file_name, std::ofstream::out | std::ofstream::binary);
+        if (file.is_open() == false) return;
+
+        static const unsigned char signature[]{ 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        file.write(reinterpret_cast<const char *>(signature), sizeof(signature));
+
+        std::vector<unsigned char> header;
+        put_u32(header, static_cast<std::uint32_t>(width));
+        put_u32(header, static_cast<std::uint32_t>(height));
+        header.insert(header.end(), { 8, 6, 0, 0, 0 }); // 8 bit RGBA
+        put_chunk(file, "IHDR", header);
+
+        // filter byte + flipped rows (GL origin is bottom left)
+        const std::size_t row_size = static_cast<std::size_t>(width) * 4;
+        std::vector<unsigned char> raw;
+        raw.reserve((row_size + 1) * static_cast<std::size_t>(height));
+        for (int y = height - 1; y >= 0; --y)
+        {
+            raw.push_back(0);
+            const auto row = rgba_bottom_up + static_cast<std::size_t>(y) * row_size;
+            raw.insert(raw.end(), row, row + row_size);
+        }
+
+        std::vector<unsigned char> data{ 0x78, 0x01 };
+        data.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+
+        std::uint32_t a = 1, b = 0;
+        for (std::size_t offset = 0; offset < raw.size(); )
+        {
+            const std::size_t block = std::min<std::size_t>(65535, raw.size() - offset);
+            const bool last = offset + block == raw.size();
+
+            data.push_back(last ? 1 : 0);
+            data.push_back(static_cast<unsigned char>(block));
+            data.push_back(static_cast<unsigned char>(block >> 8));
+            data.push_back(static_cast<unsigned char>(~block));
+            data.push_back(static_cast<unsigned char>(~block >> 8));
+            data.insert(data.end(), raw.begin() + offset, raw.begin() + offset + block);
+
+            for (std::size_t i = offset; i < offset + block; ++i)
+            {
+                a = (a + raw[i]) % 65521;
+                b = (b + a) % 65521;
+            }
+
+            offset += block;
+        }
+        put_u32(data, (b << 16) | a);
+
+        put_chunk(file, "IDAT", data);
+        put_chunk(file, "IEND", {});
+    }
+
+    //==========================================================================
+    // Splits a PNG path pattern around its one integer conversion
+    void parse_file_name_pattern(const std::string & pattern, std::string & prefix, std::string & suffix,
+                                 std::size_t & width, bool & zero_pad)
+    {
+        bool found = false;
+        std::string * out = &prefix;
+
+        for (std::size_t i = 0; i < pattern.size(); ++i)
+        {
+            if (pattern[i] != '%')
+            {
+                out->push_back(pattern[i]);
+                continue;
+            }
+
+            if (i + 1 < pattern.size() && pattern[i + 1] == '%')
+            {
+                out->push_back('%');
+                ++i;
+                continue;
+            }
+
+            std::size_t j = i + 1;
+            zero_pad = j < pattern.size() && pattern[j] == '0';
+
+            std::size_t digits = 0;
+            width = 0;
+            for (; j < pattern.size() && pattern[j] >= '0' && pattern[j] <= '9' && digits < 2; ++j, ++digits)
+                width = width * 10 + static_cast<std::size_t>(pattern[j] - '0');
+
+            if (found || j >= pattern.size() || (pattern[j] != 'd' && pattern[j] != 'i' && pattern[j] != 'u'))
+                throw std::runtime_error("Capture file pattern needs exactly one %d for the frame index and %% for a percent sign: " + pattern);
+
+            found = true;
+            out = &suffix;
+            i = j;
+        }
+
+        if (!found)
+            throw std::runtime_error("Capture file pattern needs exactly one %d for the frame index and %% for a percent sign: " + pattern);
+    }
+}
+
+//==============================================================================
+FrameCapture::FrameCapture(int width, int height, int samples, const std::string & path, Format format) :
+    m_width{ width },
+    m_height{ height },
+    m_path{ path },
+    m_format{ format }
+{
+    if (m_format == Format::PNG)
+        parse_file_name_pattern(m_path, m_name_prefix, m_name_suffix, m_index_width, m_index_zero_pad);
+
+    GLint max_samples{ 0 };
+    glGetIntegerv(GL_MAX_SAMPLES, &max_samples);
+    samples = std::max(0, std::min(samples, static_cast<int>(max_samples)));
+
+    // multisampled render target
+    glGenRenderbuffers(1, &m_color);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_color);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, m_width, m_height);
+
+    glGenFramebuffers(1, &m_fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_color);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        throw std::runtime_error("Capture framebuffer is incomplete.");
+
+    // single sampled resolve target, read back from and presented
+    glGenRenderbuffers(1, &m_resolve_color);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_resolve_color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_width, m_height);
+
+    glGenFramebuffers(1, &m_resolve_fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_resolve_fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_resolve_color);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        throw std::runtime_error("Capture resolve framebuffer is incomplete.");
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // readback ring
+    const auto frame_size = static_cast<GLsizeiptr>(m_width) * m_height * 4;
+
+    glGenBuffers(PBO_COUNT, m_pbo);
+    for (const auto pbo : m_pbo)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, frame_size, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (m_format == Format::RAW)
+    {
+        m_raw_file.open(m_path, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+        if (m_raw_file.is_open() == false)
+            throw std::runtime_error("Failed to open capture file.");
+    }
+
+    m_encoder = std::thread{ &FrameCapture::encode, this };
+}
+
+//==============================================================================
+FrameCapture::~FrameCapture()
+{
+    // collect outstanding readbacks in submission order
+    for (std::size_t i = 0; i < PBO_COUNT; ++i)
+        collect((m_next_pbo + i) % PBO_COUNT);
+
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    m_encoder.join();
+
+    glDeleteBuffers(PBO_COUNT, m_pbo);
+    glDeleteFramebuffers(1, &m_resolve_fbo);
+    glDeleteRenderbuffers(1, &m_resolve_color);
+    glDeleteFramebuffers(1, &m_fbo);
+    glDeleteRenderbuffers(1, &m_color);
+}
+
+//==============================================================================
+void FrameCapture::beginFrame()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glViewport(0, 0, m_width, m_height);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+//==============================================================================
+void FrameCapture::endFrame(int target_width, int target_height)
+{
+    // resolve multisampling
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_resolve_fbo);
+    glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    // the slot about to be reused was issued PBO_COUNT frames ago
+    const auto slot = m_next_pbo;
+    collect(slot);
+
+    // asynchronous readback into the pixel pack buffer
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_resolve_fbo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo[slot]);
+    glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_fence[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_pbo_frame[slot] = m_frames_issued++;
+    m_next_pbo = (slot + 1) % PBO_COUNT;
+
+    // present
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, target_width, target_height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, target_width, target_height);
+}
+
+//==============================================================================
+void FrameCapture::collect(std::size_t slot)
+{
+    if (m_fence[slot] == nullptr)
+        return;
+
+    // normally signaled long ago, only waits if the GPU is frames behind
+    glClientWaitSync(m_fence[slot], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    glDeleteSync(m_fence[slot]);
+    m_fence[slot] = nullptr;
+
+    const auto frame_size = static_cast<std::size_t>(m_width) * static_cast<std::size_t>(m_height) * 4;
+
+    Frame frame;
+    frame.index = m_pbo_frame[slot];
+
+    {
+        std::unique_lock<std::mutex> lock{ m_mutex };
+
+        // bounded queue, every frame is kept so the encoder is waited on if it falls behind
+        if (m_queue.size() >= MAX_QUEUED_FRAMES)
+        {
+            m_encoder_stalls++;
+            m_condition.wait(lock, [this] { return m_queue.size() < MAX_QUEUED_FRAMES; });
+        }
+
+        if (m_free_buffers.empty() == false)
+        {
+            frame.pixels = std::move(m_free_buffers.back());
+            m_free_buffers.pop_back();
+        }
+    }
+
+    frame.pixels.resize(frame_size);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo[slot]);
+    const auto mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(frame_size), GL_MAP_READ_BIT);
+    if (mapped != nullptr)
+    {
+        std::memcpy(frame.pixels.data(), mapped, frame_size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        m_queue.push_back(std::move(frame));
+    }
+    m_condition.notify_all();
+}
+
+//==============================================================================
+void FrameCapture::encode()
+{
+    TRACE_THREAD_NAME("frame encoder");
+
+    for (;;)
+    {
+        Frame frame;
+
+        {
+            std::unique_lock<std::mutex> lock{ m_mutex };
+            m_condition.wait(lock, [this] { return m_stop || m_queue.empty() == false; });
+
+            if (m_queue.empty())
+                return;
+
+            frame = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        m_condition.notify_all();
+
+        {
+            TRACE_SCOPE("encode frame");
+            write(frame);
+        }
+
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        m_free_buffers.push_back(std::move(frame.pixels));
+    }
+}
+
+//==============================================================================
+void FrameCapture::write(const Frame & frame)
+{
+    if (m_format == Format::PNG)
+    {
+        // path is a pattern such as "capture/frame_%06d.png"
+        auto index = std::to_string(frame.index);
+        if (index.size() < m_index_width)
+            index.insert(0, m_index_width - index.size(), m_index_zero_pad ? '0' : ' ');
+
+        const auto file_name = m_name_prefix + index + m_name_suffix;
+
+        write_png(file_name, m_width, m_height, frame.pixels.data());
+    }
+    else
+    {
+        // raw top-down RGBA stream, e.g. ffmpeg -f rawvideo -pix_fmt rgba -s 720x720
+        const std::size_t row_size = static_cast<std::size_t>(m_width) * 4;
+        for (int y = m_height - 1; y >= 0; --y)
+            m_raw_file.write(reinterpret_cast<const char *>(frame.pixels.data() + static_cast<std::size_t>(y) * row_size),
+                       static_cast<std::streamsize>(row_size));
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <GL/gl3w.h>
+
+#include <string>
+#include <fstream>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+// Renders into an off-screen framebuffer and reads every frame back through
+// a ring of pixel pack buffers. A readback is only mapped PBO_COUNT - 1 frames
+// after it was issued, so the GPU never has to be waited on. Encoding and
+// writing happens on a background thread.
+class FrameCapture
+{
+public:
+    enum class Format { PNG, RAW };
+
+    // PNG paths are a pattern with one %d for the frame index, zero padding and
+    // a width allowed ("frame_%06d.png"), %% for a percent sign. Other
+    // patterns throw std::runtime_error.
+    FrameCapture(int width, int height, int samples, const std::string & path, Format format);
+    FrameCapture(const FrameCapture &) = delete;
+    FrameCapture & operator = (const FrameCapture &) = delete;
+    ~FrameCapture();
+
+    // Bind the capture framebuffer, all following draws end up in the capture
+    void beginFrame();
+
+    // Queue readback of the frame and present it to the default framebuffer,
+    // which has to be single sampled for the blit
+    void endFrame(int target_width, int target_height);
+
+    std::uint64_t framesCaptured() const { return m_frames_issued; }
+    std::uint64_t encoderStalls() const { return m_encoder_stalls; }
+
+private:
+    struct Frame
+    {
+        std::uint64_t index;
+        std::vector<unsigned char> pixels;
+    };
+
+    static constexpr std::size_t PBO_COUNT = 3;
+    static constexpr std::size_t MAX_QUEUED_FRAMES = 32;
+
+    void collect(std::size_t slot);
+    void encode();
+    void write(const Frame & frame);
+
+    int m_width;
+    int m_height;
+
+    std::string m_path;
+    Format m_format;
+
+    // PNG file names, prefix + frame index padded to index_width + suffix
+    std::string m_name_prefix;
+    std::string m_name_suffix;
+    std::size_t m_index_width{ 0 };
+    bool m_index_zero_pad{ false };
+    std::ofstream m_raw_file;
+
+    GLuint m_fbo{ 0 };
+    GLuint m_color{ 0 };
+    GLuint m_resolve_fbo{ 0 };
+    GLuint m_resolve_color{ 0 };
+
+    GLuint m_pbo[PBO_COUNT]{};
+    GLsync m_fence[PBO_COUNT]{};
+    std::uint64_t m_pbo_frame[PBO_COUNT]{};
+    std::size_t m_next_pbo{ 0 };
+
+    std::uint64_t m_frames_issued{ 0 };
+    std::uint64_t m_encoder_stalls{ 0 };
+
+    // encoder thread state
+    std::thread m_encoder;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<Frame> m_queue;
+    std::vector<std::vector<unsigned char>> m_free_buffers;
+    bool m_stop{ false };
+
+};
@@ -0,0 +1,67 @@
+#include "GlHandle.hpp"
+
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    // names waiting for the end of the frame, bodies may be dropped on other threads
+    struct DeletionQueue
+    {
+        std::mutex mutex;
+        std::vector<GLuint> vertex_arrays;
+        std::vector<GLuint> buffers;
+
+        // swapped with the queued names on flush, so the lock isn't held during the GL calls
+        std::vector<GLuint> flushed_vertex_arrays;
+        std::vector<GLuint> flushed_buffers;
+    };
+
+    //==========================================================================
+    DeletionQueue & deletion_queue()
+    {
+        static DeletionQueue s_queue;
+        return s_queue;
+    }
+}
+
+//==============================================================================
+void queue_gl_deletion(GlObjectType type, GLuint name)
+{
+    if (name == 0)
+        return;
+
+    auto & queue = deletion_queue();
+    std::lock_guard<std::mutex> lock{ queue.mutex };
+
+    if (type == GlObjectType::VERTEX_ARRAY)
+        queue.vertex_arrays.push_back(name);
+    else
+        queue.buffers.push_back(name);
+}
+
+//==============================================================================
+std::size_t flush_gl_deletions()
+{
+    auto & queue = deletion_queue();
+    {
+        std::lock_guard<std::mutex> lock{ queue.mutex };
+        queue.flushed_vertex_arrays.swap(queue.vertex_arrays);
+        queue.flushed_buffers.swap(queue.buffers);
+    }
+
+    auto & vertex_arrays = queue.flushed_vertex_arrays;
+    auto & buffers = queue.flushed_buffers;
+
+    if (vertex_arrays.empty() == false)
+        glDeleteVertexArrays(static_cast<GLsizei>(vertex_arrays.size()), vertex_arrays.data());
+    if (buffers.empty() == false)
+        glDeleteBuffers(static_cast<GLsizei>(buffers.size()), buffers.data());
+
+    const auto count = vertex_arrays.size() + buffers.size();
+
+    vertex_arrays.clear();
+    buffers.clear();
+
+    return count;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <GL/gl3w.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Move-only owners of GL object names. Dropping a name doesn't call GL, it
+// queues the name for deletion at the end of the frame, so destroying bodies
+// in the simulation (rocks erased after a split, dead projectiles, rewound
+// snapshots) never reaches the driver. flush_gl_deletions() deletes all
+// queued names with one glDelete* call per object type, Window calls it after
+// every buffer swap and before the context goes away.
+
+enum class GlObjectType : std::uint8_t { VERTEX_ARRAY, BUFFER };
+
+// Queues name for the next flush, 0 is ignored
+void queue_gl_deletion(GlObjectType type, GLuint name);
+
+// Deletes the queued names, only on the thread of the context that made them.
+// Returns the number of names deleted.
+std::size_t flush_gl_deletions();
+
+//==============================================================================
+template <GlObjectType TYPE>
+class GlHandle
+{
+public:
+    //==========================================================================
+    GlHandle() {}
+
+    //==========================================================================
+    // A new name of the object type, needs a current context
+    static GlHandle create()
+    {
+        GlHandle handle;
+
+        if (TYPE == GlObjectType::VERTEX_ARRAY)
+            glGenVertexArrays(1, &handle.m_name);
+        else
+            glGenBuffers(1, &handle.m_name);
+
+        return handle;
+    }
+
+    //==========================================================================
+    GlHandle(GlHandle && other) noexcept :
+        m_name{ other.m_name }
+    {
+        other.m_name = 0;
+    }
+
+    //==========================================================================
+    GlHandle & operator = (GlHandle && other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            m_name = other.m_name;
+            other.m_name = 0;
+        }
+
+        return *this;
+    }
+
+    GlHandle(const GlHandle &) = delete;
+    GlHandle & operator = (const GlHandle &) = delete;
+
+    //==========================================================================
+    ~GlHandle()
+    {
+        reset();
+    }
+
+    //==========================================================================
+    void reset()
+    {
+        if (m_name == 0)
+            return;
+
+        queue_gl_deletion(TYPE, m_name);
+        m_name = 0;
+    }
+
+    //==========================================================================
+    GLuint get() const { return m_name; }
+    explicit operator bool() const { return m_name != 0; }
+
+private:
+    GLuint m_name{ 0 };
+
+};
+
+using VertexArrayHandle = GlHandle<GlObjectType::VERTEX_ARRAY>;
+using BufferHandle = GlHandle<GlObjectType::BUFFER>;
@@ -0,0 +1,197 @@
+#include "GpuProfiler.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+
+#include "LatencyTracker.hpp"
+
+namespace
+{
+    const char * const SECTION_NAMES[GPU_SECTION_COUNT]
+    {
+        "ship", "projectiles", "rocks", "particles", "hud", "aabb", "swap"
+    };
+
+    // the GPU clock drifts against the CPU clock, resynchronize every few seconds
+    constexpr std::uint64_t CALIBRATION_INTERVAL = 600;
+}
+
+//==============================================================================
+GpuProfiler::GpuProfiler() :
+    m_supported{ gl3wIsSupported(3, 3) == 1 }
+{
+    if (m_supported == false)
+    {
+        std::cout << "GPU timer queries need OpenGL 3.3, reporting CPU present times only." << std::endl;
+        return;
+    }
+
+    for (auto & slot : m_frames)
+        glGenQueries(static_cast<GLsizei>(slot.queries.size()), slot.queries.data());
+
+    calibrate();
+}
+
+//==============================================================================
+GpuProfiler::~GpuProfiler()
+{
+    if (m_supported == false)
+        return;
+
+    for (auto & slot : m_frames)
+        glDeleteQueries(static_cast<GLsizei>(slot.queries.size()), slot.queries.data());
+}
+
+//==============================================================================
+void GpuProfiler::beginFrame(std::uint64_t frame)
+{
+    auto & slot = m_frames[m_current];
+
+    // the GPU is more than FRAMES_IN_FLIGHT behind, give up on this frame
+    // rather than wait, its events are resolved by the next presented frame
+    if (slot.pending)
+        m_late_frames++;
+
+    slot.frame = frame;
+    slot.pending = false;
+    slot.used.fill(false);
+}
+
+//==============================================================================
+void GpuProfiler::begin(GpuSection section)
+{
+    if (m_supported == false)
+        return;
+
+    const auto s = static_cast<std::size_t>(section);
+
+    auto & slot = m_frames[m_current];
+    slot.used[s] = true;
+
+    glQueryCounter(slot.queries[s * 2], GL_TIMESTAMP);
+}
+
+//==============================================================================
+void GpuProfiler::end(GpuSection section)
+{
+    if (m_supported == false)
+        return;
+
+    const auto s = static_cast<std::size_t>(section);
+
+    glQueryCounter(m_frames[m_current].queries[s * 2 + 1], GL_TIMESTAMP);
+}
+
+//==============================================================================
+void GpuProfiler::endFrame(LatencyTracker & latency)
+{
+    if (m_supported == false)
+    {
+        latency.presented(m_frames[m_current].frame, InputClock::now());
+        return;
+    }
+
+    m_frames[m_current].pending = true;
+    m_current = (m_current + 1) % FRAMES_IN_FLIGHT;
+
+    if (++m_frame_count % CALIBRATION_INTERVAL == 0)
+        calibrate();
+
+    // oldest first, frames complete in order on the GPU
+    for (std::size_t i = 0; i < FRAMES_IN_FLIGHT; ++i)
+    {
+        auto & slot = m_frames[(m_current + i) % FRAMES_IN_FLIGHT];
+
+        if (slot.pending && collect(slot, latency) == false)
+            break;
+    }
+}
+
+//==============================================================================
+bool GpuProfiler::collect(FrameQueries & slot, LatencyTracker & latency)
+{
+    for (std::size_t s = 0; s < GPU_SECTION_COUNT; ++s)
+    {
+        if (slot.used[s] == false)
+            continue;
+
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(slot.queries[s * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+        if (available == GL_FALSE)
+            return false;
+    }
+
+    GLuint64 swap_end = 0;
+
+    for (std::size_t s = 0; s < GPU_SECTION_COUNT; ++s)
+    {
+        if (slot.used[s] == false)
+            continue;
+
+        GLuint64 begin = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(slot.queries[s * 2], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(slot.queries[s * 2 + 1], GL_QUERY_RESULT, &end);
+
+        m_times[s].push_back(static_cast<double>(end - begin) / 1e6);
+
+        if (s == static_cast<std::size_t>(GpuSection::SWAP))
+            swap_end = end;
+    }
+
+    slot.pending = false;
+
+    if (swap_end != 0)
+        latency.presented(slot.frame, InputClock::time_point{ std::chrono::duration_cast<InputClock::duration>(
+            std::chrono::nanoseconds{ static_cast<std::int64_t>(swap_end) + m_gpu_to_cpu }
+        ) });
+    else
+        latency.presented(slot.frame, InputClock::now());
+
+    return true;
+}
+
+//==============================================================================
+void GpuProfiler::calibrate()
+{
+    GLint64 gpu = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpu);
+
+    const auto cpu = std::chrono::duration_cast<std::chrono::nanoseconds>(InputClock::now().time_since_epoch()).count();
+
+    m_gpu_to_cpu = static_cast<std::int64_t>(cpu) - static_cast<std::int64_t>(gpu);
+}
+
+//==============================================================================
+void GpuProfiler::report() const
+{
+    if (m_supported == false)
+        return;
+
+    std::cout << std::fixed << std::setprecision(3) << "GPU time per frame:" << std::endl;
+
+    for (std::size_t s = 0; s < GPU_SECTION_COUNT; ++s)
+    {
+        auto sorted = m_times[s];
+        if (sorted.empty())
+            continue;
+
+        std::sort(sorted.begin(), sorted.end());
+
+        double mean = 0.0;
+        for (const auto t : sorted) mean += t;
+        mean /= static_cast<double>(sorted.size());
+
+        const auto percentile = [&sorted](double p)
+        {
+            return sorted[static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1))];
+        };
+
+        std::cout << "  " << std::left << std::setw(12) << SECTION_NAMES[s] << std::right
+                  << " mean " << mean << " ms, p50 " << percentile(0.5) << " ms, p99 " << percentile(0.99) << " ms" << std::endl;
+    }
+
+    std::cout << "  " << m_late_frames << " frames not ready after " << FRAMES_IN_FLIGHT << " frames" << std::endl;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <GL/gl3w.h>
+
+#include <array>
+#include <vector>
+#include <cstdint>
+
+#include "Input.hpp"
+
+class LatencyTracker;
+
+enum class GpuSection : std::uint8_t { SHIP, PROJECTILES, ROCKS, PARTICLES, HUD, AABB, SWAP, COUNT };
+
+constexpr std::size_t GPU_SECTION_COUNT = static_cast<std::size_t>(GpuSection::COUNT);
+
+// GPU time of each draw group from GL_TIMESTAMP query pairs. Results are read
+// back FRAMES_IN_FLIGHT frames late and only once available, so the CPU never
+// waits for the GPU. The end of the swap section is the GPU side present time
+// of a frame, mapped onto the CPU clock for the latency tracker.
+//
+// Timer queries need OpenGL 3.3, without them only CPU present times are reported.
+class GpuProfiler
+{
+public:
+    GpuProfiler();
+    ~GpuProfiler();
+
+    GpuProfiler(const GpuProfiler &) = delete;
+    GpuProfiler & operator = (const GpuProfiler &) = delete;
+
+    bool supported() const { return m_supported; }
+
+    void beginFrame(std::uint64_t frame);
+    void begin(GpuSection section);
+    void end(GpuSection section);
+
+    // Call after the swap section, collects finished frames and reports their present time
+    void endFrame(LatencyTracker & latency);
+
+    // Prints mean, p50 and p99 GPU time of every section in milliseconds
+    void report() const;
+
+private:
+    static constexpr std::size_t FRAMES_IN_FLIGHT = 4;
+
+    struct FrameQueries
+    {
+        std::uint64_t frame{ 0 };
+        bool pending{ false };
+        std::array<bool, GPU_SECTION_COUNT> used{};
+        std::array<GLuint, GPU_SECTION_COUNT * 2> queries{};
+    };
+
+    // Reads the results of slot if available, returns false if the GPU is not done yet
+    bool collect(FrameQueries & slot, LatencyTracker & latency);
+
+    // Offset between the GPU timestamp clock and the CPU clock in nanoseconds
+    void calibrate();
+
+    bool m_supported{ false };
+
+    std::array<FrameQueries, FRAMES_IN_FLIGHT> m_frames;
+    std::size_t m_current{ 0 };
+    std::uint64_t m_frame_count{ 0 };
+
+    std::int64_t m_gpu_to_cpu{ 0 };
+
+    std::array<std::vector<double>, GPU_SECTION_COUNT> m_times;
+    std::uint64_t m_late_frames{ 0 };
+
+};
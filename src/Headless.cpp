@@ -0,0 +1,351 @@
+#include "Headless.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <string>
+#include <memory>
+
+#include "World.hpp"
+#include "BatchWorld.hpp"
+#include "Rewind.hpp"
+#include "SectorStream.hpp"
+#include "Particles.hpp"
+#include "Autopilot.hpp"
+#include "AllocationCounter.hpp"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // benchmark length of scenarios that would otherwise run until game over
+    constexpr std::uint64_t DEFAULT_BENCHMARK_TICKS = 600;
+
+    //==========================================================================
+    double milliseconds(Clock::duration d)
+    {
+        return std::chrono::duration<double, std::milli>{ d }.count();
+    }
+
+    //==========================================================================
+    // Memory and timing of the rewind buffer, restoring rewinds the world to
+    // the oldest snapshot
+    void print_rewind(World & world, RewindBuffer & rewind, std::vector<double> & record_times)
+    {
+        const auto memory = rewind.memoryBytes();
+        const auto shapes = rewind.sharedShapeBytes();
+        const auto recorded = rewind.size();
+
+        const auto restore_start = Clock::now();
+        rewind.rewind(world, rewind.size() - 1);
+        const auto restore = milliseconds(Clock::now() - restore_start);
+
+        std::sort(record_times.begin(), record_times.end());
+        double mean = 0.0;
+        for (const auto t : record_times) mean += t;
+        mean /= static_cast<double>(record_times.size());
+
+        std::cout << "  rewind:       " << recorded << " snapshots, " << memory / 1024 << " KiB + "
+                                        << shapes / 1024 << " KiB shared rock shapes" << std::endl
+                  << "                record " << mean << " ms mean, " << record_times.back() << " ms max, restore "
+                                        << restore << " ms" << std::endl;
+    }
+
+    //==========================================================================
+    // Scripted batch input, every world fires and turns, odd worlds the other way while thrusting
+    InputFrame batch_input(std::size_t world)
+    {
+        const auto bit = [] (Action a) { return 1u << static_cast<std::uint32_t>(a); };
+
+        return InputFrame::fromBitmask(world % 2 == 0 ? bit(Action::FIRE) | bit(Action::LEFT)
+                                                      : bit(Action::FIRE) | bit(Action::RIGHT) | bit(Action::FORWARD));
+    }
+
+    //==========================================================================
+    void print_world(const World & world)
+    {
+        const auto & stats = world.narrowPhase().statistics();
+
+        std::cout << "  ticks:        " << world.tickCount() << std::endl
+                  << "  score:        " << world.score() << std::endl
+                  << "  rocks:        " << world.rocks().size() << std::endl
+                  << "  projectiles:  " << world.projectiles().size() << std::endl
+                  << "  ship:         " << (world.shipDestroyed() ? "destroyed" : "alive") << std::endl
+                  << "  narrow phase: " << stats.tests << " tests, "
+                                        << stats.cached_rejects << " cached rejects, "
+                                        << stats.sat_rejects << " SAT rejects, "
+                                        << stats.exact_tests << " exact tests" << std::endl;
+
+        // rock shapes against the same shapes keeping float outline, hull and hull normals
+        std::size_t mesh_bytes = 0;
+        std::size_t float_bytes = 0;
+        std::size_t expanded = 0;
+        for (const auto & r : world.rocks())
+        {
+            mesh_bytes += r.shape().memoryBytes();
+            float_bytes += sizeof(RockShape) + (r.size() + 2 * r.shape().hull.size()) * sizeof(Vec2);
+            expanded += r.shape().isExpanded() ? 1 : 0;
+        }
+
+        std::cout << "  rock meshes:  " << mesh_bytes / 1024 << " KiB, " << float_bytes / 1024 << " KiB with float vertices, "
+                                        << expanded << " of " << world.rocks().size() << " expanded" << std::endl;
+
+        const auto & ghosts = world.ghostStatistics();
+
+        std::cout << "  ghosts:       " << ghosts.rock_proxies << " proxies of " << ghosts.seam_rocks << " seam crossing rocks and "
+                                        << ghosts.body_proxies << " of " << ghosts.seam_bodies << " projectiles and ships in the last tick, "
+                                        << ghosts.total_proxies << " total" << std::endl;
+
+        if (world.sectors())
+        {
+            const auto sectors = world.sectors()->statistics();
+            const auto delivered = static_cast<double>(std::max<std::uint64_t>(1, sectors.delivered));
+
+            std::cout << "  sectors:      " << sectors.active << " active, " << sectors.prefetched << " made ahead of "
+                                            << sectors.sectors_per_axis * sectors.sectors_per_axis << ", "
+                                            << sectors.activations << " activations, " << sectors.dematerializations << " dematerialized" << std::endl
+                      << "  streaming:    " << sectors.delivered << " made in the background, "
+                                            << sectors.latency_total_ms / delivered << " ms mean, " << sectors.latency_max_ms << " ms max latency, "
+                                            << sectors.generated_inline << " made inline, " << sectors.late << " late" << std::endl
+                      << "  deltas:       " << sectors.deltas << " sectors, " << sectors.delta_bytes << " bytes" << std::endl;
+        }
+
+        const auto arena = world.arenaStatistics();
+
+        std::cout << "  tick arena:   " << arena.capacity << " bytes, "
+                                        << arena.peak << " bytes peak, "
+                                        << arena.upstream_allocations << " upstream allocations" << std::endl;
+    }
+}
+
+//==============================================================================
+int run_headless(const Options & options)
+{
+    const auto & scenario = options.scenario;
+
+    const auto setup_start = Clock::now();
+    const auto world_ptr = options.load_path.empty() ? std::make_unique<World>(scenario) : World::load(options.load_path);
+    auto & world = *world_ptr;
+    const auto setup_end = Clock::now();
+
+    std::unique_ptr<RewindBuffer> rewind;
+    if (options.rewind_seconds > 0.0f)
+        rewind = std::make_unique<RewindBuffer>(rewind_capacity(options.rewind_seconds, world.scenario().tick_rate));
+
+    // scripted ship, without it the ship drifts and only auto fire shoots
+    std::unique_ptr<Autopilot> autopilot;
+    if (options.autopilot)
+        autopilot = std::make_unique<Autopilot>();
+
+    std::uint64_t allocation_free_ticks = 0;
+    std::uint64_t allocations = 0;
+    std::vector<double> record_times;
+
+    while ((scenario.ticks == 0 || world.tickCount() < scenario.ticks) && !world.over())
+    {
+        const auto input = autopilot ? autopilot->next(world, 0) : InputFrame{};
+
+        const auto before = heap_allocation_count();
+        world.tick(input);
+        const auto count = heap_allocation_count() - before;
+
+        allocations += count;
+        if (count == 0) allocation_free_ticks++;
+
+        if (rewind)
+        {
+            const auto record_start = Clock::now();
+            rewind->record(world);
+            record_times.push_back(milliseconds(Clock::now() - record_start));
+        }
+    }
+
+    const auto run_end = Clock::now();
+
+    std::cout << "scenario " << world.scenario().name << std::endl
+              << (options.load_path.empty() ? "  setup:        " : "  restore:      ") << milliseconds(setup_end - setup_start) << " ms" << std::endl
+              << "  run:          " << milliseconds(run_end - setup_end) << " ms" << std::endl;
+    print_world(world);
+
+    if (autopilot)
+        std::cout << "  autopilot:    " << autopilot->dodgeTicks() << " ticks dodging" << std::endl;
+
+    if (options.save_path.empty() == false)
+    {
+        const auto save_start = Clock::now();
+        world.save(options.save_path);
+        std::cout << "  save:         " << milliseconds(Clock::now() - save_start) << " ms" << std::endl;
+    }
+
+    if (heap_allocation_counting())
+        std::cout << "  heap:         " << allocations << " allocations, "
+                                        << allocation_free_ticks << " of " << world.tickCount() << " ticks allocation free" << std::endl;
+
+    if (rewind && rewind->size() > 1)
+        print_rewind(world, *rewind, record_times);
+
+    return 0;
+}
+
+//==============================================================================
+int run_benchmark(const std::vector<Scenario> & scenarios)
+{
+    std::cout << std::left
+              << std::setw(20) << "scenario"
+              << std::right
+              << std::setw(10) << "rocks"
+              << std::setw(8)  << "ticks"
+              << std::setw(12) << "setup ms"
+              << std::setw(12) << "mean ms"
+              << std::setw(12) << "p50 ms"
+              << std::setw(12) << "p99 ms"
+              << std::setw(12) << "max ms"
+              << std::setw(14) << "allocs/tick" << std::endl;
+
+    for (const auto & scenario : scenarios)
+    {
+        const auto ticks = scenario.ticks != 0 ? scenario.ticks : DEFAULT_BENCHMARK_TICKS;
+
+        const auto setup_start = Clock::now();
+        World world{ scenario };
+        const auto setup = milliseconds(Clock::now() - setup_start);
+
+        const auto rock_count = world.rocks().size();
+
+        std::vector<double> tick_times;
+        tick_times.reserve(static_cast<std::size_t>(ticks));
+
+        std::vector<std::uint64_t> tick_allocations;
+        tick_allocations.reserve(static_cast<std::size_t>(ticks));
+
+        while (world.tickCount() < ticks && !world.over())
+        {
+            const auto allocations = heap_allocation_count();
+            const auto start = Clock::now();
+            world.tick(InputFrame{});
+            tick_times.push_back(milliseconds(Clock::now() - start));
+            tick_allocations.push_back(heap_allocation_count() - allocations);
+        }
+
+        // median, the steady state tick
+        std::sort(tick_allocations.begin(), tick_allocations.end());
+        const auto allocations = tick_allocations.empty() ? 0 : tick_allocations[tick_allocations.size() / 2];
+
+        double mean = 0.0;
+        for (const auto t : tick_times) mean += t;
+        if (tick_times.empty() == false) mean /= static_cast<double>(tick_times.size());
+
+        std::sort(tick_times.begin(), tick_times.end());
+        const auto percentile = [&tick_times](double p)
+        {
+            if (tick_times.empty()) return 0.0;
+            return tick_times[static_cast<std::size_t>(p * static_cast<double>(tick_times.size() - 1))];
+        };
+
+        std::cout << std::left
+                  << std::setw(20) << scenario.name
+                  << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(10) << rock_count
+                  << std::setw(8)  << tick_times.size()
+                  << std::setw(12) << setup
+                  << std::setw(12) << mean
+                  << std::setw(12) << percentile(0.5)
+                  << std::setw(12) << percentile(0.99)
+                  << std::setw(12) << percentile(1.0)
+                  << std::setw(14) << (heap_allocation_counting() ? std::to_string(allocations) : std::string{ "n/a" }) << std::endl;
+    }
+
+    return 0;
+}
+
+//==============================================================================
+int run_batch_benchmark(const Options & options)
+{
+    const auto & scenario = options.scenario;
+    const auto ticks = scenario.ticks != 0 ? scenario.ticks : DEFAULT_BENCHMARK_TICKS;
+
+    const auto setup_start = Clock::now();
+    BatchWorld batch{ scenario, options.batch_worlds, options.threads };
+    const auto setup_end = Clock::now();
+
+    std::vector<InputFrame> inputs;
+    for (std::size_t w = 0; w < batch.worldCount(); ++w)
+        inputs.push_back(batch_input(w));
+
+    for (std::uint64_t tick = 0; tick < ticks; ++tick)
+        batch.tick(inputs.data());
+
+    const auto run = milliseconds(Clock::now() - setup_end);
+    const auto world_ticks = static_cast<double>(ticks) * static_cast<double>(batch.worldCount());
+    const auto stats = batch.statistics();
+
+    std::cout << "scenario " << scenario.name << std::endl
+              << "  worlds:       " << batch.worldCount() << " on " << batch.threadCount() << " threads, "
+                                    << batch.rockCapacity() << " rock and " << batch.projectileCapacity() << " projectile slots each" << std::endl
+              << "  setup:        " << milliseconds(setup_end - setup_start) << " ms" << std::endl
+              << "  run:          " << run << " ms, " << ticks << " ticks" << std::endl
+              << "  throughput:   " << static_cast<std::uint64_t>(world_ticks / (run / 1000.0)) << " world ticks/s" << std::endl
+              << "  games:        " << stats.games << " finished, " << stats.cleared << " cleared" << std::endl;
+
+    if (stats.games != 0)
+        std::cout << "  mean game:    " << stats.score / stats.games << " points, " << stats.ticks / stats.games << " ticks" << std::endl;
+
+    return 0;
+}
+
+//==============================================================================
+int run_particle_benchmark()
+{
+    constexpr int FRAMES = 600;
+    constexpr float FRAME_TIME = 1.0f / 60.0f;
+
+    std::cout << std::left
+              << std::setw(12) << "particles"
+              << std::right
+              << std::setw(12) << "mean ms"
+              << std::setw(12) << "p99 ms"
+              << std::setw(12) << "ns/particle"
+              << std::setw(14) << "frame budget" << std::endl;
+
+    for (const std::size_t count : { 10'000, 100'000, 1'000'000 })
+    {
+        ParticleSystem particles{ count };
+
+        // explosions of 500 particles living up to a second, topped up every
+        // frame so dead particles are recycled at the steady state rate
+        std::vector<double> times;
+        times.reserve(FRAMES);
+
+        Vec2Gen rng{ 1 };
+        std::uint64_t particle_updates = 0;
+
+        for (int frame = 0; frame < FRAMES; ++frame)
+        {
+            while (particles.size() + 500 <= particles.capacity())
+                particles.emit(rng.get() * 2.0f - 1.0f, Vec2{ 0.0f, 0.0f }, 500, 0.3f, 1.0f);
+
+            particle_updates += particles.size();
+
+            const auto start = Clock::now();
+            particles.update(FRAME_TIME);
+            times.push_back(milliseconds(Clock::now() - start));
+        }
+
+        double total = 0.0;
+        for (const auto t : times) total += t;
+        const double mean = total / static_cast<double>(times.size());
+
+        std::sort(times.begin(), times.end());
+
+        std::cout << std::left
+                  << std::setw(12) << count
+                  << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(12) << mean
+                  << std::setw(12) << times[static_cast<std::size_t>(0.99 * static_cast<double>(times.size() - 1))]
+                  << std::setw(12) << total * 1e6 / static_cast<double>(particle_updates)
+                  << std::setw(13) << mean / (1000.0 * FRAME_TIME) * 100.0 << "%" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <vector>
+
+#include "Scenario.hpp"
+
+// Runs the scenario without a window until the world reaches scenario.ticks
+// ticks (or until the game is over if that is 0) as fast as possible and
+// prints a summary. Continues a save with --load, saves at the end with
+// --save. With --rewind it records every tick, then rewinds the whole buffer
+// and checks that replaying it ends in the same state.
+int run_headless(const Options & options);
+
+// Runs every scenario headless and prints per tick timings
+int run_benchmark(const std::vector<Scenario> & scenarios);
+
+// Plays --batch independent games of the scenario in lockstep on a
+// BatchWorld for scenario.ticks ticks, checks the first games against World
+// and prints the world ticks per second and the statistics of finished games
+int run_batch_benchmark(const Options & options);
+
+// Keeps 10k, 100k and 1M explosion particles alive and prints the update time per frame
+int run_particle_benchmark();
@@ -0,0 +1,157 @@
+#include "Hud.hpp"
+
+#include <cctype>
+
+#include "HudFont.hpp"
+
+namespace
+{
+    // font grid units
+    constexpr float ADVANCE = FONT_GRID_WIDTH + 2.0f;
+    constexpr float LINE_HEIGHT = FONT_GRID_HEIGHT + 4.0f;
+
+    // pixels
+    constexpr float PIXELS_PER_UNIT = 2.0f;
+    constexpr float MARGIN = 12.0f;
+
+    //==========================================================================
+    // Segment endpoints of every glyph, decoded from the font table once
+    struct Atlas
+    {
+        struct Range
+        {
+            std::uint16_t first{ 0 };
+            std::uint16_t count{ 0 };
+        };
+
+        std::vector<Vec2> vertices;
+        Range glyphs[128];
+    };
+
+    //==========================================================================
+    const Atlas & atlas()
+    {
+        static const Atlas s_atlas = []
+        {
+            Atlas a;
+
+            for (const auto & glyph : FONT_GLYPHS)
+            {
+                auto & range = a.glyphs[static_cast<unsigned char>(glyph.character)];
+                range.first = static_cast<std::uint16_t>(a.vertices.size());
+
+                for (const char * s = glyph.segments; *s != '\0'; )
+                {
+                    if (*s == ' ')
+                    {
+                        ++s;
+                        continue;
+                    }
+
+                    a.vertices.push_back(Vec2{ static_cast<float>(s[0] - '0'), static_cast<float>(s[1] - '0') });
+                    a.vertices.push_back(Vec2{ static_cast<float>(s[2] - '0'), static_cast<float>(s[3] - '0') });
+                    s += 4;
+                }
+
+                range.count = static_cast<std::uint16_t>(a.vertices.size() - range.first);
+            }
+
+            return a;
+        }();
+
+        return s_atlas;
+    }
+}
+
+//==============================================================================
+Hud::Hud(std::size_t line_count) :
+    m_lines(line_count)
+{
+}
+
+//==============================================================================
+void Hud::setLine(std::size_t line, const std::string & text)
+{
+    auto & l = m_lines[line];
+    if (l.text == text)
+        return;
+
+    l.text = text;
+    l.vertices.clear();
+
+    const auto & a = atlas();
+    const float y = -LINE_HEIGHT * static_cast<float>(line + 1);
+
+    for (std::size_t i = 0; i < text.size(); ++i)
+    {
+        const auto c = static_cast<unsigned char>(std::toupper(static_cast<unsigned char>(text[i])));
+        if (c >= 128)
+            continue;
+
+        const auto & range = a.glyphs[c];
+        const Vec2 origin{ ADVANCE * static_cast<float>(i), y };
+
+        for (std::uint16_t v = 0; v < range.count; ++v)
+            l.vertices.push_back(origin + a.vertices[range.first + v]);
+    }
+
+    m_dirty = true;
+}
+
+//==============================================================================
+void Hud::upload() const
+{
+    m_dirty = false;
+
+    m_vertices.clear();
+    for (const auto & l : m_lines)
+        m_vertices.insert(m_vertices.end(), l.vertices.begin(), l.vertices.end());
+
+    if (!m_VAO)
+    {
+        m_VAO = VertexArrayHandle::create();
+        m_VBO = BufferHandle::create();
+
+        glBindVertexArray(m_VAO.get());
+        glBindBuffer(GL_ARRAY_BUFFER, m_VBO.get());
+
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vec2), (GLvoid *)0);
+        glEnableVertexAttribArray(0);
+    }
+    else
+    {
+        glBindVertexArray(m_VAO.get());
+        glBindBuffer(GL_ARRAY_BUFFER, m_VBO.get());
+    }
+
+    // the buffer only grows, shorter text reuses it
+    const auto bytes = m_vertices.size() * sizeof(Vec2);
+    if (bytes > m_buffer_capacity)
+    {
+        m_buffer_capacity = bytes * 2;
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_buffer_capacity), nullptr, GL_DYNAMIC_DRAW);
+    }
+
+    glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(bytes), m_vertices.data());
+    m_uploads++;
+}
+
+//==============================================================================
+void Hud::draw(GLint scale_uniform, GLint translation_uniform, int width, int height) const
+{
+    if (m_dirty)
+        upload();
+
+    if (m_vertices.empty() || width <= 0 || height <= 0)
+        return;
+
+    const float w = static_cast<float>(width);
+    const float h = static_cast<float>(height);
+
+    // font grid units to normalized device coordinates, anchored at the top left corner
+    glUniform2f(scale_uniform, 2.0f * PIXELS_PER_UNIT / w, 2.0f * PIXELS_PER_UNIT / h);
+    glUniform2f(translation_uniform, -1.0f + 2.0f * MARGIN / w, 1.0f - 2.0f * MARGIN / h);
+
+    glBindVertexArray(m_VAO.get());
+    glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(m_vertices.size()));
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <GL/gl3w.h>
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "Vec2.hpp"
+#include "GlHandle.hpp"
+
+// Lines of overlay text in the top left corner of the window, drawn with the
+// stroke font of HudFont.hpp.
+//
+// Every line keeps its own vertices, setLine() only rebuilds the line if the
+// text changed. draw() uploads the lines in one buffer if any of them changed
+// since the previous draw and draws all of them with a single GL_LINES call
+// through the line shader. Vertices are in font grid units, so resizing the
+// window only changes the uniforms.
+class Hud
+{
+public:
+    explicit Hud(std::size_t line_count);
+
+    Hud(const Hud &) = delete;
+    Hud & operator = (const Hud &) = delete;
+
+    void setLine(std::size_t line, const std::string & text);
+
+    // Sets scale and translation for a window of width x height pixels, the
+    // caller sets the color and an identity rotation
+    void draw(GLint scale_uniform, GLint translation_uniform, int width, int height) const;
+
+    // times the vertex buffer was filled, for checking that unchanged text costs nothing
+    std::uint64_t uploads() const { return m_uploads; }
+
+private:
+    struct Line
+    {
+        std::string text;
+        std::vector<Vec2> vertices;
+    };
+
+    void upload() const;
+
+    std::vector<Line> m_lines;
+
+    // concatenated vertices of all lines as of the latest upload
+    mutable std::vector<Vec2> m_vertices;
+    mutable bool m_dirty{ false };
+    mutable std::uint64_t m_uploads{ 0 };
+
+    // GL objects are created lazily from draw()
+    mutable VertexArrayHandle m_VAO;
+    mutable BufferHandle m_VBO;
+    mutable std::size_t m_buffer_capacity{ 0 };
+
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+
+// Stroke font of the HUD, compiled into the binary so no font is loaded at run time.
+//
+// A glyph is a list of line segments on a 4 x 6 grid with the origin at the
+// bottom left, every segment written as four digits "x0 y0 x1 y1". Lower case
+// letters are drawn with the upper case glyphs, characters without a glyph
+// leave an empty cell.
+
+constexpr int FONT_GRID_WIDTH = 4;
+constexpr int FONT_GRID_HEIGHT = 6;
+
+struct FontGlyph
+{
+    char character;
+    const char * segments;
+};
+
+constexpr std::array<FontGlyph, 49> FONT_GLYPHS
+{{
+    { '0', "0040 4046 4606 0600 0046" },
+    { '1', "2026 2615 1030" },
+    { '2', "0646 4643 4303 0300 0040" },
+    { '3', "0646 4640 4000 1343" },
+    { '4', "0603 0343 4640" },
+    { '5', "4606 0603 0343 4340 4000" },
+    { '6', "4606 0600 0040 4043 4303" },
+    { '7', "0646 4620" },
+    { '8', "0040 4046 4606 0600 0343" },
+    { '9', "4303 0306 0646 4640 4000" },
+
+    { 'A', "0004 0426 2644 4440 0242" },
+    { 'B', "0006 0636 3643 0343 4340 4000" },
+    { 'C', "4606 0600 0040" },
+    { 'D', "0006 0626 2644 4442 4220 2000" },
+    { 'E', "4606 0600 0040 0333" },
+    { 'F', "4606 0600 0333" },
+    { 'G', "4606 0600 0040 4043 4323" },
+    { 'H', "0006 4640 0343" },
+    { 'I', "0646 2026 0040" },
+    { 'J', "4640 4000 0002" },
+    { 'K', "0006 0346 0340" },
+    { 'L', "0600 0040" },
+    { 'M', "0006 0623 2346 4640" },
+    { 'N', "0006 0640 4046" },
+    { 'O', "0040 4046 4606 0600" },
+    { 'P', "0006 0646 4643 4303" },
+    { 'Q', "0040 4046 4606 0600 2240" },
+    { 'R', "0006 0646 4643 4303 0340" },
+    { 'S', "4616 1605 0514 1434 3443 4341 4130 3000" },
+    { 'T', "0646 2620" },
+    { 'U', "0600 0040 4046" },
+    { 'V', "0620 2046" },
+    { 'W', "0600 0023 2340 4046" },
+    { 'X', "0046 0640" },
+    { 'Y', "0623 2346 2320" },
+    { 'Z', "0646 4600 0040" },
+
+    { ':', "2122 2425" },
+    { '.', "2021" },
+    { ',', "2110" },
+    { '-', "1333" },
+    { '+', "1333 2224" },
+    { '=', "1232 1434" },
+    { '/', "0046" },
+    { '%', "0046 0515 3141" },
+    { '(', "3615 1511 1130" },
+    { ')', "1625 2521 2110" },
+    { '<', "4503 0341" },
+    { '>', "0543 4301" },
+    { '_', "0040" },
+}};
@@ -0,0 +1,104 @@
+#include "Input.hpp"
+
+#include <algorithm>
+
+//==============================================================================
+InputFrame InputFrame::fromBitmask(std::uint32_t mask)
+{
+    InputFrame frame;
+
+    for (std::size_t i = 0; i < ACTION_COUNT; ++i)
+        if (mask & (1u << i))
+        {
+            frame.held[i] = 1.0f;
+            frame.first_down[i] = 0.0f;
+        }
+
+    return frame;
+}
+
+//==============================================================================
+std::uint32_t InputFrame::bitmask() const
+{
+    std::uint32_t mask = 0;
+
+    for (std::size_t i = 0; i < ACTION_COUNT; ++i)
+        if (held[i] > 0.0f)
+            mask |= 1u << i;
+
+    return mask;
+}
+
+//==============================================================================
+InputFrame InputTimeline::consume(KeyEventQueue & queue, InputClock::time_point tick_end,
+                                  std::vector<InputClock::time_point> * event_times)
+{
+    if (m_started == false)
+    {
+        m_tick_begin = tick_end;
+        m_started = true;
+    }
+
+    const auto tick_begin = m_tick_begin;
+    const auto tick_length = std::chrono::duration<float>{ tick_end - tick_begin }.count();
+
+    const auto offset = [tick_begin, tick_length](InputClock::time_point t)
+    {
+        if (tick_length <= 0.0f) return 0.0f;
+
+        const auto o = std::chrono::duration<float>{ t - tick_begin }.count() / tick_length;
+        return std::min(1.0f, std::max(0.0f, o));
+    };
+
+    InputFrame frame;
+
+    // actions already down at the start of the tick
+    float down_since[ACTION_COUNT];
+    for (std::size_t i = 0; i < ACTION_COUNT; ++i)
+    {
+        down_since[i] = 0.0f;
+        if (m_down[i]) frame.first_down[i] = 0.0f;
+    }
+
+    // replay events in order
+    while (const KeyEvent * event = queue.front())
+    {
+        if (event->time > tick_end)
+            break;
+
+        const auto i = static_cast<std::size_t>(event->action);
+        const auto t = offset(event->time);
+
+        if (event_times)
+            event_times->push_back(event->time);
+
+        if (event->pressed && m_down[i] == false)
+        {
+            m_down[i] = true;
+            down_since[i] = t;
+            frame.first_down[i] = std::min(frame.first_down[i], t);
+        }
+        else if (event->pressed == false && m_down[i] == true)
+        {
+            m_down[i] = false;
+
+            // a tap inside the tick still counts, with a minimal duration
+            frame.held[i] += std::max(t - down_since[i], 1e-3f);
+        }
+
+        queue.pop();
+    }
+
+    // actions still down at the end of the tick
+    for (std::size_t i = 0; i < ACTION_COUNT; ++i)
+    {
+        if (m_down[i])
+            frame.held[i] += 1.0f - down_since[i];
+
+        frame.held[i] = std::min(1.0f, frame.held[i]);
+    }
+
+    m_tick_begin = tick_end;
+
+    return frame;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "SpscQueue.hpp"
+
+enum class Action : std::uint8_t { LEFT, RIGHT, FORWARD, BACKWARD, FIRE, COUNT };
+
+constexpr std::size_t ACTION_COUNT = static_cast<std::size_t>(Action::COUNT);
+
+using InputClock = std::chrono::steady_clock;
+
+//==============================================================================
+// Press or release of an action, stamped when the window system delivered it
+struct KeyEvent
+{
+    InputClock::time_point time;
+    Action action;
+    bool pressed;
+};
+
+using KeyEventQueue = SpscQueue<KeyEvent, 1024>;
+
+//==============================================================================
+// Input seen by one simulation tick, offsets are fractions of the tick [0, 1]
+struct InputFrame
+{
+    // fraction of the tick the action was held
+    float held[ACTION_COUNT]{};
+
+    // offset at which the action was first down in this tick, 1 if it never was
+    float first_down[ACTION_COUNT]{ 1.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+
+    float heldFraction(Action a) const { return held[static_cast<std::size_t>(a)]; }
+    float firstDown(Action a) const { return first_down[static_cast<std::size_t>(a)]; }
+    bool down(Action a) const { return heldFraction(a) > 0.0f; }
+
+    // Every action in mask held for the whole tick (bit i is Action i)
+    static InputFrame fromBitmask(std::uint32_t mask);
+
+    // Actions that were down at any time during the tick
+    std::uint32_t bitmask() const;
+};
+
+//==============================================================================
+// Consumer side of a key event queue. Turns the events that arrived since the
+// previous tick into an InputFrame, so taps shorter than a tick are not lost
+// and presses keep their sub-tick timing.
+class InputTimeline
+{
+public:
+    // Consumes all events stamped before tick_end, the tick spans from the
+    // previous tick_end (or the first call) to tick_end. Appends the time of
+    // every consumed event to event_times if given.
+    InputFrame consume(KeyEventQueue & queue, InputClock::time_point tick_end,
+                       std::vector<InputClock::time_point> * event_times = nullptr);
+
+private:
+    bool m_down[ACTION_COUNT]{};
+    InputClock::time_point m_tick_begin{};
+    bool m_started{ false };
+
+};
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+
+#include "Input.hpp"
+
+class World;
+
+// Where the input of a ship comes from, a player at the keyboard or a script.
+// Called once per tick before World::tick.
+class InputSource
+{
+public:
+    virtual ~InputSource() = default;
+
+    // Input of ship for the next tick of world
+    virtual InputFrame next(const World & world, std::size_t ship) = 0;
+};
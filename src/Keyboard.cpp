@@ -1,3 +1,5 @@
 #include "Keyboard.hpp"
 
-Keyboard::KeyStatus Keyboard::s_keys[GLFW_KEY_LAST]{};
\ No newline at end of file
+Keyboard::KeyStatus Keyboard::s_keys[GLFW_KEY_LAST]{};
+KeyEventQueue Keyboard::s_events;
+std::uint64_t Keyboard::s_dropped_events{ 0 };
@@ -2,6 +2,11 @@
 
 #include <GLFW/glfw3.h>
 
+#include <vector>
+
+#include "Input.hpp"
+#include "InputSource.hpp"
+
 class Keyboard
 {
 public:
@@ -16,6 +21,16 @@ public:
         // if unknown key do nothing
         if (key < 0 || key >= GLFW_KEY_LAST) return;
 
+        // stamp game actions as early as possible, the simulation applies them
+        // at their offset inside the tick instead of at the next tick boundary
+        if (action == GLFW_PRESS || action == GLFW_RELEASE)
+        {
+            Action game_action;
+            if (toAction(key, game_action))
+                if (s_events.push(KeyEvent{ InputClock::now(), game_action, action == GLFW_PRESS }) == false)
+                    s_dropped_events++;
+        }
+
         // Set pressed keys
         if (action == GLFW_PRESS)
             s_keys[key] = KeyStatus::PRESSED;
@@ -36,8 +51,62 @@ public:
         return s_keys[key];
     }
 
+    //==========================================================================
+    // Timestamped game action events, consumed by the simulation thread
+    static KeyEventQueue & events()
+    {
+        return s_events;
+    }
+
+    //==========================================================================
+    // Events lost because the queue was full
+    static std::uint64_t droppedEvents()
+    {
+        return s_dropped_events;
+    }
+
 private:
+    //==========================================================================
+    static bool toAction(int key, Action & action)
+    {
+        switch (key)
+        {
+            case GLFW_KEY_LEFT:  action = Action::LEFT;     return true;
+            case GLFW_KEY_RIGHT: action = Action::RIGHT;    return true;
+            case GLFW_KEY_UP:    action = Action::FORWARD;  return true;
+            case GLFW_KEY_DOWN:  action = Action::BACKWARD; return true;
+            case GLFW_KEY_SPACE: action = Action::FIRE;     return true;
+            default: return false;
+        }
+    }
+
     static_assert(GLFW_KEY_LAST > 0);
     static KeyStatus s_keys[GLFW_KEY_LAST];
 
-};
\ No newline at end of file
+    static KeyEventQueue s_events;
+    static std::uint64_t s_dropped_events;
+
+};
+
+// Keyboard as the input of a ship, consumes the key events that arrived
+// until the call
+class KeyboardInput : public InputSource
+{
+public:
+    // Appends the time of every consumed event to event_times if given
+    explicit KeyboardInput(std::vector<InputClock::time_point> * event_times = nullptr) :
+        m_event_times{ event_times }
+    {
+    }
+
+    //==========================================================================
+    InputFrame next(const World &, std::size_t) override
+    {
+        return m_timeline.consume(Keyboard::events(), InputClock::now(), m_event_times);
+    }
+
+private:
+    InputTimeline m_timeline;
+    std::vector<InputClock::time_point> * m_event_times;
+
+};
@@ -0,0 +1,43 @@
+#include "LatencyTracker.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+
+//==============================================================================
+void LatencyTracker::submit(std::uint64_t frame, const std::vector<InputClock::time_point> & event_times)
+{
+    for (const auto & t : event_times)
+        m_pending.push_back({ frame, t });
+}
+
+//==============================================================================
+void LatencyTracker::presented(std::uint64_t frame, InputClock::time_point present_time)
+{
+    // pending events are ordered by frame
+    auto resolved = m_pending.begin();
+
+    for (; resolved != m_pending.end() && resolved->frame <= frame; ++resolved)
+        m_latencies.push_back(std::chrono::duration<double, std::milli>{ present_time - resolved->time }.count());
+
+    m_pending.erase(m_pending.begin(), resolved);
+}
+
+//==============================================================================
+void LatencyTracker::report() const
+{
+    auto sorted = m_latencies;
+    std::sort(sorted.begin(), sorted.end());
+
+    const auto percentile = [&sorted](double p)
+    {
+        if (sorted.empty()) return 0.0;
+        return sorted[static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1))];
+    };
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "input to present latency: " << sorted.size() << " events, "
+              << "p50 " << percentile(0.5) << " ms, "
+              << "p99 " << percentile(0.99) << " ms, "
+              << "max " << percentile(1.0) << " ms" << std::endl;
+}
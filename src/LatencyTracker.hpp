@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "Input.hpp"
+
+// Follows key events from the moment the window system delivered them until
+// the frame that first shows their effect is presented.
+class LatencyTracker
+{
+public:
+    // Events consumed by the tick that produced the given frame
+    void submit(std::uint64_t frame, const std::vector<InputClock::time_point> & event_times);
+
+    // Frame has been presented, resolves all events of this and earlier frames
+    void presented(std::uint64_t frame, InputClock::time_point present_time);
+
+    std::size_t samples() const { return m_latencies.size(); }
+
+    // Prints count, p50, p99 and max latency in milliseconds
+    void report() const;
+
+private:
+    struct Pending
+    {
+        std::uint64_t frame;
+        InputClock::time_point time;
+    };
+
+    std::vector<Pending> m_pending;
+    std::vector<double> m_latencies;
+
+};
@@ -0,0 +1,103 @@
+#include "NarrowPhase.hpp"
+
+#include "Collision.hpp"
+
+//==============================================================================
+NarrowPhase::NarrowPhase() :
+    m_cache(CACHE_SIZE, CachedAxis{ 0, Vec2{ 0.0f, 0.0f } })
+{
+}
+
+//==============================================================================
+NarrowPhase::CachedAxis & NarrowPhase::cacheSlot(std::uint64_t key)
+{
+    // 64 bit mix (splitmix64 finalizer) so consecutive ids spread over the table
+    key ^= key >> 30; key *= 0xBF58476D1CE4E5B9ull;
+    key ^= key >> 27; key *= 0x94D049BB133111EBull;
+    key ^= key >> 31;
+
+    return m_cache[key & (CACHE_SIZE - 1)];
+}
+
+//==============================================================================
+bool NarrowPhase::intersect(const Ship & ship, const Rock & rock)
+{
+    return intersect(ship.id(), ship.polygonSRT(), rock.id(), rock.shape(), rock.scale(), rock.position());
+}
+
+//==============================================================================
+bool NarrowPhase::intersect(const Projectile & projectile, const Rock & rock)
+{
+    return intersect(projectile.id(), projectile.polygonSRT(), rock.id(), rock.shape(), rock.scale(), rock.position());
+}
+
+//==============================================================================
+bool NarrowPhase::intersect(std::uint32_t projectile_id, const std::array<Vec2, 4> & projectile_polygon,
+                            std::uint32_t rock_id, const RockShape & shape, float scale, const Vec2 & position)
+{
+    return intersect<4>(projectile_id, projectile_polygon, rock_id, shape, scale, position);
+}
+
+//==============================================================================
+bool NarrowPhase::intersect(const Ship & ship, std::uint32_t rock_id, const RockShape & shape, float scale, const Vec2 & position)
+{
+    return intersect(ship.id(), ship.polygonSRT(), rock_id, shape, scale, position);
+}
+
+//==============================================================================
+template <std::size_t N>
+bool NarrowPhase::intersect(std::uint32_t id, const std::array<Vec2, N> & polygon,
+                            std::uint32_t rock_id, const RockShape & shape, float scale, const Vec2 & position)
+{
+    m_statistics.tests++;
+
+    const auto key = (static_cast<std::uint64_t>(id) << 32) | rock_id;
+
+    // rock hull in world space, the same arithmetic as Rock::hullSRT
+    const auto & expanded = shape.expanded();
+
+    SmallVector<Vec2, ROCK_INLINE_VERTICES> hull;
+    hull.reserve(expanded.hull.size());
+    for (const auto & v : expanded.hull)
+        hull.emplace_back(v * scale + position);
+
+    // early out on last tick's separating axis
+    auto & cached = cacheSlot(key);
+    if (cached.key == key &&
+        axis_separates(cached.axis, polygon.data(), N, hull.data(), hull.size()))
+    {
+        m_statistics.cached_rejects++;
+        return false;
+    }
+
+    // separating axis test on the convex hulls
+    const auto normals = edge_normals(polygon);
+    const auto & rock_normals = expanded.hull_normals;
+
+    Vec2 axis;
+    if (find_separating_axis(polygon.data(), N, normals.data(), N,
+                             hull.data(), hull.size(), rock_normals.data(), rock_normals.size(),
+                             axis))
+    {
+        cached = CachedAxis{ key, axis };
+        m_statistics.sat_rejects++;
+        return false;
+    }
+
+    // hulls overlap, with a convex rock that is a hit
+    const auto & outline = expanded.outline;
+    if (expanded.hull.size() == outline.size())
+        return true;
+
+    // exact concave test: crossing edges or one shape completely inside the other
+    m_statistics.exact_tests++;
+
+    SmallVector<Vec2, ROCK_INLINE_VERTICES> rock_polygon;
+    rock_polygon.reserve(outline.size());
+    for (const auto & v : outline)
+        rock_polygon.emplace_back(v * scale + position);
+
+    return polygons_intersect(polygon, rock_polygon) ||
+           point_in_polygon(polygon[0], rock_polygon.data(), rock_polygon.size()) ||
+           point_in_polygon(rock_polygon[0], polygon.data(), N);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "Vec2.hpp"
+#include "Rock.hpp"
+#include "Ship.hpp"
+#include "Projectile.hpp"
+
+// Exact collision test for pairs that passed the broad phase.
+//
+// Every shape is first tested with the separating axis theorem on convex
+// hulls (ship and projectile are convex, rocks carry a precomputed hull).
+// The axis that separated a pair is remembered, as bodies move little per
+// tick it usually still separates them next tick, which makes rejecting a
+// pair a single projection. Only if the hulls overlap and the rock is not
+// convex the exact concave test is run.
+//
+// The axis cache is a fixed size direct mapped table, a colliding pair simply
+// evicts the previous entry. It never allocates after construction.
+class NarrowPhase
+{
+public:
+    //==========================================================================
+    struct Statistics
+    {
+        std::uint64_t tests{ 0 };
+        std::uint64_t cached_rejects{ 0 };
+        std::uint64_t sat_rejects{ 0 };
+        std::uint64_t exact_tests{ 0 };
+    };
+
+    NarrowPhase();
+
+    bool intersect(const Ship & ship, const Rock & rock);
+    bool intersect(const Projectile & projectile, const Rock & rock);
+
+    // Same test for bodies kept outside of Rock and Projectile objects, the
+    // projectile outline in world space and the rock as shape, scale and position
+    bool intersect(std::uint32_t projectile_id, const std::array<Vec2, 4> & projectile_polygon,
+                   std::uint32_t rock_id, const RockShape & shape, float scale, const Vec2 & position);
+    bool intersect(const Ship & ship, std::uint32_t rock_id, const RockShape & shape, float scale, const Vec2 & position);
+
+    const Statistics & statistics() const { return m_statistics; }
+
+private:
+    struct CachedAxis
+    {
+        std::uint64_t key;
+        Vec2 axis;
+    };
+
+    static constexpr std::size_t CACHE_SIZE = 1 << 14;
+
+    template <std::size_t N>
+    bool intersect(std::uint32_t id, const std::array<Vec2, N> & polygon,
+                   std::uint32_t rock_id, const RockShape & shape, float scale, const Vec2 & position);
+
+    CachedAxis & cacheSlot(std::uint64_t key);
+
+    std::vector<CachedAxis> m_cache;
+
+    Statistics m_statistics;
+
+};
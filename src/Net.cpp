@@ -0,0 +1,148 @@
+#include "Net.hpp"
+
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+//==============================================================================
+NetAddress NetAddress::parse(const std::string & text)
+{
+    const auto colon = text.rfind(':');
+    if (colon == std::string::npos)
+        throw std::runtime_error("Expected host:port, got " + text);
+
+    auto host = text.substr(0, colon);
+    if (host == "localhost")
+        host = "127.0.0.1";
+
+    in_addr address{};
+    if (inet_pton(AF_INET, host.c_str(), &address) != 1)
+        throw std::runtime_error("Invalid IPv4 address: " + host);
+
+    const auto port = std::stoul(text.substr(colon + 1));
+    if (port == 0 || port > 65535)
+        throw std::runtime_error("Invalid port in " + text);
+
+    return { ntohl(address.s_addr), static_cast<std::uint16_t>(port) };
+}
+
+//==============================================================================
+NetAddress NetAddress::loopback(std::uint16_t port)
+{
+    return { INADDR_LOOPBACK, port };
+}
+
+//==============================================================================
+std::string NetAddress::toString() const
+{
+    return std::to_string((ip >> 24) & 0xFF) + "." + std::to_string((ip >> 16) & 0xFF) + "." +
+           std::to_string((ip >>  8) & 0xFF) + "." + std::to_string(ip & 0xFF) + ":" + std::to_string(port);
+}
+
+//==============================================================================
+UdpSocket::UdpSocket(std::uint16_t port)
+{
+    m_socket = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (m_socket < 0)
+        throw std::runtime_error(std::string{ "Failed to create UDP socket: " } + std::strerror(errno));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+
+    if (::bind(m_socket, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0)
+    {
+        ::close(m_socket);
+        throw std::runtime_error("Failed to bind UDP port " + std::to_string(port) + ": " + std::strerror(errno));
+    }
+
+    ::fcntl(m_socket, F_SETFL, ::fcntl(m_socket, F_GETFL, 0) | O_NONBLOCK);
+
+    socklen_t length = sizeof(address);
+    ::getsockname(m_socket, reinterpret_cast<sockaddr *>(&address), &length);
+    m_port = ntohs(address.sin_port);
+}
+
+//==============================================================================
+UdpSocket::~UdpSocket()
+{
+    if (m_socket >= 0)
+        ::close(m_socket);
+}
+
+//==============================================================================
+void UdpSocket::send(const NetAddress & to, const std::uint8_t * data, std::size_t size)
+{
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(to.ip);
+    address.sin_port = htons(to.port);
+
+    // UDP gives no delivery guarantee anyway, a full send buffer is just another lost datagram
+    ::sendto(m_socket, data, size, 0, reinterpret_cast<const sockaddr *>(&address), sizeof(address));
+}
+
+//==============================================================================
+std::size_t UdpSocket::receive(NetAddress & from, std::uint8_t * buffer, std::size_t capacity)
+{
+    sockaddr_in address{};
+    socklen_t length = sizeof(address);
+
+    const auto size = ::recvfrom(m_socket, buffer, capacity, 0, reinterpret_cast<sockaddr *>(&address), &length);
+    if (size <= 0)
+        return 0;
+
+    from.ip = ntohl(address.sin_addr.s_addr);
+    from.port = ntohs(address.sin_port);
+
+    return static_cast<std::size_t>(size);
+}
+
+//==============================================================================
+NetConditioner::NetConditioner(const NetConditions & conditions, std::uint32_t seed) :
+    m_conditions{ conditions },
+    m_rng{ seed }
+{
+}
+
+//==============================================================================
+void NetConditioner::send(UdpSocket & socket, const NetAddress & to, const std::uint8_t * data, std::size_t size, std::uint64_t now)
+{
+    std::uniform_real_distribution<float> uniform{ 0.0f, 1.0f };
+
+    if (uniform(m_rng) < m_conditions.loss)
+    {
+        m_dropped_datagrams++;
+        return;
+    }
+
+    m_sent_bytes += size;
+    m_sent_datagrams++;
+
+    const auto delay_ms = m_conditions.latency_ms + uniform(m_rng) * m_conditions.jitter_ms;
+    if (delay_ms <= 0.0f)
+    {
+        socket.send(to, data, size);
+        return;
+    }
+
+    m_delayed.push_back({ now + static_cast<std::uint64_t>(delay_ms * 1000.0f), to, std::vector<std::uint8_t>(data, data + size) });
+}
+
+//==============================================================================
+void NetConditioner::flush(UdpSocket & socket, std::uint64_t now)
+{
+    for (const auto & d : m_delayed)
+        if (d.due <= now)
+            socket.send(d.to, d.data.data(), d.data.size());
+
+    m_delayed.erase(std::remove_if(m_delayed.begin(), m_delayed.end(), [now] (const Delayed & d) { return d.due <= now; }), m_delayed.end());
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <random>
+
+// IPv4 address and port in host byte order
+struct NetAddress
+{
+    std::uint32_t ip{ 0 };
+    std::uint16_t port{ 0 };
+
+    bool operator == (const NetAddress & other) const { return ip == other.ip && port == other.port; }
+    bool operator != (const NetAddress & other) const { return !(*this == other); }
+
+    // "host:port", host is a dotted IPv4 address or localhost, throws std::runtime_error if invalid
+    static NetAddress parse(const std::string & text);
+
+    static NetAddress loopback(std::uint16_t port);
+
+    std::string toString() const;
+};
+
+// Non-blocking UDP socket
+class UdpSocket
+{
+public:
+    // Binds to port on all interfaces, 0 picks a free port. Throws std::runtime_error on failure.
+    explicit UdpSocket(std::uint16_t port = 0);
+    ~UdpSocket();
+
+    UdpSocket(const UdpSocket &) = delete;
+    UdpSocket & operator = (const UdpSocket &) = delete;
+
+    std::uint16_t port() const { return m_port; }
+
+    void send(const NetAddress & to, const std::uint8_t * data, std::size_t size);
+
+    // Returns the datagram size, 0 if nothing is waiting
+    std::size_t receive(NetAddress & from, std::uint8_t * buffer, std::size_t capacity);
+
+private:
+    int m_socket{ -1 };
+    std::uint16_t m_port{ 0 };
+
+};
+
+// Loss, latency and jitter applied to outgoing datagrams, for testing the
+// protocol over loopback. Delayed datagrams can overtake each other.
+struct NetConditions
+{
+    float loss{ 0.0f };          // probability a datagram is dropped
+    float latency_ms{ 0.0f };    // one way delay
+    float jitter_ms{ 0.0f };     // uniform extra delay in [0, jitter_ms]
+};
+
+class NetConditioner
+{
+public:
+    NetConditioner(const NetConditions & conditions, std::uint32_t seed);
+
+    // Drops or schedules a datagram, now is in microseconds on any monotonic clock
+    void send(UdpSocket & socket, const NetAddress & to, const std::uint8_t * data, std::size_t size, std::uint64_t now);
+
+    // Sends every scheduled datagram that is due
+    void flush(UdpSocket & socket, std::uint64_t now);
+
+    std::uint64_t sentBytes() const { return m_sent_bytes; }
+    std::uint64_t sentDatagrams() const { return m_sent_datagrams; }
+    std::uint64_t droppedDatagrams() const { return m_dropped_datagrams; }
+
+private:
+    struct Delayed
+    {
+        std::uint64_t due;
+        NetAddress to;
+        std::vector<std::uint8_t> data;
+    };
+
+    NetConditions m_conditions;
+    std::minstd_rand m_rng;
+
+    std::vector<Delayed> m_delayed;
+
+    std::uint64_t m_sent_bytes{ 0 };
+    std::uint64_t m_sent_datagrams{ 0 };
+    std::uint64_t m_dropped_datagrams{ 0 };
+
+};
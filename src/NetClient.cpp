@@ -0,0 +1,239 @@
+#include "NetClient.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+//==============================================================================
+NetClient::NetClient(const NetAddress & server, const NetConditions & conditions, std::uint32_t seed) :
+    m_server{ server },
+    m_conditioner{ conditions, seed }
+{
+}
+
+//==============================================================================
+void NetClient::update(std::uint64_t now)
+{
+    std::uint8_t buffer[MAX_DATAGRAM_SIZE];
+    NetAddress from;
+
+    while (const auto size = m_socket.receive(from, buffer, sizeof(buffer)))
+    {
+        if (from != m_server)
+            continue;
+
+        m_statistics.received_bytes += size;
+
+        ByteReader r{ buffer, size };
+
+        MessageType type;
+        if (read_header(r, type) == false)
+            continue;
+
+        if (type == MessageType::ACCEPT)
+        {
+            r.u8();
+            const auto tick_rate = r.f32();
+
+            if (r.ok() && tick_rate > 0.0f)
+            {
+                m_tick_rate = tick_rate;
+                m_connected = true;
+            }
+        }
+        else if (type == MessageType::SNAPSHOT && m_connected)
+        {
+            applySnapshot(r, now);
+        }
+    }
+
+    if (m_connected == false)
+    {
+        std::uint8_t request[8];
+        ByteWriter w{ request, sizeof(request) };
+        write_header(w, MessageType::CONNECT);
+
+        m_conditioner.send(m_socket, m_server, request, w.size(), now);
+    }
+
+    m_conditioner.flush(m_socket, now);
+}
+
+//==============================================================================
+void NetClient::sendInput(std::uint32_t bitmask, std::uint64_t now)
+{
+    if (m_connected == false)
+        return;
+
+    std::uint8_t message[32];
+    ByteWriter w{ message, sizeof(message) };
+
+    write_header(w, MessageType::INPUT);
+    w.u32(++m_input_sequence);
+    w.u32(static_cast<std::uint32_t>(now));
+    w.u32(m_latest);
+    w.u32(m_applied_bits);
+    w.u32(bitmask);
+
+    m_conditioner.send(m_socket, m_server, message, w.size(), now);
+    m_conditioner.flush(m_socket, now);
+}
+
+//==============================================================================
+void NetClient::applySnapshot(ByteReader & r, std::uint64_t now)
+{
+    m_statistics.snapshots++;
+
+    const auto sequence = r.u32();
+    const auto baseline_sequence = r.u32();
+    const auto tick = r.u32();
+    const auto echo = r.u32();
+    const auto own_ship = r.u8();
+
+    // snapshots can arrive out of order, an older one has nothing new
+    if (sequence <= m_latest)
+    {
+        m_statistics.stale_snapshots++;
+        return;
+    }
+
+    static const ClientState s_empty;
+    const ClientState * baseline = &s_empty;
+    if (baseline_sequence != 0)
+    {
+        baseline = &m_history[baseline_sequence % HISTORY_SIZE];
+        if (baseline->sequence != baseline_sequence)
+        {
+            m_statistics.missing_baselines++;
+            return;
+        }
+    }
+
+    ClientState state;
+    state.sequence = sequence;
+    state.tick = tick;
+    state.own_ship = own_ship;
+
+    // ships, the fields that changed since the baseline
+    const auto ship_count = r.u8();
+    state.ships.resize(ship_count);
+    for (std::size_t i = 0; i < ship_count; ++i)
+    {
+        auto & s = state.ships[i];
+        if (i < baseline->ships.size())
+            s = baseline->ships[i];
+
+        const auto mask = r.u8();
+        if (mask & SHIP_POSITION) { s.x = r.u16(); s.y = r.u16(); }
+        if (mask & SHIP_ANGLE)    { s.angle = r.u16(); }
+        if (mask & SHIP_FLAGS)    { s.flags = r.u8(); }
+    }
+
+    // removed ids
+    const auto read_ids = [&r]
+    {
+        std::vector<std::uint32_t> ids(r.u16());
+        for (auto & id : ids) id = r.u32();
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    };
+
+    const auto removed_rocks = read_ids();
+    const auto removed_projectiles = read_ids();
+
+    const auto removed = [] (const std::vector<std::uint32_t> & ids, std::uint32_t id)
+    {
+        return std::binary_search(ids.begin(), ids.end(), id);
+    };
+
+    // Bodies change on top of the latest state, the server never adds one
+    // the client may already know and removes everything it may know that
+    // is gone. Without a baseline the client starts over from nothing.
+    const ClientState * latest = &s_empty;
+    if (baseline_sequence != 0)
+    {
+        latest = &m_history[m_latest % HISTORY_SIZE];
+        assert(latest->sequence == m_latest);
+    }
+
+    // dead reckon the bodies to the snapshot tick, with the same integration
+    // the server runs every tick
+    const float delta_time = 1.0f / m_tick_rate;
+    const auto steps = tick > latest->tick ? tick - latest->tick : 0;
+
+    state.rocks.reserve(latest->rocks.size());
+    for (const auto & rock : latest->rocks)
+        if (removed(removed_rocks, rock.id) == false)
+        {
+            state.rocks.push_back(rock);
+            auto & r = state.rocks.back();
+
+            for (std::uint32_t i = 0; i < steps; ++i)
+                integrate_wrapped(r.position, r.velocity, delta_time, { r.size, r.size }, NET_WORLD_SIZE);
+        }
+
+    state.projectiles.reserve(latest->projectiles.size());
+    for (const auto & projectile : latest->projectiles)
+        if (removed(removed_projectiles, projectile.id) == false)
+        {
+            state.projectiles.push_back(projectile);
+            auto & p = state.projectiles.back();
+
+            for (std::uint32_t i = 0; i < steps; ++i)
+                integrate_wrapped(p.position, p.velocity, delta_time, p.size, NET_WORLD_SIZE);
+        }
+
+    // added bodies, exact state at the snapshot tick
+    const auto projectile_count = r.u16();
+    for (std::size_t i = 0; i < projectile_count && r.ok(); ++i)
+    {
+        RemoteProjectile p;
+        p.id = r.u32();
+        p.position = { r.f32(), r.f32() };
+        p.velocity = { r.f32(), r.f32() };
+        p.size     = { r.f32(), r.f32() };
+
+        state.projectiles.push_back(p);
+    }
+
+    const auto rock_count = r.u16();
+    for (std::size_t i = 0; i < rock_count && r.ok(); ++i)
+    {
+        RemoteRock rock;
+        rock.id = r.u32();
+        rock.size = r.f32();
+        rock.position = { r.f32(), r.f32() };
+        rock.velocity = { r.f32(), r.f32() };
+
+        std::vector<Vec2> vertices(r.u8());
+        for (auto & v : vertices)
+        {
+            const auto x = static_cast<std::int8_t>(r.u8());
+            const auto y = static_cast<std::int8_t>(r.u8());
+            v = { x / ROCK_VERTEX_SCALE, y / ROCK_VERTEX_SCALE };
+        }
+
+        rock.shape = std::make_shared<const Polygon>(vertices);
+        state.rocks.push_back(std::move(rock));
+    }
+
+    if (r.ok() == false)
+        return;
+
+    // a body sent again after a lost snapshot can be older than the known ones
+    const auto by_id = [] (const auto & a, const auto & b) { return a.id < b.id; };
+    std::sort(state.rocks.begin(), state.rocks.end(), by_id);
+    std::sort(state.projectiles.begin(), state.projectiles.end(), by_id);
+
+    // round trip, once per echoed input
+    if (echo != 0 && echo != m_last_echo)
+    {
+        m_last_echo = echo;
+        m_statistics.round_trip_ms.push_back(static_cast<double>(static_cast<std::uint32_t>(now) - echo) / 1000.0);
+    }
+
+    const auto shift = sequence - m_latest;
+    m_applied_bits = shift > APPLIED_BITS ? 0 : ((m_applied_bits << (shift - 1)) << 1) | (m_latest != 0 ? 1u << (shift - 1) : 0u);
+
+    m_latest = sequence;
+    m_history[sequence % HISTORY_SIZE] = std::move(state);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "Net.hpp"
+#include "Protocol.hpp"
+#include "Polygon.hpp"
+
+// Rock as known to a client, the shape is shared by every snapshot it appears in
+struct RemoteRock
+{
+    std::uint32_t id;
+    float size;
+    Vec2 position;
+    Vec2 velocity;
+    std::shared_ptr<const Polygon> shape;
+};
+
+struct RemoteProjectile
+{
+    std::uint32_t id;
+    Vec2 position;
+    Vec2 velocity;
+    Vec2 size;
+};
+
+// World as reconstructed from one snapshot, bodies sorted by id
+struct ClientState
+{
+    std::uint32_t sequence{ 0 };
+    std::uint32_t tick{ 0 };
+    std::uint8_t own_ship{ 0 };
+
+    std::vector<NetShip> ships;
+    std::vector<RemoteRock> rocks;
+    std::vector<RemoteProjectile> projectiles;
+};
+
+// Client side of the client/server mode. Sends the action bitmask every tick
+// and rebuilds the world from snapshots, each applied on top of the stored
+// state of its baseline with rocks and projectiles dead reckoned in between.
+class NetClient
+{
+public:
+    struct Statistics
+    {
+        std::uint64_t received_bytes{ 0 };
+        std::uint64_t snapshots{ 0 };
+        std::uint64_t stale_snapshots{ 0 };       // older than the current state
+        std::uint64_t missing_baselines{ 0 };     // baseline no longer in the history
+        std::vector<double> round_trip_ms;
+    };
+
+    NetClient(const NetAddress & server, const NetConditions & conditions, std::uint32_t seed);
+
+    // Receives and applies snapshots, asks to connect until accepted. now in microseconds.
+    void update(std::uint64_t now);
+
+    // Sends the actions held this tick (bit i is Action i) with the acknowledgement
+    void sendInput(std::uint32_t bitmask, std::uint64_t now);
+
+    bool connected() const { return m_connected; }
+    std::uint16_t port() const { return m_socket.port(); }
+    float tickRate() const { return m_tick_rate; }
+
+    // Latest applied snapshot
+    const ClientState & state() const { return m_history[m_latest % HISTORY_SIZE]; }
+
+    const Statistics & statistics() const { return m_statistics; }
+    const NetConditioner & conditioner() const { return m_conditioner; }
+
+private:
+    static constexpr std::size_t HISTORY_SIZE = 32;
+
+    void applySnapshot(ByteReader & r, std::uint64_t now);
+
+    NetAddress m_server;
+    UdpSocket m_socket;
+    NetConditioner m_conditioner;
+
+    bool m_connected{ false };
+    float m_tick_rate{ 0.0f };
+
+    std::uint32_t m_input_sequence{ 0 };
+    std::uint32_t m_last_echo{ 0 };
+
+    std::vector<ClientState> m_history{ HISTORY_SIZE };
+    std::uint32_t m_latest{ 0 };
+    std::uint32_t m_applied_bits{ 0 };     // bit i: snapshot m_latest - 1 - i was applied
+
+    Statistics m_statistics;
+
+};
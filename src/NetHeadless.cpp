@@ -0,0 +1,319 @@
+#include "NetHeadless.hpp"
+
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+
+#include "NetServer.hpp"
+#include "NetClient.hpp"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // test length of scenarios that would otherwise run until game over
+    constexpr std::uint64_t DEFAULT_NET_TEST_TICKS = 600;
+
+    // simulated time after the last tick for every client to catch up
+    constexpr std::uint64_t DRAIN_MICROSECONDS = 3'000'000;
+
+    //==========================================================================
+    std::uint64_t microseconds_since(Clock::time_point start)
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+    }
+
+    //==========================================================================
+    double percentile(std::vector<double> values, double p)
+    {
+        if (values.empty()) return 0.0;
+
+        std::sort(values.begin(), values.end());
+        return values[static_cast<std::size_t>(p * static_cast<double>(values.size() - 1))];
+    }
+
+    //==========================================================================
+    // Scripted test pilot, every client turns, thrusts and fires on its own schedule
+    std::uint32_t test_input(std::size_t client, std::uint64_t tick)
+    {
+        const auto phase = (tick / 40 + client) % 4;
+
+        std::uint32_t bits = 1u << static_cast<std::uint32_t>(Action::FIRE);
+        if (phase == 0) bits |= 1u << static_cast<std::uint32_t>(Action::LEFT);
+        if (phase == 1) bits |= 1u << static_cast<std::uint32_t>(Action::FORWARD);
+        if (phase == 2) bits |= 1u << static_cast<std::uint32_t>(Action::RIGHT);
+
+        return bits;
+    }
+
+    struct Verification
+    {
+        bool converged{ false };
+        std::size_t missing{ 0 };
+        std::size_t extra{ 0 };
+        float rock_error{ 0.0f };
+        float projectile_error{ 0.0f };
+        float ship_error{ 0.0f };
+    };
+
+    //==========================================================================
+    // Compares a client's state with the server world, both at the same tick
+    Verification verify(const World & world, const ClientState & state)
+    {
+        Verification v;
+        v.converged = state.tick == world.tickCount();
+
+        const auto compare = [&v] (const auto & server_bodies, const auto & client_bodies, float & error)
+        {
+            auto c = client_bodies.begin();
+            for (const auto & body : server_bodies)
+            {
+                while (c != client_bodies.end() && c->id < body.id()) { ++c; v.extra++; }
+
+                if (c == client_bodies.end() || c->id != body.id())
+                {
+                    v.missing++;
+                    continue;
+                }
+
+                error = std::max(error, std::max(std::fabs(c->position.x - body.position().x), std::fabs(c->position.y - body.position().y)));
+                ++c;
+            }
+
+            v.extra += static_cast<std::size_t>(client_bodies.end() - c);
+        };
+
+        compare(world.rocks(), state.rocks, v.rock_error);
+        compare(world.projectiles(), state.projectiles, v.projectile_error);
+
+        for (std::size_t i = 0; i < state.ships.size() && i < world.shipCount(); ++i)
+        {
+            const auto p = state.ships[i].position();
+            const auto & q = world.ship(i).position();
+            v.ship_error = std::max(v.ship_error, std::max(std::fabs(p.x - q.x), std::fabs(p.y - q.y)));
+        }
+
+        return v;
+    }
+}
+
+//==============================================================================
+int run_server(const Scenario & scenario, const NetSettings & settings)
+{
+    NetServer server{ scenario, settings.port, settings.conditions, settings.snapshot_budget };
+
+    std::cout << "server: listening on UDP port " << server.port() << ", scenario " << scenario.name << std::endl;
+
+    const auto start = Clock::now();
+    const auto tick_duration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>{ scenario.deltaTime() });
+    auto next_tick = start;
+
+    constexpr std::uint64_t REPORT_INTERVAL = 5'000'000;
+    std::uint64_t next_report = REPORT_INTERVAL;
+    std::vector<std::uint64_t> reported_bytes;
+
+    while (scenario.ticks == 0 || server.world().tickCount() < scenario.ticks)
+    {
+        const auto now = microseconds_since(start);
+
+        server.receive(now);
+        server.tick();
+        server.sendSnapshots(now);
+
+        if (now >= next_report)
+        {
+            reported_bytes.resize(server.clientCount(), 0);
+
+            std::cout << "server: tick " << server.world().tickCount() << ", " << server.world().rocks().size() << " rocks, "
+                      << server.clientCount() << " clients" << std::endl;
+
+            for (std::size_t i = 0; i < server.clientCount(); ++i)
+            {
+                const auto & stats = server.clientStatistics(i);
+                std::cout << "  " << stats.address.toString() << ": "
+                          << (stats.snapshot_bytes - reported_bytes[i]) * 1'000'000 / REPORT_INTERVAL << " B/s" << std::endl;
+                reported_bytes[i] = stats.snapshot_bytes;
+            }
+
+            next_report += REPORT_INTERVAL;
+        }
+
+        next_tick += tick_duration;
+        std::this_thread::sleep_until(next_tick);
+    }
+
+    return 0;
+}
+
+//==============================================================================
+int run_net_test(const std::vector<Scenario> & scenarios, const NetSettings & settings)
+{
+    const auto & c = settings.conditions;
+
+    std::cout << settings.clients << " clients, " << c.loss * 100.0f << "% loss, "
+              << c.latency_ms << " ms latency, " << c.jitter_ms << " ms jitter, "
+              << settings.snapshot_budget << " byte snapshots" << std::endl;
+
+    std::cout << std::left
+              << std::setw(20) << "scenario"
+              << std::right
+              << std::setw(8)  << "rocks"
+              << std::setw(8)  << "ticks"
+              << std::setw(12) << "down B/s"
+              << std::setw(12) << "steady B/s"
+              << std::setw(10) << "up B/s"
+              << std::setw(8)  << "sync"
+              << std::setw(8)  << "loss %"
+              << std::setw(10) << "rtt p50"
+              << std::setw(10) << "rtt p99"
+              << std::setw(12) << "rock err"
+              << std::setw(12) << "ship err"
+              << std::setw(13) << "status" << std::endl;
+
+    int result = 0;
+
+    for (const auto & scenario : scenarios)
+    {
+        const auto ticks = scenario.ticks != 0 ? scenario.ticks : DEFAULT_NET_TEST_TICKS;
+        const auto tick_us = static_cast<std::uint64_t>(std::llround(1e6 / static_cast<double>(scenario.tick_rate)));
+
+        NetServer server{ scenario, 0, settings.conditions, settings.snapshot_budget };
+
+        std::vector<std::unique_ptr<NetClient>> clients;
+        for (std::size_t i = 0; i < settings.clients; ++i)
+            clients.push_back(std::make_unique<NetClient>(NetAddress::loopback(server.port()), settings.conditions, static_cast<std::uint32_t>(i + 1)));
+
+        // simulated clock, datagram delays are measured on it too
+        std::uint64_t now = 0;
+
+        enum class Phase { RUN, DRAIN, QUIET };
+
+        const auto step = [&] (Phase phase, std::uint64_t tick)
+        {
+            now += tick_us;
+
+            for (std::size_t i = 0; i < clients.size(); ++i)
+            {
+                clients[i]->update(now);
+                clients[i]->sendInput(phase == Phase::RUN ? test_input(i, tick) : 0, now);
+            }
+
+            server.receive(now);
+
+            if (phase == Phase::RUN)
+                server.tick();
+
+            if (phase == Phase::QUIET)
+                server.flush(now);
+            else
+                server.sendSnapshots(now);
+        };
+
+        for (std::uint64_t t = 0; t < ticks && !server.world().over(); ++t)
+            step(Phase::RUN, t);
+
+        // the server numbers clients in the order their requests arrived,
+        // null for a client it never accepted
+        const auto server_statistics = [&] (std::size_t i) -> const NetServer::ClientStatistics *
+        {
+            for (std::size_t s = 0; s < server.clientCount(); ++s)
+                if (server.clientStatistics(s).address.port == clients[i]->port())
+                    return &server.clientStatistics(s);
+            return nullptr;
+        };
+
+        // traffic of the run itself, the drain below would dilute it
+        const auto run_us = std::max<std::uint64_t>(1, now);
+        std::vector<NetServer::ClientStatistics> run_stats;
+        std::vector<std::uint64_t> run_received, run_sent;
+        for (std::size_t i = 0; i < clients.size(); ++i)
+        {
+            const auto stats = server_statistics(i);
+            run_stats.push_back(stats != nullptr ? *stats : NetServer::ClientStatistics{});
+            run_received.push_back(clients[i]->statistics().received_bytes);
+            run_sent.push_back(clients[i]->conditioner().sentBytes());
+        }
+
+        // the world stands still while the last snapshots get through, then
+        // nothing is sent until every delayed datagram has arrived
+        for (std::uint64_t t = 0; t * tick_us < DRAIN_MICROSECONDS; ++t)
+            step(Phase::DRAIN, 0);
+
+        const auto quiet_us = static_cast<std::uint64_t>((c.latency_ms + c.jitter_ms) * 1000.0f) + 2 * tick_us;
+        for (std::uint64_t t = 0; t * tick_us < quiet_us; ++t)
+            step(Phase::QUIET, 0);
+
+        // per client values, the table shows the mean, errors show the worst
+        double down = 0.0, steady = 0.0, up = 0.0, sync = 0.0, loss = 0.0;
+        std::vector<double> round_trips;
+        Verification worst;
+        worst.converged = true;
+        std::size_t unconnected = 0;
+
+        for (std::size_t i = 0; i < clients.size(); ++i)
+        {
+            const auto stats = server_statistics(i);
+            if (stats == nullptr)
+            {
+                ++unconnected;
+                continue;
+            }
+
+            const auto & client = *clients[i];
+            const auto & server_stats = run_stats[i];
+            const auto & client_stats = client.statistics();
+
+            down += static_cast<double>(run_received[i]) / static_cast<double>(run_us) * 1e6;
+            up += static_cast<double>(run_sent[i]) / static_cast<double>(run_us) * 1e6;
+            if (server_stats.synced_snapshots != 0)
+                steady += static_cast<double>(server_stats.synced_bytes) / static_cast<double>(server_stats.synced_snapshots) * scenario.tick_rate;
+            sync += static_cast<double>(server_stats.synced_tick);
+            loss += 1.0 - static_cast<double>(client_stats.snapshots) / static_cast<double>(std::max<std::uint64_t>(1, stats->snapshots));
+
+            round_trips.insert(round_trips.end(), client_stats.round_trip_ms.begin(), client_stats.round_trip_ms.end());
+
+            const auto v = verify(server.world(), client.state());
+            worst.converged = worst.converged && v.converged;
+            worst.missing += v.missing;
+            worst.extra += v.extra;
+            worst.rock_error = std::max(worst.rock_error, std::max(v.rock_error, v.projectile_error));
+            worst.ship_error = std::max(worst.ship_error, v.ship_error);
+        }
+
+        const auto n = static_cast<double>(std::max<std::size_t>(1, clients.size() - unconnected));
+        const bool ok = unconnected == 0 && worst.converged && worst.missing == 0 && worst.extra == 0 && worst.rock_error == 0.0f;
+        if (ok == false)
+            result = 1;
+
+        std::cout << std::left
+                  << std::setw(20) << scenario.name
+                  << std::right << std::fixed
+                  << std::setw(8)  << server.world().rocks().size()
+                  << std::setw(8)  << server.world().tickCount()
+                  << std::setprecision(0)
+                  << std::setw(12) << down / n
+                  << std::setw(12) << steady / n
+                  << std::setw(10) << up / n
+                  << std::setw(8)  << sync / n
+                  << std::setprecision(1)
+                  << std::setw(8)  << loss / n * 100.0
+                  << std::setw(10) << percentile(round_trips, 0.5)
+                  << std::setw(10) << percentile(round_trips, 0.99)
+                  << std::scientific << std::setprecision(1)
+                  << std::setw(12) << worst.rock_error
+                  << std::setw(12) << worst.ship_error
+                  << std::setw(13) << (ok ? "ok" : unconnected != 0 ? "unconnected" : worst.converged ? "mismatch" : "behind")
+                  << std::defaultfloat << std::endl;
+
+        if (unconnected != 0)
+            std::cout << "  " << unconnected << " of " << clients.size() << " clients never connected" << std::endl;
+        if (worst.missing != 0 || worst.extra != 0)
+            std::cout << "  " << worst.missing << " bodies missing, " << worst.extra << " extra on clients" << std::endl;
+    }
+
+    return result;
+}
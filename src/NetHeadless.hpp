@@ -0,0 +1,16 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "Scenario.hpp"
+
+// Authoritative server without a window, runs in real time until
+// scenario.ticks ticks (forever if 0) and prints traffic every few seconds
+int run_server(const Scenario & scenario, const NetSettings & settings);
+
+// Server and settings.clients clients in one process talking over loopback
+// UDP through the loss and jitter simulation. Runs on a simulated clock as
+// fast as possible, then checks the reconstructed client worlds against the
+// server and prints bandwidth, loss and round trip statistics per scenario.
+int run_net_test(const std::vector<Scenario> & scenarios, const NetSettings & settings);
@@ -0,0 +1,371 @@
+#include "NetServer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iterator>
+#include <stdexcept>
+
+//==============================================================================
+NetServer::NetServer(const Scenario & scenario, std::uint16_t port, const NetConditions & conditions, std::size_t snapshot_budget) :
+    m_world{ scenario, 0 },
+    m_socket{ port },
+    m_conditioner{ conditions, 0x5EB7E5u },
+    m_snapshot_budget{ std::min(std::max(snapshot_budget, MIN_SNAPSHOT_BUDGET), MAX_DATAGRAM_SIZE) }
+{
+    if (scenario.world_size != NET_WORLD_SIZE)
+        throw std::runtime_error("Network play needs a scenario with world_size = 1.");
+}
+
+//==============================================================================
+NetServer::Client & NetServer::connect(const NetAddress & address)
+{
+    for (auto & c : m_clients)
+        if (c.address == address)
+            return c;
+
+    Client client;
+    client.address = address;
+    client.ship = static_cast<std::uint8_t>(m_world.addShip());
+    client.statistics.address = address;
+
+    m_clients.push_back(std::move(client));
+    return m_clients.back();
+}
+
+//==============================================================================
+void NetServer::receive(std::uint64_t now)
+{
+    std::uint8_t buffer[MAX_DATAGRAM_SIZE];
+    NetAddress from;
+
+    while (const auto size = m_socket.receive(from, buffer, sizeof(buffer)))
+    {
+        ByteReader r{ buffer, size };
+
+        MessageType type;
+        if (read_header(r, type) == false)
+            continue;
+
+        if (type == MessageType::CONNECT)
+        {
+            if (m_world.shipCount() >= MAX_SHIPS && std::none_of(m_clients.begin(), m_clients.end(), [&from] (const Client & c) { return c.address == from; }))
+                continue;
+
+            const auto & client = connect(from);
+
+            std::uint8_t reply[32];
+            ByteWriter w{ reply, sizeof(reply) };
+            write_header(w, MessageType::ACCEPT);
+            w.u8(client.ship);
+            w.f32(m_world.scenario().tick_rate);
+
+            m_conditioner.send(m_socket, from, reply, w.size(), now);
+        }
+        else if (type == MessageType::INPUT)
+        {
+            const auto client = std::find_if(m_clients.begin(), m_clients.end(), [&from] (const Client & c) { return c.address == from; });
+            if (client == m_clients.end())
+                continue;
+
+            const auto sequence = r.u32();
+            const auto time     = r.u32();
+            const auto acked    = r.u32();
+            const auto applied  = r.u32();
+            const auto bitmask  = r.u32();
+
+            // datagrams can arrive out of order, only newer input counts
+            if (r.ok() == false || sequence <= client->input_sequence)
+                continue;
+
+            client->input_sequence = sequence;
+            client->echo_time = time;
+            client->input_bitmask = bitmask;
+            acknowledge(*client, acked, applied);
+        }
+    }
+}
+
+//==============================================================================
+void NetServer::acknowledge(Client & client, std::uint32_t acked, std::uint32_t applied_bits)
+{
+    if (acked <= client.acked)
+        return;
+
+    // applied snapshots older than the bits cover are unknown
+    if (acked - client.acked > APPLIED_BITS + 1)
+        client.confirmed = 0;
+
+    const auto first = std::max(client.acked + 1, acked > APPLIED_BITS ? acked - APPLIED_BITS : 1u);
+    client.acked = acked;
+
+    // replay what the client applied, oldest first
+    for (auto sequence = first; sequence <= acked; ++sequence)
+    {
+        const bool applied = sequence == acked || ((applied_bits >> (acked - 1 - sequence)) & 1) != 0;
+        if (applied == false)
+            continue;
+
+        const auto & sent = client.history[sequence % HISTORY_SIZE];
+        if (sent.sequence != sequence)
+        {
+            client.confirmed = 0;
+            continue;
+        }
+
+        // a snapshot without baseline starts the client over
+        if (sent.baseline == 0)
+        {
+            client.confirmed_rocks.clear();
+            client.confirmed_projectiles.clear();
+        }
+        else if (client.confirmed == 0)
+            continue;
+
+        const auto apply = [] (std::vector<std::uint32_t> & ids, const std::vector<std::uint32_t> & removed, const std::vector<std::uint32_t> & added)
+        {
+            std::vector<std::uint32_t> kept;
+            kept.reserve(ids.size());
+            std::set_difference(ids.begin(), ids.end(), removed.begin(), removed.end(), std::back_inserter(kept));
+
+            ids.clear();
+            std::merge(kept.begin(), kept.end(), added.begin(), added.end(), std::back_inserter(ids));
+        };
+
+        apply(client.confirmed_rocks, sent.removed_rocks, sent.added_rocks);
+        apply(client.confirmed_projectiles, sent.removed_projectiles, sent.added_projectiles);
+        client.confirmed = sequence;
+    }
+}
+
+//==============================================================================
+void NetServer::tick()
+{
+    m_inputs.assign(m_world.shipCount(), InputFrame{});
+
+    for (const auto & c : m_clients)
+        m_inputs[c.ship] = InputFrame::fromBitmask(c.input_bitmask);
+
+    m_world.tick(m_inputs.data(), m_inputs.size());
+}
+
+//==============================================================================
+std::vector<NetShip> NetServer::ships() const
+{
+    std::vector<NetShip> result(m_world.shipCount());
+
+    for (std::size_t i = 0; i < result.size(); ++i)
+    {
+        const auto & ship = m_world.ship(i);
+
+        result[i].x = NetShip::quantizePosition(ship.position().x);
+        result[i].y = NetShip::quantizePosition(ship.position().y);
+        result[i].angle = NetShip::quantizeAngle(std::atan2(ship.direction().y, ship.direction().x));
+        result[i].flags = static_cast<std::uint8_t>((m_world.shipDestroyed(i) ? SHIP_DESTROYED : 0) |
+                                                    (m_world.invincibilityLeft(i) >= 0.0f ? SHIP_INVINCIBLE : 0));
+    }
+
+    return result;
+}
+
+//==============================================================================
+void NetServer::sendSnapshots(std::uint64_t now)
+{
+    for (auto & c : m_clients)
+        sendSnapshot(c, now);
+
+    flush(now);
+}
+
+//==============================================================================
+void NetServer::sendSnapshot(Client & client, std::uint64_t now)
+{
+    const auto & rocks = m_world.rocks();
+    const auto & projectiles = m_world.projectiles();
+
+    // bodies are appended with increasing ids and removed in order, so both stay sorted
+    assert(std::is_sorted(rocks.begin(), rocks.end(), [] (const Rock & a, const Rock & b) { return a.id() < b.id(); }));
+    assert(std::is_sorted(projectiles.begin(), projectiles.end(), [] (const Projectile & a, const Projectile & b) { return a.id() < b.id(); }));
+
+    // baseline is the newest snapshot the client applied if it is still in the history
+    static const SentSnapshot s_empty;
+    const SentSnapshot * baseline = &s_empty;
+    if (client.confirmed != 0)
+    {
+        const auto & entry = client.history[client.confirmed % HISTORY_SIZE];
+        if (entry.sequence == client.confirmed)
+            baseline = &entry;
+    }
+
+    const auto sequence = client.next_sequence++;
+
+    SentSnapshot sent;
+    sent.sequence = sequence;
+    sent.baseline = baseline->sequence;
+    sent.ships = ships();
+
+    std::uint8_t buffer[MAX_DATAGRAM_SIZE];
+    ByteWriter w{ buffer, m_snapshot_budget };
+
+    write_header(w, MessageType::SNAPSHOT);
+    w.u32(sequence);
+    w.u32(baseline->sequence);
+    w.u32(static_cast<std::uint32_t>(m_world.tickCount()));
+    w.u32(client.echo_time);
+    w.u8(client.ship);
+
+    // ships, only the fields that differ from the baseline
+    w.u8(static_cast<std::uint8_t>(sent.ships.size()));
+    for (std::size_t i = 0; i < sent.ships.size(); ++i)
+    {
+        const auto & s = sent.ships[i];
+        const bool known = i < baseline->ships.size();
+        const auto & b = known ? baseline->ships[i] : NetShip{};
+
+        const std::uint8_t mask = static_cast<std::uint8_t>(
+            (!known || s.x != b.x || s.y != b.y ? SHIP_POSITION : 0) |
+            (!known || s.angle != b.angle       ? SHIP_ANGLE    : 0) |
+            (!known || s.flags != b.flags       ? SHIP_FLAGS    : 0));
+
+        w.u8(mask);
+        if (mask & SHIP_POSITION) { w.u16(s.x); w.u16(s.y); }
+        if (mask & SHIP_ANGLE)    { w.u16(s.angle); }
+        if (mask & SHIP_FLAGS)    { w.u8(s.flags); }
+    }
+
+    // Bodies the client may know, the confirmed ones plus everything added by
+    // the snapshots not acknowledged yet, whether they arrive or not. The
+    // client applies bodies on top of its latest state, so removals must cover
+    // all of them while bodies in flight need not be sent again. Once a lost
+    // snapshot is acknowledged as not applied its bodies are sent again.
+    // Without a baseline the client starts over from nothing.
+    std::vector<std::uint32_t> possible_rocks;
+    std::vector<std::uint32_t> possible_projectiles;
+
+    if (baseline != &s_empty)
+    {
+        possible_rocks = client.confirmed_rocks;
+        possible_projectiles = client.confirmed_projectiles;
+
+        for (const auto & entry : client.history)
+            if (entry.sequence > client.acked)
+            {
+                possible_rocks.insert(possible_rocks.end(), entry.added_rocks.begin(), entry.added_rocks.end());
+                possible_projectiles.insert(possible_projectiles.end(), entry.added_projectiles.begin(), entry.added_projectiles.end());
+            }
+
+        for (auto * ids : { &possible_rocks, &possible_projectiles })
+        {
+            std::sort(ids->begin(), ids->end());
+            ids->erase(std::unique(ids->begin(), ids->end()), ids->end());
+        }
+    }
+
+    // Removed ids, as many as fit, the rest are removed by a later snapshot.
+    // reserve is the space needed by the count fields of the following sections.
+    const auto write_removed = [&w] (const std::vector<std::uint32_t> & possible_ids, const auto & bodies, std::size_t reserve,
+                                     std::vector<std::uint32_t> & removed_ids)
+    {
+        const auto count_offset = w.size();
+        w.u16(0);
+
+        auto body = bodies.begin();
+
+        for (const auto id : possible_ids)
+        {
+            while (body != bodies.end() && body->id() < id) ++body;
+
+            const bool removed = body == bodies.end() || body->id() != id;
+            if (removed && removed_ids.size() < 0xFFFF && w.remaining() >= 4 + reserve)
+            {
+                w.u32(id);
+                removed_ids.push_back(id);
+            }
+        }
+
+        if (w.overflow() == false)
+            w.u16At(count_offset, static_cast<std::uint16_t>(removed_ids.size()));
+    };
+
+    write_removed(possible_rocks, rocks, 6, sent.removed_rocks);
+    write_removed(possible_projectiles, projectiles, 4, sent.removed_projectiles);
+
+    // Added bodies with their exact state, as many as fit. The rest are
+    // added by a later snapshot.
+    const auto write_added = [&w] (const std::vector<std::uint32_t> & possible_ids, const auto & bodies, std::size_t reserve,
+                                   const auto & body_size, std::vector<std::uint32_t> & added_ids, const auto & write_body) -> bool
+    {
+        const auto count_offset = w.size();
+        w.u16(0);
+
+        bool complete = true;
+        auto possible = possible_ids.begin();
+
+        for (const auto & body : bodies)
+        {
+            while (possible != possible_ids.end() && *possible < body.id()) ++possible;
+            if (possible != possible_ids.end() && *possible == body.id())
+                continue;
+
+            if (added_ids.size() == 0xFFFF || w.remaining() < body_size(body) + reserve)
+            {
+                complete = false;
+                break;
+            }
+
+            write_body(body);
+            added_ids.push_back(body.id());
+        }
+
+        if (w.overflow() == false)
+            w.u16At(count_offset, static_cast<std::uint16_t>(added_ids.size()));
+
+        return complete;
+    };
+
+    write_added(possible_projectiles, projectiles, 2, [] (const Projectile &) -> std::size_t { return 28; }, sent.added_projectiles,
+                [&w] (const Projectile & p)
+                {
+                    w.u32(p.id());
+                    w.f32(p.position().x); w.f32(p.position().y);
+                    w.f32(p.velocity().x); w.f32(p.velocity().y);
+                    w.f32(p.size().x);     w.f32(p.size().y);
+                });
+
+    const bool all_rocks_sent = write_added(possible_rocks, rocks, 0, [] (const Rock & r) -> std::size_t { return 25 + r.size() * 2; }, sent.added_rocks,
+                [&w] (const Rock & r)
+                {
+                    w.u32(r.id());
+                    w.f32(r.scale());
+                    w.f32(r.position().x); w.f32(r.position().y);
+                    w.f32(r.velocity().x); w.f32(r.velocity().y);
+                    w.u8(static_cast<std::uint8_t>(r.polygon().size()));
+                    for (const auto & v : r.polygon())
+                    {
+                        w.u8(static_cast<std::uint8_t>(static_cast<std::int8_t>(std::lround(v.x * ROCK_VERTEX_SCALE))));
+                        w.u8(static_cast<std::uint8_t>(static_cast<std::int8_t>(std::lround(v.y * ROCK_VERTEX_SCALE))));
+                    }
+                });
+
+    // the budget always fits the header, MAX_SHIPS ships and the section
+    // counts, everything else checks the remaining space first
+    assert(w.overflow() == false);
+
+    m_conditioner.send(m_socket, client.address, buffer, w.size(), now);
+
+    auto & stats = client.statistics;
+    stats.snapshots++;
+    stats.snapshot_bytes += w.size();
+    if (baseline == &s_empty)
+        stats.full_snapshots++;
+
+    if (stats.synced_tick == 0 && all_rocks_sent)
+        stats.synced_tick = std::max<std::uint64_t>(1, m_world.tickCount());
+    else if (stats.synced_tick != 0)
+    {
+        stats.synced_bytes += w.size();
+        stats.synced_snapshots++;
+    }
+
+    client.history[sequence % HISTORY_SIZE] = std::move(sent);
+}
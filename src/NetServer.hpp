@@ -0,0 +1,99 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "World.hpp"
+#include "Net.hpp"
+#include "Protocol.hpp"
+
+// Authoritative server, owns the World and gives every connected client a
+// ship. Clients send action bitmasks, the server answers every tick with a
+// snapshot delta compressed against the newest snapshot the client applied.
+class NetServer
+{
+public:
+    struct ClientStatistics
+    {
+        NetAddress address;
+        std::uint64_t snapshots{ 0 };
+        std::uint64_t snapshot_bytes{ 0 };
+        std::uint64_t full_snapshots{ 0 };    // sent without a baseline
+        std::uint64_t synced_tick{ 0 };        // first tick the client was sent every rock, 0 if not yet
+        std::uint64_t synced_bytes{ 0 };       // snapshot bytes sent after synced_tick
+        std::uint64_t synced_snapshots{ 0 };
+    };
+
+    NetServer(const Scenario & scenario, std::uint16_t port, const NetConditions & conditions,
+              std::size_t snapshot_budget = DEFAULT_SNAPSHOT_BUDGET);
+
+    std::uint16_t port() const { return m_socket.port(); }
+
+    // Handles connection requests and inputs, now in microseconds
+    void receive(std::uint64_t now);
+
+    // Advances the world with the latest input of every client
+    void tick();
+
+    // One snapshot per client, also flushes datagrams delayed by the conditioner
+    void sendSnapshots(std::uint64_t now);
+
+    // Sends datagrams delayed by the conditioner that are due
+    void flush(std::uint64_t now) { m_conditioner.flush(m_socket, now); }
+
+    const World & world() const { return m_world; }
+    std::size_t clientCount() const { return m_clients.size(); }
+    const ClientStatistics & clientStatistics(std::size_t client) const { return m_clients[client].statistics; }
+    const NetConditioner & conditioner() const { return m_conditioner; }
+
+private:
+    // What a snapshot changed, ids sorted
+    struct SentSnapshot
+    {
+        std::uint32_t sequence{ 0 };
+        std::uint32_t baseline{ 0 };
+        std::vector<std::uint32_t> removed_rocks;
+        std::vector<std::uint32_t> removed_projectiles;
+        std::vector<std::uint32_t> added_rocks;
+        std::vector<std::uint32_t> added_projectiles;
+        std::vector<NetShip> ships;
+    };
+
+    static constexpr std::size_t HISTORY_SIZE = 64;
+
+    struct Client
+    {
+        NetAddress address;
+        std::uint8_t ship{ 0 };
+
+        std::uint32_t input_sequence{ 0 };
+        std::uint32_t input_bitmask{ 0 };
+        std::uint32_t echo_time{ 0 };
+        std::uint32_t acked{ 0 };
+
+        // newest snapshot the client applied with the bodies it knows since,
+        // replayed from the acknowledgements, 0 if unknown
+        std::uint32_t confirmed{ 0 };
+        std::vector<std::uint32_t> confirmed_rocks;
+        std::vector<std::uint32_t> confirmed_projectiles;
+
+        std::uint32_t next_sequence{ 1 };
+        std::vector<SentSnapshot> history{ HISTORY_SIZE };
+
+        ClientStatistics statistics;
+    };
+
+    void acknowledge(Client & client, std::uint32_t acked, std::uint32_t applied_bits);
+    void sendSnapshot(Client & client, std::uint64_t now);
+    Client & connect(const NetAddress & address);
+    std::vector<NetShip> ships() const;
+
+    World m_world;
+    UdpSocket m_socket;
+    NetConditioner m_conditioner;
+    std::size_t m_snapshot_budget;
+
+    std::vector<Client> m_clients;
+    std::vector<InputFrame> m_inputs;
+
+};
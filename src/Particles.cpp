@@ -0,0 +1,182 @@
+#include "Particles.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // simd lanes, buffers are padded to a multiple so the last group needs no tail loop
+    constexpr std::size_t LANES = 4;
+
+    // pixels
+    constexpr float POINT_SIZE = 2.0f;
+
+    // particles per bulk draw of random points in emit()
+    constexpr std::size_t EMIT_BATCH = 64;
+
+    //==========================================================================
+    std::size_t padded(std::size_t count)
+    {
+        return (count + LANES - 1) / LANES * LANES;
+    }
+}
+
+//==============================================================================
+ParticleSystem::ParticleSystem(std::size_t capacity, float world_size) :
+    m_x(padded(capacity)),
+    m_y(padded(capacity)),
+    m_vx(padded(capacity)),
+    m_vy(padded(capacity)),
+    m_life(padded(capacity)),
+    m_vertices(padded(capacity)),
+    m_world_size(world_size)
+{
+}
+
+//==============================================================================
+void ParticleSystem::emit(const Vec2 & position, const Vec2 & velocity, std::size_t count, float speed, float life)
+{
+    const auto room = m_life.size() - m_size;
+    if (count > room)
+    {
+        m_dropped += count - room;
+        count = room;
+    }
+
+    // direction and variation of each particle, drawn in bulk
+    Vec2 random[2 * EMIT_BATCH];
+
+    for (std::size_t first = m_size; first < m_size + count; first += EMIT_BATCH)
+    {
+        const auto batch = std::min(EMIT_BATCH, m_size + count - first);
+        m_rng.fill(random, 2 * batch);
+
+        for (std::size_t j = 0; j < batch; ++j)
+        {
+            const auto i = first + j;
+            const Vec2 direction = random[2 * j];
+            const Vec2 variation = random[2 * j + 1];
+
+            const float angle = direction.x * 6.2831853f;
+            const float s = speed * direction.y;
+
+            m_x[i] = position.x;
+            m_y[i] = position.y;
+            m_vx[i] = velocity.x + std::cos(angle) * s;
+            m_vy[i] = velocity.y + std::sin(angle) * s;
+            m_life[i] = life * (0.5f + 0.5f * variation.x);
+        }
+    }
+
+    m_size += count;
+}
+
+//==============================================================================
+void ParticleSystem::update(float delta_time)
+{
+    // integrate every particle, including the padding past m_size which is never drawn
+    const std::size_t end = padded(m_size);
+
+#if defined(__SSE2__)
+    const __m128 dt = _mm_set1_ps(delta_time);
+    const __m128 upper = _mm_set1_ps(m_world_size);
+    const __m128 lower = _mm_set1_ps(-m_world_size);
+    const __m128 period = _mm_set1_ps(2.0f * m_world_size);
+
+    // wrap around the [-world_size, world_size] square without branches
+    const auto wrap = [upper, lower, period] (__m128 v)
+    {
+        v = _mm_sub_ps(v, _mm_and_ps(_mm_cmpgt_ps(v, upper), period));
+        v = _mm_add_ps(v, _mm_and_ps(_mm_cmplt_ps(v, lower), period));
+        return v;
+    };
+
+    for (std::size_t i = 0; i < end; i += LANES)
+    {
+        const __m128 x = wrap(_mm_add_ps(_mm_loadu_ps(&m_x[i]), _mm_mul_ps(_mm_loadu_ps(&m_vx[i]), dt)));
+        const __m128 y = wrap(_mm_add_ps(_mm_loadu_ps(&m_y[i]), _mm_mul_ps(_mm_loadu_ps(&m_vy[i]), dt)));
+
+        _mm_storeu_ps(&m_x[i], x);
+        _mm_storeu_ps(&m_y[i], y);
+        _mm_storeu_ps(&m_life[i], _mm_sub_ps(_mm_loadu_ps(&m_life[i]), dt));
+
+        // x0 y0 x1 y1 | x2 y2 x3 y3
+        _mm_storeu_ps(&m_vertices[i].x,     _mm_unpacklo_ps(x, y));
+        _mm_storeu_ps(&m_vertices[i + 2].x, _mm_unpackhi_ps(x, y));
+    }
+#else
+    const float period = 2.0f * m_world_size;
+
+    for (std::size_t i = 0; i < end; ++i)
+    {
+        float x = m_x[i] + m_vx[i] * delta_time;
+        float y = m_y[i] + m_vy[i] * delta_time;
+
+        if (x > m_world_size) x -= period; else if (x < -m_world_size) x += period;
+        if (y > m_world_size) y -= period; else if (y < -m_world_size) y += period;
+
+        m_x[i] = x;
+        m_y[i] = y;
+        m_life[i] -= delta_time;
+        m_vertices[i] = Vec2{ x, y };
+    }
+#endif
+
+    // recycle dead particles, the last live one takes the place of a dead one
+    std::size_t i = 0;
+    while (i < m_size)
+    {
+        if (m_life[i] > 0.0f)
+        {
+            ++i;
+            continue;
+        }
+
+        const auto last = --m_size;
+
+        m_x[i] = m_x[last];
+        m_y[i] = m_y[last];
+        m_vx[i] = m_vx[last];
+        m_vy[i] = m_vy[last];
+        m_life[i] = m_life[last];
+        m_vertices[i] = m_vertices[last];
+    }
+
+    m_vertex_count = m_size;
+}
+
+//==============================================================================
+void ParticleSystem::draw() const
+{
+    if (!m_VAO)
+    {
+        m_VAO = VertexArrayHandle::create();
+        m_VBO = BufferHandle::create();
+
+        glBindVertexArray(m_VAO.get());
+        glBindBuffer(GL_ARRAY_BUFFER, m_VBO.get());
+
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vec2), (GLvoid *)0);
+        glEnableVertexAttribArray(0);
+    }
+    else
+    {
+        glBindVertexArray(m_VAO.get());
+        glBindBuffer(GL_ARRAY_BUFFER, m_VBO.get());
+    }
+
+    if (m_vertex_count == 0)
+        return;
+
+    // orphan the previous frame's storage instead of waiting for the GPU to finish with it
+    const auto bytes = static_cast<GLsizeiptr>(m_vertex_count * sizeof(Vec2));
+    glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, m_vertices.data());
+
+    glPointSize(POINT_SIZE);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(m_vertex_count));
+}
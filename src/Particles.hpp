@@ -0,0 +1,65 @@
+#pragma once
+
+#include <GL/gl3w.h>
+
+#include <vector>
+#include <cstdint>
+
+#include "Vec2.hpp"
+#include "GlHandle.hpp"
+#include "Vec2Gen.hpp"
+
+// Debris of explosions, purely visual and not part of the simulation.
+//
+// Particles live in a fixed pool of structure of arrays buffers (x, y,
+// velocity x, velocity y, life), the live ones packed at the front. update()
+// integrates four particles per SSE instruction and writes the positions
+// interleaved for the GPU, dead particles are replaced by the last live one.
+// Emitting into a full pool drops the new particles. All particles are drawn
+// with a single GL_POINTS call through the line shader, the GL buffer is made
+// on the first draw so the benchmark runs without a GL context.
+class ParticleSystem
+{
+public:
+    explicit ParticleSystem(std::size_t capacity, float world_size = 1.0f);
+
+    ParticleSystem(const ParticleSystem &) = delete;
+    ParticleSystem & operator = (const ParticleSystem &) = delete;
+
+    // count particles flying out of position in random directions with up to
+    // speed on top of velocity, each living between life / 2 and life seconds
+    void emit(const Vec2 & position, const Vec2 & velocity, std::size_t count, float speed, float life);
+
+    // Moves every particle with wrap around and drops the ones that died
+    void update(float delta_time);
+
+    // Positions as of the latest update(), the caller sets an identity transform
+    void draw() const;
+
+    std::size_t size() const { return m_size; }
+    std::size_t capacity() const { return m_life.size(); }
+    std::uint64_t dropped() const { return m_dropped; }
+
+private:
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_vx;
+    std::vector<float> m_vy;
+    std::vector<float> m_life;
+
+    // interleaved positions for the vertex buffer
+    std::vector<Vec2> m_vertices;
+
+    float m_world_size;
+
+    std::size_t m_size{ 0 };
+    std::size_t m_vertex_count{ 0 };    // particles with a position in m_vertices, emitted ones get it in update()
+    std::uint64_t m_dropped{ 0 };
+
+    Vec2Gen m_rng{ 0x9A271C1E };
+
+    // GL objects are created lazily from draw()
+    mutable VertexArrayHandle m_VAO;
+    mutable BufferHandle m_VBO;
+
+};
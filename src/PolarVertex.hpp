@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include "Vec2.hpp"
+
+// Rock outline vertex in the form it is generated in, normalized polar
+// coordinates as 16 bit fractions: radius 0.7 + 0.3 * radius, angle
+// 6.283 * angle. Half the size of a Vec2, rock meshes are stored, saved and
+// uploaded like this and shader/rock.vert decodes them on the GPU.
+struct PolarVertex
+{
+    std::uint16_t radius;
+    std::uint16_t angle;
+};
+
+//==============================================================================
+// Nearest 16 bit fraction of a normalized polar coordinate in [0, 1]
+inline std::uint16_t quantize_polar(float fraction)
+{
+    return static_cast<std::uint16_t>(std::lround(fraction * 65535.0f));
+}
+
+//==============================================================================
+// Cartesian model space vertex, the same arithmetic everywhere on the CPU so
+// every expansion of an outline is bit identical
+inline Vec2 decode_polar(const PolarVertex & v)
+{
+    const float radius = static_cast<float>(v.radius) / 65535.0f;
+    const float angle = static_cast<float>(v.angle) / 65535.0f;
+
+    // * hardcoded size interpretation
+    // * angle scale should be a little less than 2 x pi
+    return {
+        (radius * 0.3f + 0.7f) * std::cos(angle * 6.283f),
+        (radius * 0.3f + 0.7f) * std::sin(angle * 6.283f)
+    };
+}
+
+//==============================================================================
+inline bool operator == (const PolarVertex & a, const PolarVertex & b)
+{
+    return a.radius == b.radius && a.angle == b.angle;
+}
@@ -3,160 +3,229 @@
 #include <GL/gl3w.h>
 
 #include <vector>
+#include <array>
 #include <cassert>
 
 #include "Vec2.hpp"
+#include "PolarVertex.hpp"
+#include "GlHandle.hpp"
 
 //#define SOLID_COLOR
 
-class Polygon
+// Placement of a polygon, the scale, rotation and translation uniforms of the line shader
+struct DrawTransform
+{
+    Vec2 scale;
+    float rotation[4];
+    Vec2 translation;
+};
+
+//==============================================================================
+// Attribute 0 of the vertex buffer bound to GL_ARRAY_BUFFER, Vec2 for
+// shader/line.vert, 16 bit fractions for shader/rock.vert
+inline void set_vertex_attribute(const Vec2 *)
+{
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vec2), (GLvoid *)0);
+}
+
+inline void set_vertex_attribute(const PolarVertex *)
+{
+    glVertexAttribPointer(0, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PolarVertex), (GLvoid *)0);
+}
+
+// Vertex list with a GPU copy. The GPU buffer is only created and filled on
+// the first draw after a change, so simulation code (and the headless runner,
+// which has no GL context) never touches GL. Dropped GL objects wait in the
+// deletion queue of GlHandle.hpp for the end of the frame. The vertices are
+// a copy of their own, or with view() storage the owner keeps alive.
+template <typename VERTEX>
+class BasicPolygon
 {
 public:
     //==========================================================================
-    Polygon() {}
+    BasicPolygon() {}
 
     //==========================================================================
-    Polygon(const std::vector<Vec2> & vertices)
+    BasicPolygon(const std::vector<VERTEX> & vertices)
     {
         update(vertices);
     }
 
     //==========================================================================
-    Polygon (const Polygon & other) :
-        m_vertices{ other.m_vertices }
+    template <std::size_t N>
+    BasicPolygon(const std::array<VERTEX, N> & vertices)
     {
-        if (other.m_VAO == 0)
-            return;
-
-        glGenVertexArrays(1, &m_VAO);
-        glGenBuffers(1, &m_VBO);
-
-        glBindVertexArray(m_VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vec2), (GLvoid *)0);
-        glEnableVertexAttribArray(0);
-
-        glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(Vec2), nullptr, GL_STATIC_DRAW);
+        update(std::vector<VERTEX>(vertices.begin(), vertices.end()));
+    }
 
-        glBindBuffer(GL_COPY_READ_BUFFER, other.m_VBO);
-        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_ARRAY_BUFFER, 0, 0, m_vertices.size() * sizeof(Vec2));
+    //==========================================================================
+    BasicPolygon(const BasicPolygon & other) :
+        m_dirty{ true },
+        m_vertices{ other.m_vertices },
+        m_view{ other.m_view },
+        m_view_size{ other.m_view_size }
+    {
     }
 
     //==========================================================================
-    Polygon(Polygon && other) :
-        m_VAO{ other.m_VAO },
-        m_VBO{ other.m_VBO },
-        m_vertices{ std::move(other.m_vertices) }
+    BasicPolygon(BasicPolygon && other) noexcept :
+        m_VAO{ std::move(other.m_VAO) },
+        m_VBO{ std::move(other.m_VBO) },
+        m_dirty{ other.m_dirty },
+        m_vertices{ std::move(other.m_vertices) },
+        m_view{ other.m_view },
+        m_view_size{ other.m_view_size }
     {
-        other.m_VAO = 0;
-        other.m_VBO = 0;
+        other.m_dirty = false;
+        other.m_view = nullptr;
+        other.m_view_size = 0;
     }
 
     //==========================================================================
-    Polygon & operator = (const Polygon & other)
+    BasicPolygon & operator = (const BasicPolygon & other)
     {
-        Polygon tmp{ other };
+        BasicPolygon tmp{ other };
         *this = std::move(tmp);
         return *this;
     }
 
     //==========================================================================
-    Polygon & operator = (Polygon && other)
+    BasicPolygon & operator = (BasicPolygon && other)
     {
-        glDeleteVertexArrays(1, &m_VAO);
-        glDeleteBuffers(1, &m_VBO);
-
-        m_VAO = other.m_VAO;
-        m_VBO = other.m_VBO;
+        m_VAO = std::move(other.m_VAO);
+        m_VBO = std::move(other.m_VBO);
+        m_dirty = other.m_dirty;
         m_vertices = std::move(other.m_vertices);
+        m_view = other.m_view;
+        m_view_size = other.m_view_size;
 
-        other.m_VAO = 0;
-        other.m_VBO = 0;
+        other.m_dirty = false;
+        other.m_view = nullptr;
+        other.m_view_size = 0;
 
         return *this;
     }
 
     //==========================================================================
-    ~Polygon()
+    void update(const std::vector<VERTEX> & vertices)
     {
-        glDeleteVertexArrays(1, &m_VAO);
-        glDeleteBuffers(1, &m_VBO);
-
-        m_VAO = 0;
-        m_VBO = 0;
+        update(vertices.data(), vertices.size());
     }
 
     //==========================================================================
-    void update(const std::vector<Vec2> & vertices)
+    void update(const VERTEX * vertices, std::size_t count)
     {
-        m_vertices = std::move(vertices); // this will not move
-
-        if (m_vertices.size() == 0)
-        {
-            glDeleteVertexArrays(1, &m_VAO);
-            glDeleteBuffers(1, &m_VBO);
+        m_vertices.assign(vertices, vertices + count);
+        m_view = nullptr;
+        m_view_size = 0;
+        m_dirty = true;
+    }
 
-            m_VAO = 0;
-            m_VBO = 0;
+    //==========================================================================
+    // Uses count vertices at vertices without copying them, they have to stay
+    // alive and unchanged as long as the polygon refers to them
+    void view(const VERTEX * vertices, std::size_t count)
+    {
+        std::vector<VERTEX>{}.swap(m_vertices);
+        m_view = vertices;
+        m_view_size = count;
+        m_dirty = true;
+    }
 
+    //==========================================================================
+    void draw() const
+    {
+        const GLuint vertex_array = vertexArray();
+        if (vertex_array == 0)
             return;
-        }
 
-        if (m_VAO == 0)
-        {
-            assert(m_VBO == 0);
-
-            glGenVertexArrays(1, &m_VAO);
-            glGenBuffers(1, &m_VBO);
-
-            glBindVertexArray(m_VAO);
-            glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-
-            glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vec2), (GLvoid *)0);
-            glEnableVertexAttribArray(0);
-        }
-        else
-        {
-            glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-        }
-
-        glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(Vec2), m_vertices.data(), GL_STATIC_DRAW);
+        glBindVertexArray(vertex_array);
+        glDrawArrays(MODE, 0, static_cast<GLsizei>(size()));
     }
 
     //==========================================================================
-    void draw() const
+    // Uploads first if changed, 0 for an empty polygon
+    GLuint vertexArray() const
     {
-        if (m_VAO == 0)
-        {
-            assert(m_VBO == 0);
-            return;
-        }
+        if (m_dirty)
+            upload();
+
+        assert(m_VAO || !m_VBO);
+        return m_VAO.get();
+    }
 
-        glBindVertexArray(m_VAO);
 #ifdef SOLID_COLOR
-        glDrawArrays(GL_TRIANGLE_FAN, 0, static_cast<GLsizei>(m_vertices.size()));
+    static constexpr GLenum MODE = GL_TRIANGLE_FAN;
 #else
-        glDrawArrays(GL_LINE_LOOP, 0, static_cast<GLsizei>(m_vertices.size()));
+    static constexpr GLenum MODE = GL_LINE_LOOP;
 #endif
-    }
 
     //==========================================================================
     std::size_t size() const
     {
-        return m_vertices.size();
+        return m_view != nullptr ? m_view_size : m_vertices.size();
     }
 
     //==========================================================================
-    const std::vector<Vec2> & vertices() const
+    const VERTEX * data() const
     {
-        return m_vertices;
+        return m_view != nullptr ? m_view : m_vertices.data();
     }
 
+    const VERTEX * begin() const { return data(); }
+    const VERTEX * end() const { return data() + size(); }
+
 private:
-    GLuint m_VAO{ 0 };
-    GLuint m_VBO{ 0 };
+    //==========================================================================
+    void upload() const
+    {
+        m_dirty = false;
+
+        if (size() == 0)
+        {
+            m_VAO.reset();
+            m_VBO.reset();
+            return;
+        }
 
-    std::vector<Vec2> m_vertices;
+        if (!m_VAO)
+        {
+            assert(!m_VBO);
+
+            m_VAO = VertexArrayHandle::create();
+            m_VBO = BufferHandle::create();
+
+            glBindVertexArray(m_VAO.get());
+            glBindBuffer(GL_ARRAY_BUFFER, m_VBO.get());
+
+            set_vertex_attribute(data());
+            glEnableVertexAttribArray(0);
+        }
+        else
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, m_VBO.get());
+        }
+
+        glBufferData(GL_ARRAY_BUFFER, size() * sizeof(VERTEX), data(), GL_STATIC_DRAW);
+    }
+
+    // GL objects are created lazily from draw(), never without a GL context
+    mutable VertexArrayHandle m_VAO;
+    mutable BufferHandle m_VBO;
+    mutable bool m_dirty{ false };
+
+    std::vector<VERTEX> m_vertices;
+
+    // vertices owned elsewhere, see view()
+    const VERTEX * m_view{ nullptr };
+    std::size_t m_view_size{ 0 };
 
 };
+
+template <typename VERTEX>
+constexpr GLenum BasicPolygon<VERTEX>::MODE;
+
+using Polygon = BasicPolygon<Vec2>;
+
+// rock outlines as generated, shader/rock.vert expands them
+using PolarPolygon = BasicPolygon<PolarVertex>;
@@ -2,20 +2,24 @@
 
 #include <GL/gl3w.h>
 
-#include <vector>
+#include <array>
 #include <cassert>
+#include <algorithm>
+#include <cmath>
 
 #include "Vec2.hpp"
 #include "AABB.hpp"
 #include "Polygon.hpp"
+#include "BodyId.hpp"
+#include "WorldSave.hpp"
 
-static const std::vector<Vec2> DEFAULT_PROJECTILE_MODEL
-{
+static constexpr std::array<Vec2, 4> DEFAULT_PROJECTILE_MODEL
+{{
     { -1.0f, -1.0f },
     {  1.0f, -1.0f },
     {  1.0f,  1.0f },
     { -1.0f,  1.0f },
-};
+}};
 
 class Projectile
 {
@@ -25,11 +29,11 @@ public:
 
     //==========================================================================
     Projectile(Vec2 position, Vec2 velocity, Vec2 size, float life_time) :
+        m_id       { next_body_id() },
         m_size     { std::max(0.0f, size.x), std::max(0.0f, size.y) },
         m_position { position },
         m_velocity { velocity },
-        m_time_left{ std::max(0.0f, life_time) },
-        m_polygon  { DEFAULT_PROJECTILE_MODEL }
+        m_time_left{ std::max(0.0f, life_time) }
     {
         const auto angle = -std::atan2(m_velocity.y, m_velocity.x);
 
@@ -39,14 +43,27 @@ public:
         m_rotation_matrix[3] =  std::cos(angle);
 
         // calculate AABB
-        std::vector<Vec2> polygon = m_polygon.vertices();
+        auto polygon = DEFAULT_PROJECTILE_MODEL;
         // scale and rotate
         std::for_each(polygon.begin(), polygon.end(), [this](Vec2 & v){ v = multiply(v * m_size, m_rotation_matrix); });
 
-        const Vec2 size2 = AABB_to_size(compute_AABB_from_polygon(polygon));
+        const Vec2 size2 = AABB_to_size(compute_AABB_from_polygon(polygon.data(), polygon.size()));
         m_bounding_box = AABB{ { -size2.x, -size2.y }, size2 }; // symmetric AABB
     }
 
+    //==========================================================================
+    // Restores a saved projectile exactly
+    explicit Projectile(const SavedProjectile & saved) :
+        m_id       { saved.id },
+        m_size     { saved.size },
+        m_position { saved.position },
+        m_velocity { saved.velocity },
+        m_time_left{ saved.time_left },
+        m_bounding_box{ saved.box_min, saved.box_max }
+    {
+        std::copy(std::begin(saved.rotation_matrix), std::end(saved.rotation_matrix), std::begin(m_rotation_matrix));
+    }
+
     //==========================================================================
     Projectile & operator = (const Projectile & other)
     {
@@ -56,16 +73,17 @@ public:
     }
 
     //==========================================================================
-    Projectile(Projectile && other) :
+    Projectile(Projectile && other) noexcept :
+        m_id       { other.m_id },
         m_size     { other.m_size },
         m_position { other.m_position },
         m_velocity { other.m_velocity },
         m_time_left{ other.m_time_left },
-        m_polygon  { std::move(other.m_polygon) },
         m_bounding_box { other.m_bounding_box }
     {
         std::copy(std::begin(other.m_rotation_matrix), std::end(other.m_rotation_matrix), std::begin(m_rotation_matrix));
 
+        other.m_id        = 0;
         other.m_size      = Vec2{ 0.0f, 0.0f };
         other.m_position  = Vec2{ 0.0f, 0.0f };
         other.m_velocity  = Vec2{ 0.0f, 0.0f };
@@ -77,14 +95,15 @@ public:
     //==========================================================================
     Projectile & operator = (Projectile && other)
     {
+        m_id        = other.m_id;
         m_size      = other.m_size;
         m_position  = other.m_position;
         m_velocity  = other.m_velocity;
         m_time_left = other.m_time_left;
-        m_polygon   = std::move(other.m_polygon);
         m_bounding_box = other.m_bounding_box;
         std::copy(std::begin(other.m_rotation_matrix), std::end(other.m_rotation_matrix), std::begin(m_rotation_matrix));
 
+        other.m_id        = 0;
         other.m_size      = Vec2{ 0.0f, 0.0f };
         other.m_position  = Vec2{ 0.0f, 0.0f };
         other.m_velocity  = Vec2{ 0.0f, 0.0f };
@@ -114,26 +133,23 @@ public:
     }
 
     //==========================================================================
-    void draw(GLint scale_uniform, GLint rotation_uniform, GLint translation_uniform)
+    // Placement of the projectile model
+    DrawTransform transform() const
     {
         assert(m_time_left > 0.0f);
 
-        glUniform2f(scale_uniform, m_size.x, m_size.y);
-        glUniformMatrix2fv(rotation_uniform, 1, GL_FALSE, m_rotation_matrix);
-        glUniform2f(translation_uniform, m_position.x, m_position.y);
-
-        m_polygon.draw();
+        return DrawTransform{
+            m_size,
+            { m_rotation_matrix[0], m_rotation_matrix[1], m_rotation_matrix[2], m_rotation_matrix[3] },
+            m_position
+        };
     }
 
     //==========================================================================
-    void move(float delta_time)
+    void move(float delta_time, float world_size)
     {
-        // euler integration
-        m_position.x += m_velocity.x * delta_time;
-        m_position.y += m_velocity.y * delta_time;
-
-        // wrap/warp around
-        wrap_around(m_position, m_size);
+        // euler integration with wrap/warp around
+        integrate_wrapped(m_position, m_velocity, delta_time, m_size, world_size);
 
         m_time_left -= delta_time;
     }
@@ -148,34 +164,61 @@ public:
     }
 
     //==========================================================================
-    const std::vector<Vec2> & polygon() const
+    SavedProjectile save() const
+    {
+        SavedProjectile saved{};
+
+        saved.id = m_id;
+        saved.size = m_size;
+        saved.position = m_position;
+        saved.velocity = m_velocity;
+        saved.time_left = m_time_left;
+        saved.box_min = m_bounding_box.getMin();
+        saved.box_max = m_bounding_box.getMax();
+        std::copy(std::begin(m_rotation_matrix), std::end(m_rotation_matrix), std::begin(saved.rotation_matrix));
+
+        return saved;
+    }
+
+    //==========================================================================
+    std::uint32_t id() const { return m_id; }
+    const Vec2 & position() const { return m_position; }
+    const Vec2 & velocity() const { return m_velocity; }
+    const Vec2 & size() const { return m_size; }
+
+    //==========================================================================
+    const std::array<Vec2, 4> & polygon() const
     {
-        return m_polygon.vertices();
+        return DEFAULT_PROJECTILE_MODEL;
     }
 
     //==========================================================================
-    std::vector<Vec2> polygonSRT() const
+    std::array<Vec2, 4> polygonSRT() const
     {
-        const auto & vertices = m_polygon.vertices();
+        return polygonSRT(m_position, m_size, m_rotation_matrix);
+    }
 
-        std::vector<Vec2> result;
-        result.reserve(vertices.size());
+    //==========================================================================
+    // Outline of a projectile kept outside of a Projectile object
+    static std::array<Vec2, 4> polygonSRT(const Vec2 & position, const Vec2 & size, const float rotation_matrix[4])
+    {
+        std::array<Vec2, 4> result;
 
-        for (const auto & v : vertices)
-            result.emplace_back(multiply(v, m_rotation_matrix) * m_size + m_position);
+        for (std::size_t i = 0; i < result.size(); ++i)
+            result[i] = multiply(DEFAULT_PROJECTILE_MODEL[i], rotation_matrix) * size + position;
 
         return result;
     }
 
 private:
+    std::uint32_t m_id{ 0 };
+
     Vec2 m_size; // TODO: generalize Object (AABB size position velocity rotation matrix...)
     Vec2 m_position;
     Vec2 m_velocity;
 
     float m_time_left;
 
-    Polygon m_polygon;
-
     AABB m_bounding_box;
     float m_rotation_matrix[4];
 
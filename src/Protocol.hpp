@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+#include "Vec2.hpp"
+
+// Wire format of the client/server mode, every message is one UDP datagram
+// starting with PROTOCOL_MAGIC and a MessageType. Little endian throughout.
+//
+//     CONNECT   client -> server, repeated until accepted
+//     ACCEPT    u8 ship index, f32 tick rate
+//     INPUT     u32 sequence, u32 client time (us), u32 newest applied snapshot,
+//               u32 applied bits (bit i: snapshot newest - 1 - i), u32 action bitmask
+//     SNAPSHOT  u32 sequence, u32 baseline sequence (0 = none), u32 world tick,
+//               u32 echoed client time, u8 own ship,
+//               u8 ship count, per ship a change mask and the changed quantized fields,
+//               u16 + u32[] removed rocks, u16 + u32[] removed projectiles,
+//               u16 + added projectiles, u16 + added rocks
+//
+// Snapshots are deltas against the newest snapshot the server knows the
+// client applied. From the applied bits the server replays exactly which
+// bodies the client knows. Rocks and projectiles move in straight lines, so
+// they are sent once with their exact state when they appear and the client
+// dead reckons them with the same integration as the server, after that only
+// their removal is sent. A body whose snapshot was lost is sent again.
+// Bandwidth therefore depends on how many bodies appear and disappear, not
+// on how many exist. Ships are steered and sent quantized every snapshot
+// in which they changed.
+
+constexpr std::uint32_t PROTOCOL_MAGIC = 0x31545341; // "AST1"
+
+// payload budget of one datagram, stays below a typical 1500 byte MTU
+constexpr std::size_t MAX_DATAGRAM_SIZE = 1400;
+constexpr std::size_t DEFAULT_SNAPSHOT_BUDGET = 1200;
+
+// header, a full ship section and the section counts always fit the smallest budget
+constexpr std::size_t MAX_SHIPS = 64;
+
+// older snapshots the applied bits of an input cover
+constexpr std::uint32_t APPLIED_BITS = 32;
+constexpr std::size_t MIN_SNAPSHOT_BUDGET = 32 + MAX_SHIPS * 8 + 8;
+
+enum class MessageType : std::uint8_t { CONNECT = 1, ACCEPT = 2, INPUT = 3, SNAPSHOT = 4 };
+
+// change mask bits of a ship in a snapshot
+enum : std::uint8_t { SHIP_POSITION = 1, SHIP_ANGLE = 2, SHIP_FLAGS = 4 };
+
+// ship flags
+enum : std::uint8_t { SHIP_DESTROYED = 1, SHIP_INVINCIBLE = 2 };
+
+// rock vertices are sent as signed bytes in model space
+constexpr float ROCK_VERTEX_SCALE = 127.0f;
+
+// positions are quantized to [-2, 2], net play keeps the unit world
+constexpr float NET_WORLD_SIZE = 1.0f;
+
+//==============================================================================
+// Ship state as sent on the wire
+struct NetShip
+{
+    std::uint16_t x{ 0 };
+    std::uint16_t y{ 0 };
+    std::uint16_t angle{ 0 };
+    std::uint8_t flags{ 0 };
+
+    bool operator == (const NetShip & o) const { return x == o.x && y == o.y && angle == o.angle && flags == o.flags; }
+
+    // positions are in [-2, 2], ships wrap a little past the [-1, 1] view
+    static std::uint16_t quantizePosition(float v)
+    {
+        const float clamped = std::fmin(2.0f, std::fmax(-2.0f, v));
+        return static_cast<std::uint16_t>(std::lround((clamped + 2.0f) / 4.0f * 65535.0f));
+    }
+
+    static float position(std::uint16_t q) { return static_cast<float>(q) / 65535.0f * 4.0f - 2.0f; }
+
+    static std::uint16_t quantizeAngle(float radians)
+    {
+        const float turns = radians / 6.2831853f;
+        return static_cast<std::uint16_t>(std::lround((turns - std::floor(turns)) * 65536.0f) & 0xFFFF);
+    }
+
+    static float angleRadians(std::uint16_t q) { return static_cast<float>(q) / 65536.0f * 6.2831853f; }
+
+    Vec2 position() const { return { position(x), position(y) }; }
+    Vec2 direction() const { const float a = angleRadians(angle); return { std::cos(a), std::sin(a) }; }
+};
+
+//==============================================================================
+// Bounded little endian writer, sets a flag instead of writing past the end
+class ByteWriter
+{
+public:
+    ByteWriter(std::uint8_t * data, std::size_t capacity) : m_data{ data }, m_capacity{ capacity } {}
+
+    void u8 (std::uint8_t v)  { put(&v, 1); }
+    void u16(std::uint16_t v) { const std::uint8_t b[]{ std::uint8_t(v), std::uint8_t(v >> 8) }; put(b, 2); }
+    void u32(std::uint32_t v) { const std::uint8_t b[]{ std::uint8_t(v), std::uint8_t(v >> 8), std::uint8_t(v >> 16), std::uint8_t(v >> 24) }; put(b, 4); }
+    void f32(float v)         { std::uint32_t u; std::memcpy(&u, &v, 4); u32(u); }
+
+    // Overwrites a u16 written earlier, for counts only known after the items
+    void u16At(std::size_t offset, std::uint16_t v) { m_data[offset] = std::uint8_t(v); m_data[offset + 1] = std::uint8_t(v >> 8); }
+
+    std::size_t size() const { return m_size; }
+    std::size_t remaining() const { return m_capacity - m_size; }
+    bool overflow() const { return m_overflow; }
+
+private:
+    void put(const std::uint8_t * bytes, std::size_t count)
+    {
+        if (count > remaining()) { m_overflow = true; return; }
+        std::memcpy(m_data + m_size, bytes, count);
+        m_size += count;
+    }
+
+    std::uint8_t * m_data;
+    std::size_t m_capacity;
+    std::size_t m_size{ 0 };
+    bool m_overflow{ false };
+
+};
+
+//==============================================================================
+// Bounded little endian reader, reads zeros and sets a flag past the end
+class ByteReader
+{
+public:
+    ByteReader(const std::uint8_t * data, std::size_t size) : m_data{ data }, m_size{ size } {}
+
+    std::uint8_t  u8 ()  { std::uint8_t b[1]{}; get(b, 1); return b[0]; }
+    std::uint16_t u16()  { std::uint8_t b[2]{}; get(b, 2); return std::uint16_t(b[0] | b[1] << 8); }
+    std::uint32_t u32()  { std::uint8_t b[4]{}; get(b, 4); return std::uint32_t(b[0]) | std::uint32_t(b[1]) << 8 | std::uint32_t(b[2]) << 16 | std::uint32_t(b[3]) << 24; }
+    float f32()          { const std::uint32_t u = u32(); float v; std::memcpy(&v, &u, 4); return v; }
+
+    bool ok() const { return m_overflow == false; }
+
+private:
+    void get(std::uint8_t * bytes, std::size_t count)
+    {
+        if (count > m_size - m_offset) { m_overflow = true; m_offset = m_size; return; }
+        std::memcpy(bytes, m_data + m_offset, count);
+        m_offset += count;
+    }
+
+    const std::uint8_t * m_data;
+    std::size_t m_size;
+    std::size_t m_offset{ 0 };
+    bool m_overflow{ false };
+
+};
+
+//==============================================================================
+inline void write_header(ByteWriter & w, MessageType type)
+{
+    w.u32(PROTOCOL_MAGIC);
+    w.u8(static_cast<std::uint8_t>(type));
+}
+
+//==============================================================================
+// Returns false if the datagram is not from this protocol
+inline bool read_header(ByteReader & r, MessageType & type)
+{
+    if (r.u32() != PROTOCOL_MAGIC)
+        return false;
+
+    type = static_cast<MessageType>(r.u8());
+    return r.ok();
+}
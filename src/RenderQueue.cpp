@@ -0,0 +1,220 @@
+#include "RenderQueue.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+//==============================================================================
+std::uint8_t GlStateCache::addProgram(const Shader & shader)
+{
+    assert(m_programs.size() < 256);
+
+    Program program{};
+    program.id = shader.id();
+    program.locations[COLOR]            = glGetUniformLocation(shader.id(), "color");
+    program.locations[SCALE]            = glGetUniformLocation(shader.id(), "scale");
+    program.locations[ROTATION]         = glGetUniformLocation(shader.id(), "rotation");
+    program.locations[TRANSLATION]      = glGetUniformLocation(shader.id(), "translation");
+    program.locations[VIEW_TRANSLATION] = glGetUniformLocation(shader.id(), "view_translation");
+    program.locations[VIEW_SCALE]       = glGetUniformLocation(shader.id(), "view_scale");
+    program.locations[VIEWPORT]         = glGetUniformLocation(shader.id(), "viewport");     // -1 without line AA
+
+    m_programs.push_back(program);
+
+    return static_cast<std::uint8_t>(m_programs.size() - 1);
+}
+
+//==============================================================================
+void GlStateCache::invalidate()
+{
+    m_program = -1;
+    m_vertex_array_known = false;
+
+    for (auto & p : m_programs)
+        p.known.fill(false);
+}
+
+//==============================================================================
+void GlStateCache::useProgram(std::uint8_t slot)
+{
+    if (m_program == slot)
+    {
+        m_statistics.avoided++;
+        return;
+    }
+
+    glUseProgram(m_programs[slot].id);
+    m_program = slot;
+    m_statistics.changes++;
+}
+
+//==============================================================================
+void GlStateCache::bindVertexArray(GLuint vertex_array)
+{
+    if (m_vertex_array_known && m_vertex_array == vertex_array)
+    {
+        m_statistics.avoided++;
+        return;
+    }
+
+    glBindVertexArray(vertex_array);
+    m_vertex_array = vertex_array;
+    m_vertex_array_known = true;
+    m_statistics.changes++;
+}
+
+//==============================================================================
+bool GlStateCache::change(Uniform u, const float * value, std::size_t count)
+{
+    assert(m_program >= 0);
+
+    auto & program = m_programs[static_cast<std::size_t>(m_program)];
+    auto & stored = program.values[u];
+
+    // uniforms the program doesn't have cost nothing either way
+    if (program.locations[u] < 0)
+        return false;
+
+    if (program.known[u] && std::equal(value, value + count, stored.begin()))
+    {
+        m_statistics.avoided++;
+        return false;
+    }
+
+    std::copy(value, value + count, stored.begin());
+    program.known[u] = true;
+    m_statistics.changes++;
+
+    return true;
+}
+
+//==============================================================================
+void GlStateCache::setColor(const Color & color)
+{
+    const float value[3] = { color.r, color.g, color.b };
+    if (change(COLOR, value, 3))
+        glUniform3f(m_programs[m_program].locations[COLOR], color.r, color.g, color.b);
+}
+
+//==============================================================================
+void GlStateCache::setTransform(const DrawTransform & transform)
+{
+    const auto & locations = m_programs[m_program].locations;
+
+    const float scale[2] = { transform.scale.x, transform.scale.y };
+    if (change(SCALE, scale, 2))
+        glUniform2f(locations[SCALE], transform.scale.x, transform.scale.y);
+
+    if (change(ROTATION, transform.rotation, 4))
+        glUniformMatrix2fv(locations[ROTATION], 1, GL_FALSE, transform.rotation);
+
+    const float translation[2] = { transform.translation.x, transform.translation.y };
+    if (change(TRANSLATION, translation, 2))
+        glUniform2f(locations[TRANSLATION], transform.translation.x, transform.translation.y);
+}
+
+//==============================================================================
+void GlStateCache::setViewTranslation(const Vec2 & translation)
+{
+    const float value[2] = { translation.x, translation.y };
+    if (change(VIEW_TRANSLATION, value, 2))
+        glUniform2f(m_programs[m_program].locations[VIEW_TRANSLATION], translation.x, translation.y);
+}
+
+//==============================================================================
+void GlStateCache::setViewScale(float scale)
+{
+    if (change(VIEW_SCALE, &scale, 1))
+        glUniform1f(m_programs[m_program].locations[VIEW_SCALE], scale);
+}
+
+//==============================================================================
+void GlStateCache::setViewport(float width, float height)
+{
+    const float value[2] = { width, height };
+    if (change(VIEWPORT, value, 2))
+        glUniform2f(m_programs[m_program].locations[VIEWPORT], width, height);
+}
+
+//==============================================================================
+void GlStateCache::draw(GLenum mode, GLsizei count)
+{
+    glDrawArrays(mode, 0, count);
+    m_statistics.draws++;
+}
+
+//==============================================================================
+void RenderQueue::clear()
+{
+    m_items.clear();
+    m_palette.clear();
+    m_order.clear();
+}
+
+//==============================================================================
+std::uint16_t RenderQueue::colorIndex(const Color & color)
+{
+    for (std::size_t i = 0; i < m_palette.size(); ++i)
+    {
+        if (m_palette[i].r == color.r && m_palette[i].g == color.g && m_palette[i].b == color.b)
+            return static_cast<std::uint16_t>(i);
+    }
+
+    assert(m_palette.size() < 65536);
+    m_palette.push_back(color);
+
+    return static_cast<std::uint16_t>(m_palette.size() - 1);
+}
+
+//==============================================================================
+void RenderQueue::draw(std::uint8_t layer, std::uint8_t program, GLuint vertex_array, std::size_t count, const Color & color,
+                       const DrawTransform & transform, const Vec2 & view_translation)
+{
+    if (vertex_array == 0)
+        return;
+
+    const auto c = colorIndex(color);
+
+    // layer, program, mesh, color from the most significant bits down
+    const std::uint64_t key =
+        std::uint64_t{ layer } << 56 |
+        std::uint64_t{ program } << 48 |
+        std::uint64_t{ vertex_array } << 16 |
+        std::uint64_t{ c };
+
+    m_order.emplace_back(key, static_cast<std::uint32_t>(m_items.size()));
+    m_items.push_back(Item{ vertex_array, static_cast<GLsizei>(count), c, program, transform, view_translation });
+}
+
+//==============================================================================
+void RenderQueue::submit(GlStateCache & cache, const std::function<void(std::uint8_t layer, bool begin)> & on_layer)
+{
+    // the index breaks ties, equal keys keep their recording order
+    std::sort(m_order.begin(), m_order.end());
+
+    int layer = -1;
+
+    for (const auto & o : m_order)
+    {
+        const auto item_layer = static_cast<int>(o.first >> 56);
+        if (item_layer != layer)
+        {
+            if (layer >= 0)
+                on_layer(static_cast<std::uint8_t>(layer), false);
+
+            layer = item_layer;
+            on_layer(static_cast<std::uint8_t>(layer), true);
+        }
+
+        const auto & item = m_items[o.second];
+
+        cache.useProgram(item.program);
+        cache.bindVertexArray(item.vertex_array);
+        cache.setColor(m_palette[item.color]);
+        cache.setTransform(item.transform);
+        cache.setViewTranslation(item.view_translation);
+        cache.draw(Polygon::MODE, item.count);
+    }
+
+    if (layer >= 0)
+        on_layer(static_cast<std::uint8_t>(layer), false);
+}
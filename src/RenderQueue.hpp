@@ -0,0 +1,124 @@
+#pragma once
+
+#include <GL/gl3w.h>
+
+#include <array>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+#include "Vec2.hpp"
+#include "Polygon.hpp"
+#include "Shader.hpp"
+
+struct Color
+{
+    float r, g, b;
+};
+
+// GL state of the line shader programs as last set through it. Binds and
+// uniform uploads that would not change anything are skipped and counted, so
+// the effect of sorting the draws is visible. GL calls that go around the
+// cache (particles, HUD, another program) leave it wrong, invalidate() makes
+// it issue everything again.
+class GlStateCache
+{
+public:
+    struct Statistics
+    {
+        std::uint64_t draws{ 0 };
+        std::uint64_t changes{ 0 };     // program and vertex array binds and uniform uploads issued
+        std::uint64_t avoided{ 0 };     // the same, skipped as redundant
+    };
+
+    // Uniform locations of a program made from line.vert, returns its slot
+    std::uint8_t addProgram(const Shader & shader);
+
+    void invalidate();
+
+    void useProgram(std::uint8_t slot);
+    void bindVertexArray(GLuint vertex_array);
+
+    // uniforms of the program in use
+    void setColor(const Color & color);
+    void setTransform(const DrawTransform & transform);
+    void setViewTranslation(const Vec2 & translation);
+    void setViewScale(float scale);
+    void setViewport(float width, float height);
+
+    void draw(GLenum mode, GLsizei count);
+
+    const Statistics & statistics() const { return m_statistics; }
+    void resetStatistics() { m_statistics = Statistics{}; }
+
+private:
+    enum Uniform : std::size_t { COLOR, SCALE, ROTATION, TRANSLATION, VIEW_TRANSLATION, VIEW_SCALE, VIEWPORT, UNIFORM_COUNT };
+
+    struct Program
+    {
+        GLuint id;
+        std::array<GLint, UNIFORM_COUNT> locations;
+        std::array<std::array<float, 4>, UNIFORM_COUNT> values;
+        std::array<bool, UNIFORM_COUNT> known;
+    };
+
+    // Stores the value of u of the program in use, false if it already had it
+    bool change(Uniform u, const float * value, std::size_t count);
+
+    std::vector<Program> m_programs;
+    int m_program{ -1 };                // slot in use, -1 unknown
+    GLuint m_vertex_array{ 0 };
+    bool m_vertex_array_known{ false };
+
+    Statistics m_statistics;
+
+};
+
+// Line shader draws of a frame, recorded in any order and submitted sorted by
+// a key of layer, program, mesh and color, so bodies sharing a mesh or a
+// color are drawn back to back and the state cache skips what they share.
+// Layers keep the draw groups in order (and apart for the GPU profiler), the
+// sort only reorders draws inside a layer, equal keys in recording order.
+class RenderQueue
+{
+public:
+    void clear();
+
+    // mesh is uploaded here if it changed, empty meshes are dropped
+    template <typename VERTEX>
+    void draw(std::uint8_t layer, std::uint8_t program, const BasicPolygon<VERTEX> & mesh, const Color & color,
+              const DrawTransform & transform, const Vec2 & view_translation)
+    {
+        draw(layer, program, mesh.vertexArray(), mesh.size(), color, transform, view_translation);
+    }
+
+    void draw(std::uint8_t layer, std::uint8_t program, GLuint vertex_array, std::size_t count, const Color & color,
+              const DrawTransform & transform, const Vec2 & view_translation);
+
+    // Issues the draws through cache, on_layer(layer, true) comes before the
+    // first draw of a layer and on_layer(layer, false) after its last
+    void submit(GlStateCache & cache, const std::function<void(std::uint8_t layer, bool begin)> & on_layer);
+
+    std::size_t size() const { return m_items.size(); }
+
+private:
+    struct Item
+    {
+        GLuint vertex_array;
+        GLsizei count;
+        std::uint16_t color;
+        std::uint8_t program;
+        DrawTransform transform;
+        Vec2 view_translation;
+    };
+
+    // index of color in the palette of the frame, a handful of colors per frame
+    std::uint16_t colorIndex(const Color & color);
+
+    std::vector<Item> m_items;
+    std::vector<Color> m_palette;
+
+    // sort key and item index, sorted instead of the items
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> m_order;
+
+};
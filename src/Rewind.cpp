@@ -0,0 +1,67 @@
+#include "Rewind.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_set>
+
+//==============================================================================
+RewindBuffer::RewindBuffer(std::size_t capacity) :
+    m_snapshots(capacity)
+{
+    if (capacity < 2)
+        throw std::runtime_error("Rewind buffer needs room for at least 2 ticks.");
+}
+
+//==============================================================================
+void RewindBuffer::record(const World & world)
+{
+    const auto capacity = m_snapshots.size();
+
+    auto & slot = m_snapshots[(m_first + m_size) % capacity];
+
+    if (m_size == capacity)
+        m_first = (m_first + 1) % capacity;
+    else
+        m_size++;
+
+    world.snapshot(slot);
+}
+
+//==============================================================================
+std::size_t RewindBuffer::rewind(World & world, std::size_t ticks)
+{
+    if (m_size == 0)
+        return 0;
+
+    ticks = std::min(ticks, m_size - 1);
+
+    m_size -= ticks;
+    world.restore(at(m_size - 1));
+
+    return ticks;
+}
+
+//==============================================================================
+std::size_t RewindBuffer::memoryBytes() const
+{
+    std::size_t bytes = m_snapshots.capacity() * sizeof(World::Snapshot);
+
+    for (const auto & s : m_snapshots)
+        bytes += s.memoryBytes() - sizeof(World::Snapshot);
+
+    return bytes;
+}
+
+//==============================================================================
+std::size_t RewindBuffer::sharedShapeBytes() const
+{
+    std::unordered_set<const RockShape *> shapes;
+    std::size_t bytes = 0;
+
+    for (std::size_t i = 0; i < m_size; ++i)
+        for (const auto & rock : at(i).rocks)
+            if (shapes.insert(&rock.shape()).second)
+                bytes += rock.shape().memoryBytes();
+
+    return bytes;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+
+#include "World.hpp"
+
+// Ring of world snapshots, one per recorded tick, to step the simulation back
+// by up to capacity - 1 ticks. Slots keep their storage when they are reused,
+// so recording stops allocating once the ring has gone around and the body
+// counts have settled.
+class RewindBuffer
+{
+public:
+    explicit RewindBuffer(std::size_t capacity);
+
+    // Snapshot of the world after its latest tick, overwrites the oldest one when full
+    void record(const World & world);
+
+    // Restores the world as it was ticks recorded ticks ago and forgets the
+    // newer ones. Clamped to the oldest snapshot, returns the ticks rewound.
+    std::size_t rewind(World & world, std::size_t ticks);
+
+    std::size_t size() const { return m_size; }
+    std::size_t capacity() const { return m_snapshots.size(); }
+    void clear() { m_size = 0; }
+
+    // Tick count of the world in the oldest and the newest snapshot, size() must not be 0
+    std::uint64_t oldestTick() const { return at(0).tick_count; }
+    std::uint64_t newestTick() const { return at(m_size - 1).tick_count; }
+
+    // Bytes held by all slots, the rock shapes they share with the world not included
+    std::size_t memoryBytes() const;
+
+    // Bytes of the distinct rock shapes referenced by the snapshots, walks every rock
+    std::size_t sharedShapeBytes() const;
+
+private:
+    const World::Snapshot & at(std::size_t i) const { return m_snapshots[(m_first + i) % m_snapshots.size()]; }
+
+    std::vector<World::Snapshot> m_snapshots;
+    std::size_t m_first{ 0 };
+    std::size_t m_size{ 0 };
+
+};
+
+//==============================================================================
+// Slots needed to go back seconds, the current tick takes one
+inline std::size_t rewind_capacity(float seconds, float tick_rate)
+{
+    return static_cast<std::size_t>(std::ceil(seconds * tick_rate)) + 1;
+}
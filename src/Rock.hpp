@@ -1,74 +1,191 @@
 #pragma once
 
+#include <cmath>
 #include <vector>
+#include <memory>
+#include <mutex>
 #include <algorithm>
 
 #include "Vec2.hpp"
 #include "Vec2Gen.hpp"
 #include "AABB.hpp"
 #include "Polygon.hpp"
+#include "PolarVertex.hpp"
+#include "SmallVector.hpp"
+#include "Collision.hpp"
+#include "BodyId.hpp"
+#include "Arena.hpp"
+#include "WorldSave.hpp"
 
 #include <GL/gl3w.h>
 
+// rocks up to this vertex count are transformed without touching the heap
+constexpr std::size_t ROCK_INLINE_VERTICES = 16;
+
+// Outline and convex hull of a rock. Never changes after the rock is made,
+// so every copy of a rock (rewind snapshots) shares it instead of copying
+// vertices, and the GPU copy of the outline is made once. The outline stays
+// in the quantized polar form it is generated in and the hull is a list of
+// outline indices. The float vertices and hull normals the collision tests
+// need are expanded on first use and kept, rocks that never come near a ship
+// or a projectile never have them. Shapes of a loaded save refer to the
+// block World::load keeps all of them in instead of copies of their own.
+struct RockShape
+{
+    // Convex hull as outline indices, in the shape or in a loaded block
+    struct HullIndices
+    {
+        const std::uint16_t * indices{ nullptr };
+        std::size_t count{ 0 };
+
+        const std::uint16_t * begin() const { return indices; }
+        const std::uint16_t * end() const { return indices + count; }
+        std::size_t size() const { return count; }
+    };
+
+    struct Expanded
+    {
+        std::vector<Vec2> outline;
+        std::vector<Vec2> hull;
+        std::vector<Vec2> hull_normals;
+    };
+
+    PolarPolygon polygon;
+    HullIndices hull;
+
+    //==========================================================================
+    // Copies the hull indices into the shape
+    void setHull(const std::uint16_t * indices, std::size_t count)
+    {
+        m_hull_storage.assign(indices, indices + count);
+        hull = HullIndices{ m_hull_storage.data(), m_hull_storage.size() };
+    }
+
+    //==========================================================================
+    // Safe to call from several threads, the first call expands
+    const Expanded & expanded() const
+    {
+        std::call_once(m_expand_once, [this]
+        {
+            auto e = std::make_unique<Expanded>();
+
+            e->outline.reserve(polygon.size());
+            for (const auto & v : polygon)
+                e->outline.push_back(decode_polar(v));
+
+            e->hull.reserve(hull.size());
+            for (const auto i : hull)
+                e->hull.push_back(e->outline[i]);
+
+            e->hull_normals = hull_normals(e->hull);
+
+            m_expanded = std::move(e);
+        });
+
+        return *m_expanded;
+    }
+
+    //==========================================================================
+    // Heap and object bytes of the shape, the expansion included once made
+    std::size_t memoryBytes() const
+    {
+        std::size_t bytes = sizeof(RockShape) + polygon.size() * sizeof(PolarVertex) + hull.size() * sizeof(std::uint16_t);
+
+        if (m_expanded)
+            bytes += sizeof(Expanded) + (m_expanded->outline.size() + m_expanded->hull.size() + m_expanded->hull_normals.size()) * sizeof(Vec2);
+
+        return bytes;
+    }
+
+    bool isExpanded() const { return m_expanded != nullptr; }
+
+private:
+    std::vector<std::uint16_t> m_hull_storage;
+
+    mutable std::once_flag m_expand_once;
+    mutable std::unique_ptr<Expanded> m_expanded;
+};
 
 class Rock
 {
 public:
     //==========================================================================
-    Rock() {}
+    Rock() : m_shape{ emptyShape() } {}
 
     //==========================================================================
-    Rock(Vec2Gen & rng, float size, int vertex_count, Vec2 position, Vec2 velocity) :
+    // Temporaries are taken from arena if given
+    Rock(Vec2Gen & rng, float size, int vertex_count, Vec2 position, Vec2 velocity, MonotonicArena * arena = nullptr) :
+        m_id{ next_body_id() },
         m_size{ std::max(0.0f, size) },
         m_position{ position },
         m_velocity{ velocity }
     {
         vertex_count = std::max(4, vertex_count);
 
-        std::vector<Vec2> vertices;
-
-        vertices.reserve(static_cast<std::size_t>(vertex_count));
+        ArenaVector<Vec2> polar{ ArenaAllocator<Vec2>{ arena } };
 
         // generate normalized polar coordinates of vertices
-        for (int i = 0; i < vertex_count; ++i)
-            vertices.push_back(rng.get());
+        polar.resize(static_cast<std::size_t>(vertex_count));
+        rng.fill(polar.data(), polar.size());
 
-        assert(vertices.size() >= 4);
+        assert(polar.size() >= 4);
 
         // guarantee that at leas one point is inside of each quadrant
         for (int i = 0; i < 4; ++i)
-            vertices[i].y = vertices[i].y * 0.25f + static_cast<float>(i) * 0.25f;
+            polar[i].y = polar[i].y * 0.25f + static_cast<float>(i) * 0.25f;
 
-        // sort by polar angle
-        std::sort(vertices.begin(), vertices.end(),
-                  [](const Vec2 & a, const Vec2 & b) { return a.y < b.y; }
-        );
+        // quantize to the stored form and sort by polar angle
+        ArenaVector<PolarVertex> outline{ polar.size(), PolarVertex{}, ArenaAllocator<PolarVertex>{ arena } };
+        std::transform(polar.begin(), polar.end(), outline.begin(),
+                       [](const Vec2 & v) { return PolarVertex{ quantize_polar(v.x), quantize_polar(v.y) }; });
 
-        // convert normalized polar to cartesian coordinates
-        std::for_each(vertices.begin(), vertices.end(),
-                      [](Vec2 & v)
-                      {
-                          // * hardcoded size interpretation
-                          // * angle scale should be a little less than 2 x pi
-                          v = {
-                              (v.x * 0.3f + 0.7f) * std::cos(v.y * 6.283f),
-                              (v.x * 0.3f + 0.7f) * std::sin(v.y * 6.283f)
-                          };
-                      }
+        std::sort(outline.begin(), outline.end(),
+                  [](const PolarVertex & a, const PolarVertex & b) { return a.angle < b.angle; }
         );
 
-        m_polygon.update(vertices);
+        // cartesian coordinates, exactly what expanding the shape gives later
+        ArenaVector<Vec2> vertices{ outline.size(), Vec2{}, ArenaAllocator<Vec2>{ arena } };
+        std::transform(outline.begin(), outline.end(), vertices.begin(), decode_polar);
+
+        auto shape = std::make_shared<RockShape>();
+        shape->polygon.update(outline.data(), outline.size());
+
+        // convex hull as outline indices for the separating axis test, rocks
+        // are only scaled uniformly and translated so it stays valid
+        ArenaVector<std::uint16_t> hull{ ArenaAllocator<std::uint16_t>{ arena } };
+        for (const auto & h : convex_hull(vertices.data(), vertices.size(), arena))
+        {
+            const auto i = std::find_if(vertices.begin(), vertices.end(), [&h] (const Vec2 & v) { return v.x == h.x && v.y == h.y; });
+            assert(i != vertices.end());
+            hull.push_back(static_cast<std::uint16_t>(i - vertices.begin()));
+        }
+
+        shape->setHull(hull.data(), hull.size());
+        m_shape = std::move(shape);
 
         // calculate symmetric AABB
-        std::vector<Vec2> polygon = m_polygon.vertices();
+        ArenaVector<Vec2> polygon{ vertices.begin(), vertices.end(), ArenaAllocator<Vec2>{ arena } };
         // scale
         std::for_each(polygon.begin(), polygon.end(), [this](Vec2 & v){ v = v * m_size; });
 
-        const Vec2 size2 = AABB_to_size(compute_AABB_from_polygon(polygon));
+        const Vec2 size2 = AABB_to_size(compute_AABB_from_polygon(polygon.data(), polygon.size()));
         m_bounding_box = AABB{ { -size2.x, -size2.y }, size2 }; // symmetric AABB
 
     }
 
+    //==========================================================================
+    // Restores a saved rock exactly with its shape as loaded from the vertex
+    // and hull index sections, see World::load
+    Rock(const SavedRock & saved, std::shared_ptr<const RockShape> shape) :
+        m_id{ saved.id },
+        m_size{ saved.size },
+        m_position{ saved.position },
+        m_velocity{ saved.velocity },
+        m_shape{ std::move(shape) },
+        m_bounding_box{ saved.box_min, saved.box_max }
+    {
+    }
+
     //==========================================================================
     Rock & operator = (const Rock & other)
     {
@@ -78,13 +195,16 @@ public:
     }
 
     //==========================================================================
-    Rock(Rock && other) :
+    Rock(Rock && other) noexcept :
+        m_id      { other.m_id },
         m_size    { other.m_size },
         m_position{ other.m_position },
         m_velocity{ other.m_velocity },
-        m_polygon { std::move(other.m_polygon) },
-        m_bounding_box { other.m_bounding_box }
+        m_shape   { std::move(other.m_shape) },
+        m_bounding_box { other.m_bounding_box },
+        m_hit     { other.m_hit }
     {
+        other.m_id       = 0;
         other.m_size     = 0;
         other.m_position = Vec2{ 0.0f, 0.0f };
         other.m_velocity = Vec2{ 0.0f, 0.0f };
@@ -94,13 +214,16 @@ public:
     //==========================================================================
     Rock & operator = (Rock && other)
     {
+        m_id       = other.m_id;
         m_size     = other.m_size;
         m_position = other.m_position;
         m_velocity = other.m_velocity;
 
-        m_polygon = std::move(other.m_polygon);
+        m_shape = std::move(other.m_shape);
         m_bounding_box = other.m_bounding_box;
+        m_hit = other.m_hit;
 
+        other.m_id       = 0;
         other.m_size     = 0;
         other.m_position = Vec2{ 0.0f, 0.0f };
         other.m_velocity = Vec2{ 0.0f, 0.0f };
@@ -111,20 +234,17 @@ public:
     }
 
     //==========================================================================
+    // Shares the shape, copies a few floats
     Rock(const Rock & other) = default;
 
     //==========================================================================
     ~Rock() = default;
 
     //==========================================================================
-    void move(float delta_time)
+    void move(float delta_time, float world_size)
     {
-        // euler integration
-        m_position.x += m_velocity.x * delta_time;
-        m_position.y += m_velocity.y * delta_time;
-
-        // wrap/warp around
-        wrap_around(m_position, { m_size, m_size });
+        // euler integration with wrap/warp around
+        integrate_wrapped(m_position, m_velocity, delta_time, { m_size, m_size }, world_size);
     }
 
     //==========================================================================
@@ -137,26 +257,32 @@ public:
     }
 
     //==========================================================================
-    void draw(GLint translation_uniform, GLint scale_uniform) const
+    // Placement of the shape, rocks don't rotate
+    DrawTransform transform() const
     {
-        glUniform2f(scale_uniform, m_size, m_size);
-        glUniform2f(translation_uniform, m_position.x, m_position.y);
+        return DrawTransform{ { m_size, m_size }, { 1.0f, 0.0f, 0.0f, 1.0f }, m_position };
+    }
 
-        m_polygon.draw();
+    //==========================================================================
+    // Outline in the polar form, for shader/rock.vert
+    const PolarPolygon & mesh() const
+    {
+        return m_shape->polygon;
     }
 
     //==========================================================================
+    // Outline in model space, expands the shape
     const std::vector<Vec2> & polygon() const
     {
-        return m_polygon.vertices();
+        return m_shape->expanded().outline;
     }
 
     //==========================================================================
-    std::vector<Vec2> polygonSRT() const
+    SmallVector<Vec2, ROCK_INLINE_VERTICES> polygonSRT() const
     {
-        const auto & vertices = m_polygon.vertices();
+        const auto & vertices = m_shape->expanded().outline;
 
-        std::vector<Vec2> result;
+        SmallVector<Vec2, ROCK_INLINE_VERTICES> result;
         result.reserve(vertices.size());
 
         for (const auto & v : vertices)
@@ -166,38 +292,132 @@ public:
     }
 
     //==========================================================================
-    std::size_t size() const { return m_polygon.size(); }
+    SmallVector<Vec2, ROCK_INLINE_VERTICES> hullSRT() const
+    {
+        const auto & hull = m_shape->expanded().hull;
+
+        SmallVector<Vec2, ROCK_INLINE_VERTICES> result;
+        result.reserve(hull.size());
+
+        for (const auto & v : hull)
+            result.emplace_back(v * m_size + m_position);
+
+        return result;
+    }
 
     //==========================================================================
-    std::tuple<int, Rock, Rock> split(Vec2Gen & rng)
+    const std::vector<Vec2> & hullNormals() const { return m_shape->expanded().hull_normals; }
+    const RockShape & shape() const { return *m_shape; }
+    const std::shared_ptr<const RockShape> & sharedShape() const { return m_shape; }
+
+    // bounding box around the origin, boundingBox() adds the position
+    const AABB & modelBoundingBox() const { return m_bounding_box; }
+
+    //==========================================================================
+    bool convex() const { return m_shape->hull.size() == m_shape->polygon.size(); }
+
+    //==========================================================================
+    // Appends the outline and the hull as outline indices
+    SavedRock save(std::vector<PolarVertex> & vertices, std::vector<std::uint16_t> & hull_indices) const
     {
-        const auto size = m_polygon.size();
+        const auto & outline = m_shape->polygon;
+        const auto & hull = m_shape->hull;
+
+        SavedRock saved{};
+        saved.id = m_id;
+        saved.size = m_size;
+        saved.position = m_position;
+        saved.velocity = m_velocity;
+        saved.box_min = m_bounding_box.getMin();
+        saved.box_max = m_bounding_box.getMax();
+        saved.vertex_offset = static_cast<std::uint32_t>(vertices.size());
+        saved.hull_offset = static_cast<std::uint32_t>(hull_indices.size());
+        saved.vertex_count = static_cast<std::uint16_t>(outline.size());
+        saved.hull_count = static_cast<std::uint16_t>(hull.size());
+
+        vertices.insert(vertices.end(), outline.begin(), outline.end());
+        hull_indices.insert(hull_indices.end(), hull.begin(), hull.end());
+
+        return saved;
+    }
 
-        int count = 0;
+    //==========================================================================
+    std::uint32_t id() const { return m_id; }
+    const Vec2 & position() const { return m_position; }
+    const Vec2 & velocity() const { return m_velocity; }
+    float scale() const { return m_size; }
+
+    //==========================================================================
+    // Set by the narrow phase, hit rocks are split and removed in the same tick
+    bool isHit() const { return m_hit; }
+    void markHit() { m_hit = true; }
 
-        Rock rock[2];
+    //==========================================================================
+    std::size_t size() const { return m_shape->polygon.size(); }
+
+    //==========================================================================
+    // Appends the fragments of this rock to out and returns their count
+    template <typename Container>
+    int split(Vec2Gen & rng, Container & out, float speed = 0.15f, MonotonicArena * arena = nullptr) const
+    {
+        return split(rng, out, m_shape->polygon.size(), m_size, m_position, speed, arena);
+    }
 
-        if (size > 4)
+    //==========================================================================
+    // Split of a rock kept outside of a Rock object, vertex_count is its outline size
+    template <typename Container>
+    static int split(Vec2Gen & rng, Container & out, std::size_t vertex_count, float size, const Vec2 & position,
+                     float speed = 0.15f, MonotonicArena * arena = nullptr)
+    {
+        int count = 0;
+
+        if (vertex_count > 4)
         {
             count++;
-            rock[0] = Rock{ rng, m_size / 1.5f, m_polygon.size() / 2, m_position, (rng.get() * 2.0f - 1.0f) * 0.15f };
+            // velocity is drawn before the shape
+            const Vec2 velocity = (rng.get() * 2.0f - 1.0f) * speed;
+            out.emplace_back(rng, size / 1.5f, static_cast<int>(vertex_count / 2), position, velocity, arena);
         }
-        if (size > 7)
+        if (vertex_count > 7)
         {
             count++;
-            rock[1] = Rock{ rng, m_size / 1.5f, m_polygon.size() / 2, m_position, (rng.get() * 2.0f - 1.0f) * 0.15f };
+            const Vec2 velocity = (rng.get() * 2.0f - 1.0f) * speed;
+            out.emplace_back(rng, size / 1.5f, static_cast<int>(vertex_count / 2), position, velocity, arena);
         }
 
-        return std::make_tuple(count, rock[0], rock[1]);
+        return count;
+    }
+
+    //==========================================================================
+    // Most rocks a rock of vertex_count vertices is split into over its lifetime
+    static std::size_t maxFragments(std::size_t vertex_count)
+    {
+        vertex_count = std::max<std::size_t>(4, vertex_count);
+
+        if (vertex_count <= 4)
+            return 1;
+
+        return (vertex_count > 7 ? 2 : 1) * maxFragments(vertex_count / 2);
     }
 
 private:
+    //==========================================================================
+    static const std::shared_ptr<const RockShape> & emptyShape()
+    {
+        static const auto s_empty = std::make_shared<const RockShape>();
+        return s_empty;
+    }
+
+    std::uint32_t m_id{ 0 };
+
     float m_size; // TODO: class Object (vec2 size, vec2 position, vec2 velocity) and reuse it in all other similar classes (ship rock projectile)
     Vec2 m_position;
     Vec2 m_velocity;
 
-    Polygon m_polygon;
+    std::shared_ptr<const RockShape> m_shape;
 
     AABB m_bounding_box;
 
+    bool m_hit{ false };
+
 };
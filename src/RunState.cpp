@@ -0,0 +1,75 @@
+#include "RunState.hpp"
+
+#include <iostream>
+#include <iomanip>
+
+//==============================================================================
+const char * run_state_name(RunState state)
+{
+    if (state == RunState::RUNNING)
+        return "running";
+    if (state == RunState::BACKGROUND)
+        return "background";
+
+    return "paused";
+}
+
+//==============================================================================
+RunStateClock::RunStateClock() :
+    m_wall_start{ std::chrono::steady_clock::now() },
+    m_cpu_start{ std::clock() }
+{
+    m_entries[static_cast<std::size_t>(m_state)] = 1;
+}
+
+//==============================================================================
+void RunStateClock::charge()
+{
+    const auto wall = std::chrono::steady_clock::now();
+    const auto cpu = std::clock();
+
+    const auto s = static_cast<std::size_t>(m_state);
+    m_wall_seconds[s] += std::chrono::duration<double>{ wall - m_wall_start }.count();
+    m_cpu_seconds[s] += static_cast<double>(cpu - m_cpu_start) / CLOCKS_PER_SEC;
+
+    m_wall_start = wall;
+    m_cpu_start = cpu;
+}
+
+//==============================================================================
+bool RunStateClock::enter(RunState state)
+{
+    if (state == m_state)
+        return false;
+
+    charge();
+
+    m_state = state;
+    m_entries[static_cast<std::size_t>(state)]++;
+
+    return true;
+}
+
+//==============================================================================
+void RunStateClock::report()
+{
+    charge();
+
+    std::cout << "run states:" << std::endl;
+
+    for (std::size_t s = 0; s < RUN_STATE_COUNT; ++s)
+    {
+        if (m_entries[s] == 0)
+            continue;
+
+        const auto wall = m_wall_seconds[s];
+        const auto per_minute = wall > 0.0 ? m_cpu_seconds[s] / (wall / 60.0) : 0.0;
+
+        std::cout << "  " << std::left << std::setw(12) << run_state_name(static_cast<RunState>(s))
+                  << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(8) << wall << " s wall, "
+                  << std::setw(8) << m_cpu_seconds[s] << " s CPU, "
+                  << std::setw(6) << per_minute << " CPU s per minute, "
+                  << m_entries[s] << (m_entries[s] == 1 ? " time" : " times") << std::endl;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <ctime>
+#include <cstdint>
+
+// State of the interactive loop. An unfocused window stops the game and is
+// redrawn at the background frame rate, an iconified one draws nothing and
+// only waits for events.
+enum class RunState : std::uint8_t { RUNNING, BACKGROUND, PAUSED, COUNT };
+
+constexpr std::size_t RUN_STATE_COUNT = static_cast<std::size_t>(RunState::COUNT);
+
+const char * run_state_name(RunState state);
+
+// Wall time and process CPU time spent in every run state. CPU time is read
+// with std::clock only when the state changes, it covers all threads of the
+// process (workers, sector streaming), not just the loop.
+class RunStateClock
+{
+public:
+    RunStateClock();
+
+    RunState state() const { return m_state; }
+
+    // Charges the time since the previous change to the state left, returns true if state is a new one
+    bool enter(RunState state);
+
+    // Prints wall time, CPU time and CPU seconds per minute of every state that was entered
+    void report();
+
+private:
+    // adds the time since the previous charge to the current state
+    void charge();
+
+    RunState m_state{ RunState::RUNNING };
+    std::chrono::steady_clock::time_point m_wall_start;
+    std::clock_t m_cpu_start;
+
+    std::array<double, RUN_STATE_COUNT> m_wall_seconds{};
+    std::array<double, RUN_STATE_COUNT> m_cpu_seconds{};
+    std::array<std::uint32_t, RUN_STATE_COUNT> m_entries{};
+
+};
@@ -0,0 +1,443 @@
+#include "Scenario.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <functional>
+#include <map>
+#include <iomanip>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+namespace
+{
+    //==========================================================================
+    std::string trim(const std::string & s)
+    {
+        const auto begin = s.find_first_not_of(" \t\r\n");
+        if (begin == std::string::npos) return {};
+
+        const auto end = s.find_last_not_of(" \t\r\n");
+        return s.substr(begin, end - begin + 1);
+    }
+
+    //==========================================================================
+    template <typename T>
+    T parse_value(const std::string & key, const std::string & value)
+    {
+        std::istringstream stream{ value };
+        T result;
+
+        // streams wrap "-1" into an unsigned type instead of failing
+        const bool negative = trim(value).compare(0, 1, "-") == 0;
+
+        if ((std::is_unsigned<T>::value && negative) || !(stream >> result) || !(stream >> std::ws).eof())
+            throw std::runtime_error("Invalid value for " + key + ": " + value);
+
+        return result;
+    }
+
+    //==========================================================================
+    bool parse_bool(const std::string & key, const std::string & value)
+    {
+        if (value == "1" || value == "true"  || value == "on")  return true;
+        if (value == "0" || value == "false" || value == "off") return false;
+
+        throw std::runtime_error("Invalid value for " + key + ": " + value);
+    }
+
+    //==========================================================================
+    // "10:1, 6:0.5" (vertex count : weight)
+    std::vector<Scenario::VertexTier> parse_tiers(const std::string & key, const std::string & value)
+    {
+        std::vector<Scenario::VertexTier> tiers;
+
+        std::istringstream stream{ value };
+        std::string item;
+        while (std::getline(stream, item, ','))
+        {
+            const auto colon = item.find(':');
+            const auto count = parse_value<int>(key, trim(item.substr(0, colon)));
+            const auto weight = colon == std::string::npos ? 1.0f : parse_value<float>(key, trim(item.substr(colon + 1)));
+
+            if (count < 4 || weight <= 0.0f)
+                throw std::runtime_error("Invalid vertex tier for scenario key " + key + ": " + item);
+
+            tiers.push_back({ count, weight });
+        }
+
+        if (tiers.empty())
+            throw std::runtime_error("Scenario key " + key + " needs at least one tier.");
+
+        return tiers;
+    }
+
+    using Setter = std::function<void(Scenario &, const std::string &, const std::string &)>;
+
+    //==========================================================================
+    const std::map<std::string, Setter> & setters()
+    {
+        static const std::map<std::string, Setter> s_setters
+        {
+            { "name",                 [](Scenario & s, const std::string &  , const std::string & v) { s.name = v; } },
+            { "seed",                 [](Scenario & s, const std::string & k, const std::string & v) { s.seed = parse_value<std::uint32_t>(k, v); } },
+            { "tick_rate",            [](Scenario & s, const std::string & k, const std::string & v) { s.tick_rate = parse_value<float>(k, v); } },
+            { "ticks",                [](Scenario & s, const std::string & k, const std::string & v) { s.ticks = parse_value<std::uint64_t>(k, v); } },
+            { "world_size",           [](Scenario & s, const std::string & k, const std::string & v) { s.world_size = parse_value<float>(k, v); } },
+            { "view_size",            [](Scenario & s, const std::string & k, const std::string & v) { s.view_size = parse_value<float>(k, v); } },
+            { "sector_size",          [](Scenario & s, const std::string & k, const std::string & v) { s.sector_size = parse_value<float>(k, v); } },
+            { "sector_radius",        [](Scenario & s, const std::string & k, const std::string & v) { s.sector_radius = parse_value<std::size_t>(k, v); } },
+            { "rock_count",           [](Scenario & s, const std::string & k, const std::string & v) { s.rock_count = parse_value<std::size_t>(k, v); } },
+            { "rock_size_min",        [](Scenario & s, const std::string & k, const std::string & v) { s.rock_size_min = parse_value<float>(k, v); } },
+            { "rock_size_max",        [](Scenario & s, const std::string & k, const std::string & v) { s.rock_size_max = parse_value<float>(k, v); } },
+            { "rock_speed_max",       [](Scenario & s, const std::string & k, const std::string & v) { s.rock_speed_max = parse_value<float>(k, v); } },
+            { "split_speed_max",      [](Scenario & s, const std::string & k, const std::string & v) { s.split_speed_max = parse_value<float>(k, v); } },
+            { "vertex_tiers",         [](Scenario & s, const std::string & k, const std::string & v) { s.vertex_tiers = parse_tiers(k, v); } },
+            { "ship_size",            [](Scenario & s, const std::string & k, const std::string & v) { s.ship_size = parse_value<float>(k, v); } },
+            { "ship_speed",           [](Scenario & s, const std::string & k, const std::string & v) { s.ship_speed = parse_value<float>(k, v); } },
+            { "ship_rotation_speed",  [](Scenario & s, const std::string & k, const std::string & v) { s.ship_rotation_speed = parse_value<float>(k, v); } },
+            { "invincibility",        [](Scenario & s, const std::string & k, const std::string & v) { s.invincibility = parse_value<float>(k, v); } },
+            { "fire_rate",            [](Scenario & s, const std::string & k, const std::string & v) { s.fire_rate = parse_value<float>(k, v); } },
+            { "auto_fire",            [](Scenario & s, const std::string & k, const std::string & v) { s.auto_fire = parse_bool(k, v); } },
+            { "projectile_speed",     [](Scenario & s, const std::string & k, const std::string & v) { s.projectile_speed = parse_value<float>(k, v); } },
+            { "projectile_life_time", [](Scenario & s, const std::string & k, const std::string & v) { s.projectile_life_time = parse_value<float>(k, v); } },
+            { "projectile_width",     [](Scenario & s, const std::string & k, const std::string & v) { s.projectile_size.x = parse_value<float>(k, v); } },
+            { "projectile_height",    [](Scenario & s, const std::string & k, const std::string & v) { s.projectile_size.y = parse_value<float>(k, v); } },
+        };
+
+        return s_setters;
+    }
+}
+
+//==============================================================================
+void Scenario::set(const std::string & key, const std::string & value)
+{
+    const auto setter = setters().find(key);
+    if (setter == setters().end())
+        throw std::runtime_error("Unknown scenario key: " + key);
+
+    setter->second(*this, key, value);
+
+    if (tick_rate <= 0.0f)
+        throw std::runtime_error("Scenario tick_rate must be positive.");
+    if (fire_rate <= 0.0f)
+        throw std::runtime_error("Scenario fire_rate must be positive.");
+    if (world_size <= 0.0f || view_size <= 0.0f)
+        throw std::runtime_error("Scenario world_size and view_size must be positive.");
+    if (sector_size < 0.0f)
+        throw std::runtime_error("Scenario sector_size must not be negative.");
+}
+
+//==============================================================================
+void Scenario::validate() const
+{
+    if (rock_size_min > rock_size_max)
+        throw std::runtime_error("Scenario rock_size_min must not be larger than rock_size_max.");
+}
+
+//==============================================================================
+void Scenario::load(const std::string & file_name)
+{
+    std::ifstream file{ file_name };
+    if (file.is_open() == false)
+        throw std::runtime_error("Failed to open scenario file: " + file_name);
+
+    read(file, file_name);
+}
+
+//==============================================================================
+void Scenario::read(std::istream & stream, const std::string & source)
+{
+    std::string line;
+    for (int line_number = 1; std::getline(stream, line); ++line_number)
+    {
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) continue;
+
+        const auto equals = line.find('=');
+        if (equals == std::string::npos)
+            throw std::runtime_error(source + ":" + std::to_string(line_number) + ": expected key = value");
+
+        set(trim(line.substr(0, equals)), trim(line.substr(equals + 1)));
+    }
+}
+
+//==============================================================================
+std::string Scenario::text() const
+{
+    std::ostringstream stream;
+
+    // enough digits for every float to read back exactly
+    stream << std::setprecision(std::numeric_limits<float>::max_digits10);
+
+    stream << "name = " << name << "\n"
+           << "seed = " << seed << "\n"
+           << "tick_rate = " << tick_rate << "\n"
+           << "ticks = " << ticks << "\n"
+           << "world_size = " << world_size << "\n"
+           << "view_size = " << view_size << "\n"
+           << "sector_size = " << sector_size << "\n"
+           << "sector_radius = " << sector_radius << "\n"
+           << "rock_count = " << rock_count << "\n"
+           << "rock_size_min = " << rock_size_min << "\n"
+           << "rock_size_max = " << rock_size_max << "\n"
+           << "rock_speed_max = " << rock_speed_max << "\n"
+           << "split_speed_max = " << split_speed_max << "\n"
+           << "vertex_tiers = ";
+
+    for (std::size_t i = 0; i < vertex_tiers.size(); ++i)
+        stream << (i != 0 ? ", " : "") << vertex_tiers[i].vertex_count << ":" << vertex_tiers[i].weight;
+
+    stream << "\n"
+           << "ship_size = " << ship_size << "\n"
+           << "ship_speed = " << ship_speed << "\n"
+           << "ship_rotation_speed = " << ship_rotation_speed << "\n"
+           << "invincibility = " << invincibility << "\n"
+           << "fire_rate = " << fire_rate << "\n"
+           << "auto_fire = " << (auto_fire ? "true" : "false") << "\n"
+           << "projectile_speed = " << projectile_speed << "\n"
+           << "projectile_life_time = " << projectile_life_time << "\n"
+           << "projectile_width = " << projectile_size.x << "\n"
+           << "projectile_height = " << projectile_size.y << "\n";
+
+    return stream.str();
+}
+
+//==============================================================================
+Scenario Scenario::preset(const std::string & name)
+{
+    Scenario s;
+    s.name = name;
+
+    if (name == "default")
+        return s;
+
+    // stress presets use fixed seeds so every run profiles the same world
+    s.seed = 12345;
+
+    if (name == "stress-10k" || name == "stress-100k" || name == "stress-1m")
+    {
+        s.rock_count    = name == "stress-10k" ? 10'000 : name == "stress-100k" ? 100'000 : 1'000'000;
+        s.ticks         = name == "stress-10k" ? 600 : name == "stress-100k" ? 120 : 20;
+        s.rock_size_min = 0.002f;
+        s.rock_size_max = 0.012f;
+        s.vertex_tiers  = { { 4, 1.0f }, { 6, 2.0f }, { 10, 2.0f }, { 16, 1.0f } };
+        s.invincibility = 1e9f;
+        s.auto_fire     = true;
+        return s;
+    }
+
+    // a million rocks on a world 16 views wide, the view holds a few thousand
+    if (name == "map-1m")
+    {
+        s.rock_count    = 1'000'000;
+        s.ticks         = 20;
+        s.world_size    = 16.0f;
+        s.rock_size_min = 0.01f;
+        s.rock_size_max = 0.04f;
+        s.vertex_tiers  = { { 6, 1.0f }, { 10, 2.0f }, { 16, 1.0f } };
+        s.invincibility = 1e9f;
+        s.auto_fire     = true;
+        return s;
+    }
+
+    // the same map made per sector around the ship, the autopilot flies through it
+    if (name == "map-stream")
+    {
+        s.rock_count    = 1'000'000;
+        s.ticks         = 3'000;
+        s.world_size    = 16.0f;
+        s.sector_size   = 1.0f;
+        s.sector_radius = 2;
+        s.rock_size_min = 0.01f;
+        s.rock_size_max = 0.04f;
+        s.vertex_tiers  = { { 6, 1.0f }, { 10, 2.0f }, { 16, 1.0f } };
+        s.invincibility = 1e9f;
+        s.auto_fire     = true;
+        return s;
+    }
+
+    if (name == "projectile-storm")
+    {
+        s.rock_count           = 2'000;
+        s.ticks                = 2'000;
+        s.rock_size_min        = 0.01f;
+        s.rock_size_max        = 0.04f;
+        s.vertex_tiers         = { { 10, 1.0f } };
+        s.invincibility        = 1e9f;
+        s.auto_fire            = true;
+        s.fire_rate            = 500.0f;
+        s.projectile_life_time = 4.0f;
+        return s;
+    }
+
+    throw std::runtime_error("Unknown scenario preset: " + name);
+}
+
+//==============================================================================
+std::vector<std::string> Scenario::presetNames()
+{
+    return { "default", "stress-10k", "stress-100k", "stress-1m", "map-1m", "map-stream", "projectile-storm" };
+}
+
+//==============================================================================
+AntiAliasing AntiAliasing::parse(const std::string & text)
+{
+    AntiAliasing aa;
+
+    if (text == "none")
+        aa.mode = Mode::NONE;
+    else if (text == "line")
+        aa.mode = Mode::LINE;
+    else if (text.compare(0, 4, "msaa") == 0)
+    {
+        aa.mode = Mode::MSAA;
+        aa.samples = parse_value<int>("--aa", text.substr(4));
+
+        if (aa.samples < 2)
+            throw std::runtime_error("Invalid value for --aa: " + text);
+    }
+    else
+        throw std::runtime_error("Invalid value for --aa: " + text);
+
+    return aa;
+}
+
+//==============================================================================
+std::string AntiAliasing::name() const
+{
+    if (mode == Mode::NONE)
+        return "none";
+    if (mode == Mode::LINE)
+        return "line";
+
+    return "msaa" + std::to_string(samples);
+}
+
+//==============================================================================
+Options Options::parse(int argc, char * argv[])
+{
+    Options options;
+
+    // the preset and scenario files are the base the keys apply to, wherever they are on the command line
+    std::string preset;
+    std::vector<std::string> scenario_files;
+    std::vector<std::pair<std::string, std::string>> keys;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg{ argv[i] };
+
+        if (arg == "--headless")        { options.mode = Mode::HEADLESS;           continue; }
+        if (arg == "--benchmark")       { options.mode = Mode::BENCHMARK;          continue; }
+        if (arg == "--bench-particles") { options.mode = Mode::PARTICLE_BENCHMARK; continue; }
+        if (arg == "--bench-aa")        { options.mode = Mode::AA_BENCHMARK;       continue; }
+        if (arg == "--profile")         { options.profile = true;                  continue; }
+        if (arg == "--autopilot")       { options.autopilot = true;                continue; }
+        if (arg == "--no-pause")        { options.pause = false;                   continue; }
+        if (arg == "--net-test")        { options.mode = Mode::NET_TEST;           continue; }
+
+        if (arg.compare(0, 2, "--") != 0 || i + 1 >= argc)
+            throw std::runtime_error("Invalid command line argument: " + arg);
+
+        const std::string value{ argv[++i] };
+
+        if (arg == "--scenario")
+        {
+            scenario_files.push_back(value);
+            options.scenario_given = true;
+        }
+        else if (arg == "--preset")
+        {
+            preset = value;
+            options.scenario_given = true;
+        }
+        else if (arg == "--capture")
+        {
+            options.capture_path = value;
+        }
+        else if (arg == "--trace")
+        {
+            options.trace_path = value;
+        }
+        else if (arg == "--load")
+        {
+            options.load_path = value;
+        }
+        else if (arg == "--save")
+        {
+            options.save_path = value;
+        }
+        else if (arg == "--server")
+        {
+            options.mode = Mode::SERVER;
+            options.net.port = parse_value<std::uint16_t>(arg, value);
+        }
+        else if (arg == "--connect")
+        {
+            options.mode = Mode::CLIENT;
+            options.net.server = value;
+        }
+        else if (arg == "--batch")
+        {
+            options.mode = Mode::BATCH_BENCHMARK;
+            options.batch_worlds = parse_value<std::size_t>(arg, value);
+        }
+        else if (arg == "--aa")          options.aa = AntiAliasing::parse(value);
+        else if (arg == "--rewind")      options.rewind_seconds = parse_value<float>(arg, value);
+        else if (arg == "--background-fps") options.background_fps = parse_value<float>(arg, value);
+        else if (arg == "--threads")     options.threads = parse_value<std::size_t>(arg, value);
+        else if (arg == "--net-clients") options.net.clients = parse_value<std::size_t>(arg, value);
+        else if (arg == "--net-loss")
+        {
+            options.net.conditions.loss = parse_value<float>(arg, value);
+            if (!(options.net.conditions.loss >= 0.0f && options.net.conditions.loss <= 1.0f))
+                throw std::runtime_error("Invalid value for --net-loss, expected a fraction in [0, 1]: " + value);
+        }
+        else if (arg == "--net-latency") options.net.conditions.latency_ms = parse_value<float>(arg, value);
+        else if (arg == "--net-jitter")  options.net.conditions.jitter_ms = parse_value<float>(arg, value);
+        else if (arg == "--net-budget")  options.net.snapshot_budget = parse_value<std::size_t>(arg, value);
+        else
+        {
+            keys.emplace_back(arg.substr(2), value);
+            options.scenario_given = true;
+        }
+    }
+
+    if (preset.empty() == false)
+        options.scenario = Scenario::preset(preset);
+    for (const auto & file : scenario_files)
+        options.scenario.load(file);
+    for (const auto & key : keys)
+        options.scenario.set(key.first, key.second);
+
+    options.scenario.validate();
+
+    return options;
+}
+
+//==============================================================================
+const char * Options::usage()
+{
+    return
+        "usage: asteroids [--scenario <file>] [--preset <name>] [--<key> <value>]...\n"
+        "       asteroids --headless ...     simulate without a window and print a summary\n"
+        "       asteroids --benchmark ...    time every tick, all presets if no scenario is given\n"
+        "       asteroids --bench-particles  time the explosion particle update\n"
+        "       asteroids --capture <file>   record every frame, *.png is a printf pattern, anything else a raw RGBA stream\n"
+        "       asteroids --profile          print GPU time per draw group and input latency at exit\n"
+        "       asteroids --trace <file>     write the recorded trace spans as Chrome trace event JSON at exit\n"
+        "       asteroids --save <file>      save the world at exit\n"
+        "       asteroids --load <file>      continue a saved world instead of generating one\n"
+        "       asteroids --rewind <seconds> record the last seconds of ticks, hold R to step back\n"
+        "       asteroids --autopilot        a scripted pilot flies the ship\n"
+        "       asteroids --no-pause         keep playing while the window is unfocused or iconified\n"
+        "       asteroids --background-fps <fps>     redraws per second of an unfocused window\n"
+        "       asteroids --aa <mode>        anti-aliasing: none, line or msaa<n>\n"
+        "       asteroids --bench-aa ...     frame time of every anti-aliasing mode\n"
+        "       asteroids --batch <worlds> ...       play many games of the scenario in lockstep\n"
+        "       asteroids --server <port> ...        run the authoritative world without a window\n"
+        "       asteroids --connect <host:port>      play on a server\n"
+        "       asteroids --net-test ...             server and clients over loopback\n";
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <string>
+#include <istream>
+#include <vector>
+#include <cstdint>
+
+#include "Vec2.hpp"
+#include "Net.hpp"
+
+// Everything that defines a workload. The same scenario drives the
+// interactive game, the headless runner and the benchmark suite.
+//
+// Scenario files are "key = value" lines, '#' starts a comment. Every key can
+// also be given on the command line as "--key value".
+struct Scenario
+{
+    // rock vertex count with its relative spawn weight
+    struct VertexTier
+    {
+        int vertex_count;
+        float weight;
+    };
+
+    std::string name{ "default" };
+
+    // 0 picks a time based seed
+    std::uint32_t seed{ 0 };
+    float tick_rate{ 1'000'000.0f / 15'000.0f };
+
+    // headless runner: number of ticks to simulate, 0 runs until the game is over
+    std::uint64_t ticks{ 0 };
+
+    // half the side of the wrapping world square and of the square the
+    // window shows, a camera follows the ship through worlds larger than the view
+    float world_size{ 1.0f };
+    float view_size{ 1.0f };
+
+    // rocks made per sector of about sector_size near the ships instead of
+    // all at the start, 0 makes them all at the start. Sectors within
+    // sector_radius rings of a ship are simulated, rock_count is spread over
+    // all sectors of the world.
+    float sector_size{ 0.0f };
+    std::size_t sector_radius{ 2 };
+
+    // rocks
+    std::size_t rock_count{ 6 };
+    float rock_size_min{ 2.0f / 14.0f };
+    float rock_size_max{ 3.0f / 14.0f };
+    float rock_speed_max{ 0.15f };
+    float split_speed_max{ 0.15f };
+    std::vector<VertexTier> vertex_tiers{ { 10, 1.0f } };
+
+    // ship
+    float ship_size{ 0.04f };
+    float ship_speed{ 0.5f };
+    float ship_rotation_speed{ 0.8f };
+    float invincibility{ 3.0f };
+
+    // weapon, fire rate is shots per second
+    float fire_rate{ 1.0f / 0.6f };
+    bool auto_fire{ false };
+    float projectile_speed{ 0.6f };
+    float projectile_life_time{ 1.5f };
+    Vec2 projectile_size{ 0.03f, 0.01f };
+
+    float deltaTime() const { return 1.0f / tick_rate; }
+
+    // Sets a single key, throws std::runtime_error on unknown keys or bad values
+    void set(const std::string & key, const std::string & value);
+
+    // Throws std::runtime_error if keys contradict each other, which set() can't
+    // tell while the other key may still follow
+    void validate() const;
+
+    // Applies a scenario file on top of the current values
+    void load(const std::string & file_name);
+
+    // Applies scenario lines, source names them in error messages
+    void read(std::istream & stream, const std::string & source);
+
+    // Every key as a scenario line, read() restores the exact values
+    std::string text() const;
+
+    static Scenario preset(const std::string & name);
+    static std::vector<std::string> presetNames();
+
+};
+
+// Client/server mode and loopback test
+struct NetSettings
+{
+    NetConditions conditions;
+    std::size_t clients{ 2 };
+    std::size_t snapshot_budget{ 1200 };
+    std::uint16_t port{ 0 };
+    std::string server;
+};
+
+// How the window smooths edges. MSAA multiplies the fragment work by the
+// sample count, which software rasterizers pay in full, line AA draws every
+// line as a thin quad with a coverage falloff at single sample cost.
+struct AntiAliasing
+{
+    enum class Mode { NONE, MSAA, LINE };
+
+    Mode mode{ Mode::MSAA };
+    int samples{ 16 };                  // MSAA only
+
+    // "none", "line" or "msaa<samples>" such as "msaa4", throws std::runtime_error otherwise
+    static AntiAliasing parse(const std::string & text);
+
+    std::string name() const;
+
+    // samples to request for the default framebuffer
+    int framebufferSamples() const { return mode == Mode::MSAA ? samples : 0; }
+};
+
+// Command line of the executable, scenario keys plus run mode
+struct Options
+{
+    enum class Mode { INTERACTIVE, HEADLESS, BENCHMARK, PARTICLE_BENCHMARK, BATCH_BENCHMARK, AA_BENCHMARK, SERVER, CLIENT, NET_TEST };
+
+    Mode mode{ Mode::INTERACTIVE };
+    Scenario scenario;
+    bool scenario_given{ false };
+    std::string capture_path;
+    bool profile{ false };
+    std::string trace_path;
+    std::string load_path;
+    std::string save_path;
+    float rewind_seconds{ 0.0f };
+    bool autopilot{ false };
+    bool pause{ true };                 // stop the game while the window is unfocused or iconified
+    float background_fps{ 4.0f };       // redraws of an unfocused window, 0 for none
+    std::size_t batch_worlds{ 0 };
+    std::size_t threads{ 0 };           // 0 for one per hardware thread
+    AntiAliasing aa;
+    NetSettings net;
+
+    // --scenario <file> --preset <name> --headless --benchmark --bench-particles --profile --capture <file> --trace <file>
+    // --load <file> --save <file> --rewind <seconds> --autopilot --no-pause --background-fps <fps>
+    // --batch <worlds> --threads <n> --aa <mode> --bench-aa
+    // --server <port> --connect <host:port> --net-test --net-clients <n> --net-loss <p>
+    // --net-latency <ms> --net-jitter <ms> --net-budget <bytes> --<key> <value>
+    static Options parse(int argc, char * argv[]);
+
+    // Command line summary printed for a bad command line
+    static const char * usage();
+
+};
@@ -0,0 +1,384 @@
+#include "SectorStream.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "World.hpp"
+
+namespace
+{
+    //==========================================================================
+    double milliseconds(std::chrono::steady_clock::duration d)
+    {
+        return std::chrono::duration<double, std::milli>{ d }.count();
+    }
+}
+
+//==============================================================================
+SectorStream::SectorStream(const Scenario & scenario, std::uint32_t seed) :
+    m_scenario{ scenario },
+    m_seed{ seed },
+    m_sectors_per_axis{ std::max<std::size_t>(1, static_cast<std::size_t>(std::lround(2.0f * scenario.world_size / scenario.sector_size))) },
+    m_sector_size{ 2.0f * scenario.world_size / static_cast<float>(m_sectors_per_axis) },
+    m_rocks_per_sector{ scenario.rock_count / (m_sectors_per_axis * m_sectors_per_axis) }
+{
+    m_statistics.sectors_per_axis = m_sectors_per_axis;
+    m_thread = std::thread{ [this] { work(); } };
+}
+
+//==============================================================================
+SectorStream::~SectorStream()
+{
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        m_stop = true;
+    }
+
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+//==============================================================================
+std::uint32_t SectorStream::sectorAt(long x, long y) const
+{
+    const long n = static_cast<long>(m_sectors_per_axis);
+
+    x = ((x % n) + n) % n;
+    y = ((y % n) + n) % n;
+
+    return static_cast<std::uint32_t>(y * n + x);
+}
+
+//==============================================================================
+std::uint32_t SectorStream::sectorOf(const Vec2 & position) const
+{
+    // bodies leave the square by up to their size before they wrap, they count to the edge sectors
+    const long last = static_cast<long>(m_sectors_per_axis) - 1;
+    const auto cell = [this, last] (float coordinate)
+    {
+        const auto c = static_cast<long>(std::floor((coordinate + m_scenario.world_size) / m_sector_size));
+        return std::min(std::max(c, 0L), last);
+    };
+
+    return sectorAt(cell(position.x), cell(position.y));
+}
+
+//==============================================================================
+std::size_t SectorStream::distance(std::uint32_t a, std::uint32_t b) const
+{
+    // rings around a on the wrapping square
+    const auto n = m_sectors_per_axis;
+    const auto axis = [n] (std::size_t u, std::size_t v)
+    {
+        const auto d = u > v ? u - v : v - u;
+        return std::min(d, n - d);
+    };
+
+    return std::max(axis(a % n, b % n), axis(a / n, b / n));
+}
+
+//==============================================================================
+std::vector<Rock> SectorStream::generate(std::uint32_t sector, MonotonicArena & arena) const
+{
+    Vec2Gen rng{ m_seed, 1 + sector };
+
+    const Vec2 origin{
+        -m_scenario.world_size + static_cast<float>(sector % m_sectors_per_axis) * m_sector_size,
+        -m_scenario.world_size + static_cast<float>(sector / m_sectors_per_axis) * m_sector_size
+    };
+
+    std::vector<Rock> rocks;
+    World::generateSectorRocks(m_scenario, rng, origin, m_sector_size, m_rocks_per_sector, rocks, arena);
+
+    return rocks;
+}
+
+//==============================================================================
+void SectorStream::activate(std::uint32_t sector, std::vector<Rock> generated, std::vector<Rock> & rocks)
+{
+    const auto delta = m_deltas.find(sector);
+    const auto gone = [&delta] (std::size_t i)
+    {
+        const auto & bits = delta->second.gone;
+        return i / 64 < bits.size() && (bits[i / 64] >> (i % 64) & 1) != 0;
+    };
+
+    for (std::size_t i = 0; i < generated.size(); ++i)
+    {
+        if (delta != m_deltas.end() && gone(i))
+            continue;
+
+        m_origins[generated[i].id()] = Origin{ sector, static_cast<std::uint32_t>(i) };
+        rocks.push_back(std::move(generated[i]));
+    }
+
+    // the rocks that left in the sector, as they were
+    if (delta != m_deltas.end())
+    {
+        for (auto & r : delta->second.rocks)
+        {
+            m_origins[r.id()] = Origin{ sector, NO_SPAWN };
+            rocks.push_back(std::move(r));
+        }
+
+        std::vector<Rock>{}.swap(delta->second.rocks);
+
+        if (delta->second.gone.empty())
+            m_deltas.erase(delta);
+    }
+
+    m_statistics.activations++;
+}
+
+//==============================================================================
+void SectorStream::markGone(const Origin & origin)
+{
+    if (origin.spawn == NO_SPAWN)
+        return;
+
+    auto & bits = m_deltas[origin.sector].gone;
+    if (bits.empty())
+        bits.resize((m_rocks_per_sector + 63) / 64);
+
+    bits[origin.spawn / 64] |= std::uint64_t{ 1 } << (origin.spawn % 64);
+}
+
+//==============================================================================
+void SectorStream::dematerialize(std::vector<Rock> & rocks)
+{
+    // rocks in sectors that are not active leave for the delta of the sector
+    // they are in, the others close up in order
+    std::size_t kept = 0;
+
+    for (std::size_t i = 0; i < rocks.size(); ++i)
+    {
+        const auto sector = sectorOf(rocks[i].position());
+        const auto s = m_sectors.find(sector);
+
+        if (s != m_sectors.end() && s->second.state == State::ACTIVE)
+        {
+            if (kept != i)
+                rocks[kept] = std::move(rocks[i]);
+            kept++;
+            continue;
+        }
+
+        // a spawned rock is not spawned again, it comes back from the delta
+        const auto origin = m_origins.find(rocks[i].id());
+        if (origin != m_origins.end())
+        {
+            markGone(origin->second);
+            m_origins.erase(origin);
+        }
+
+        m_deltas[sector].rocks.push_back(std::move(rocks[i]));
+    }
+
+    rocks.erase(rocks.begin() + static_cast<std::ptrdiff_t>(kept), rocks.end());
+}
+
+//==============================================================================
+void SectorStream::receive()
+{
+    std::vector<Delivery> deliveries;
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        deliveries.swap(m_deliveries);
+    }
+
+    for (auto & d : deliveries)
+    {
+        // sectors dematerialized or made on the spot in the meantime drop theirs
+        const auto s = m_sectors.find(d.sector);
+        if (s == m_sectors.end() || s->second.state != State::REQUESTED)
+            continue;
+
+        s->second.state = State::READY;
+        s->second.rocks = std::move(d.rocks);
+
+        const auto latency = milliseconds(d.done - s->second.requested);
+        m_statistics.delivered++;
+        m_statistics.latency_total_ms += latency;
+        m_statistics.latency_max_ms = std::max(m_statistics.latency_max_ms, latency);
+    }
+}
+
+//==============================================================================
+void SectorStream::request(std::uint32_t sector)
+{
+    if (m_sectors.count(sector) != 0)
+        return;
+
+    m_sectors[sector] = Sector{ State::REQUESTED, {}, std::chrono::steady_clock::now() };
+
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        m_requests.push_back(sector);
+    }
+
+    m_wake.notify_one();
+}
+
+//==============================================================================
+void SectorStream::work()
+{
+    MonotonicArena arena;
+
+    std::unique_lock<std::mutex> lock{ m_mutex };
+
+    for (;;)
+    {
+        m_wake.wait(lock, [this] { return m_stop || m_requests.empty() == false; });
+        if (m_stop)
+            return;
+
+        const auto sector = m_requests.front();
+        m_requests.erase(m_requests.begin());
+
+        lock.unlock();
+        auto rocks = generate(sector, arena);
+        const auto done = std::chrono::steady_clock::now();
+        lock.lock();
+
+        m_deliveries.push_back(Delivery{ sector, std::move(rocks), done });
+    }
+}
+
+//==============================================================================
+void SectorStream::update(const Vec2 * positions, std::size_t count, std::vector<Rock> & rocks)
+{
+    receive();
+
+    // without ships the sectors stay as they are
+    if (count == 0)
+        return;
+
+    m_next_centers.resize(count);
+    for (std::size_t i = 0; i < count; ++i)
+        m_next_centers[i] = sectorOf(positions[i]);
+
+    if (m_next_centers == m_centers)
+        return;
+
+    m_centers.swap(m_next_centers);
+
+    const auto radius = m_scenario.sector_radius;
+    const auto nearest = [this] (std::uint32_t sector)
+    {
+        std::size_t d = m_sectors_per_axis;
+        for (const auto c : m_centers)
+            d = std::min(d, distance(sector, c));
+        return d;
+    };
+
+    // dematerialize the sectors left behind, drop the ones made ahead for nothing
+    std::size_t leaving = 0;
+    std::vector<std::uint32_t> cancelled;
+    for (auto s = m_sectors.begin(); s != m_sectors.end();)
+    {
+        // one ring of slack each, a ship going back and forth over a sector border makes nothing twice
+        const auto keep = s->second.state == State::ACTIVE ? radius + 1 : radius + 2;
+        if (nearest(s->first) <= keep)
+        {
+            ++s;
+            continue;
+        }
+
+        if (s->second.state == State::ACTIVE)
+            leaving++;
+        if (s->second.state == State::REQUESTED)
+            cancelled.push_back(s->first);
+
+        s = m_sectors.erase(s);
+    }
+
+    // requests the thread has not started on are taken back
+    if (cancelled.empty() == false)
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        m_requests.erase(std::remove_if(m_requests.begin(), m_requests.end(), [&cancelled] (std::uint32_t sector)
+        {
+            return std::find(cancelled.begin(), cancelled.end(), sector) != cancelled.end();
+        }), m_requests.end());
+    }
+
+    // by the sector every rock is in now, which also takes the rocks that
+    // drifted out of the active sectors since the ships last moved on
+    dematerialize(rocks);
+    m_statistics.dematerializations += leaving;
+
+    // activate in ship and ring order so every run adds the rocks in the same order
+    const long reach = static_cast<long>(radius);
+    const long n = static_cast<long>(m_sectors_per_axis);
+
+    for (const auto center : m_centers)
+    {
+        for (long dy = -reach; dy <= reach; ++dy)
+        {
+            for (long dx = -reach; dx <= reach; ++dx)
+            {
+                const auto sector = sectorAt(center % n + dx, center / n + dy);
+                const auto s = m_sectors.find(sector);
+
+                if (s != m_sectors.end() && s->second.state == State::ACTIVE)
+                    continue;
+
+                if (s != m_sectors.end() && s->second.state == State::READY)
+                {
+                    activate(sector, std::move(s->second.rocks), rocks);
+                    s->second = Sector{ State::ACTIVE, {}, {} };
+                    continue;
+                }
+
+                if (s != m_sectors.end())
+                    m_statistics.late++;
+
+                activate(sector, generate(sector, m_arena), rocks);
+                m_sectors[sector] = Sector{ State::ACTIVE, {}, {} };
+                m_statistics.generated_inline++;
+            }
+        }
+    }
+
+    // the next ring is made ahead
+    for (const auto center : m_centers)
+    {
+        for (long dy = -reach - 1; dy <= reach + 1; ++dy)
+            for (long dx = -reach - 1; dx <= reach + 1; ++dx)
+                request(sectorAt(center % n + dx, center / n + dy));
+    }
+}
+
+//==============================================================================
+void SectorStream::split(const Rock & rock, const Rock * fragments, std::size_t count)
+{
+    const auto found = m_origins.find(rock.id());
+    if (found == m_origins.end())
+        return;
+
+    const auto origin = found->second;
+    m_origins.erase(found);
+
+    markGone(origin);
+
+    for (std::size_t i = 0; i < count; ++i)
+        m_origins[fragments[i].id()] = Origin{ origin.sector, NO_SPAWN };
+}
+
+//==============================================================================
+SectorStream::Statistics SectorStream::statistics() const
+{
+    auto result = m_statistics;
+
+    for (const auto & s : m_sectors)
+    {
+        result.active += s.second.state == State::ACTIVE ? 1 : 0;
+        result.prefetched += s.second.state == State::READY ? 1 : 0;
+    }
+
+    result.deltas = m_deltas.size();
+    for (const auto & d : m_deltas)
+        result.delta_bytes += d.second.gone.size() * sizeof(std::uint64_t) + d.second.rocks.size() * sizeof(Rock);
+
+    return result;
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+
+#include "Scenario.hpp"
+#include "Rock.hpp"
+#include "Arena.hpp"
+
+// Rocks of a world made lazily per sector, for worlds too large to simulate
+// at once.
+//
+// The world square is cut into sectors of about scenario.sector_size, every
+// sector holds an equal share of rock_count. The rocks of a sector are drawn
+// from Philox stream 1 + sector index of the world seed, so they are a pure
+// function of (seed, sector) however often the sector is made. Sectors within
+// sector_radius of a ship are active, their rocks are in the World. A sector
+// more than one ring further away is dematerialized. Rocks belong to the
+// sector they are in at that moment, not the one they spawned in: those in
+// sectors that are no longer active leave the World with their state, so
+// drifted rocks and fragments near a ship stay. A sector keeps a delta: a bit
+// per spawned rock that was hit or left with its state, and the rocks that
+// left in it. Made again, the sector spawns the rocks without a bit, where
+// they started, and brings back the ones that left in it as they were.
+//
+// The ring just outside the active sectors is generated ahead on a
+// background thread and handed over when a ship comes close enough, so the
+// tick only moves finished rocks. Sectors made ahead are kept until they are
+// two rings out. A sector that is needed before the thread
+// delivered it is generated on the spot, which keeps the world deterministic
+// at the cost of that tick, statistics() counts these as late.
+class SectorStream
+{
+public:
+    struct Statistics
+    {
+        std::size_t sectors_per_axis{ 0 };
+        std::size_t active{ 0 };                // sectors with rocks in the world
+        std::size_t prefetched{ 0 };            // generated ahead and waiting
+        std::size_t deltas{ 0 };                // sectors with rocks that were hit or left
+        std::size_t delta_bytes{ 0 };           // bits and rock objects, their shapes not included
+        std::uint64_t activations{ 0 };
+        std::uint64_t dematerializations{ 0 };
+        std::uint64_t generated_inline{ 0 };    // on the simulation thread, the first sectors included
+        std::uint64_t late{ 0 };                // requested but not delivered in time
+        std::uint64_t delivered{ 0 };           // by the background thread
+        double latency_total_ms{ 0.0 };         // request to delivery
+        double latency_max_ms{ 0.0 };
+    };
+
+    SectorStream(const Scenario & scenario, std::uint32_t seed);
+    ~SectorStream();
+
+    SectorStream(const SectorStream &) = delete;
+    SectorStream & operator = (const SectorStream &) = delete;
+
+    // Activates the sectors near the ships at positions and dematerializes
+    // the ones left behind, adding and removing their rocks
+    void update(const Vec2 * positions, std::size_t count, std::vector<Rock> & rocks);
+
+    // A hit rock broke into count fragments (maybe none)
+    void split(const Rock & rock, const Rock * fragments, std::size_t count);
+
+    Statistics statistics() const;
+
+private:
+    enum class State : std::uint8_t { REQUESTED, READY, ACTIVE };
+
+    struct Sector
+    {
+        State state;
+        std::vector<Rock> rocks;        // READY: as generated
+        std::chrono::steady_clock::time_point requested;
+    };
+
+    // sector and spawn index of a rock in the world, fragments and rocks that
+    // were brought back have no spawn index
+    struct Origin
+    {
+        std::uint32_t sector;
+        std::uint32_t spawn;
+    };
+
+    static constexpr std::uint32_t NO_SPAWN = ~std::uint32_t{ 0 };
+
+    struct Delivery
+    {
+        std::uint32_t sector;
+        std::vector<Rock> rocks;
+        std::chrono::steady_clock::time_point done;
+    };
+
+    std::uint32_t sectorOf(const Vec2 & position) const;
+    std::uint32_t sectorAt(long x, long y) const;
+    std::size_t distance(std::uint32_t a, std::uint32_t b) const;
+
+    // changes of a sector since it was first made
+    struct Delta
+    {
+        std::vector<std::uint64_t> gone;    // by spawn index, hit or left with their state
+        std::vector<Rock> rocks;            // left in the sector, brought back when it is made again
+    };
+
+    std::vector<Rock> generate(std::uint32_t sector, MonotonicArena & arena) const;
+    void activate(std::uint32_t sector, std::vector<Rock> generated, std::vector<Rock> & rocks);
+    void markGone(const Origin & origin);
+    void dematerialize(std::vector<Rock> & rocks);
+    void receive();
+    void request(std::uint32_t sector);
+    void work();
+
+    Scenario m_scenario;
+    std::uint32_t m_seed;
+    std::size_t m_sectors_per_axis;
+    float m_sector_size;
+    std::size_t m_rocks_per_sector;
+
+    // sectors that are not idle, idle ones have no entry
+    std::unordered_map<std::uint32_t, Sector> m_sectors;
+
+    // sectors with rocks that were hit or left
+    std::unordered_map<std::uint32_t, Delta> m_deltas;
+
+    std::unordered_map<std::uint32_t, Origin> m_origins;
+
+    // ship sectors of the latest update, nothing changes while they stay
+    std::vector<std::uint32_t> m_centers;
+    std::vector<std::uint32_t> m_next_centers;
+
+    Statistics m_statistics;
+
+    // arena of the sectors generated on the simulation thread
+    MonotonicArena m_arena;
+
+    // background generation, requests in, deliveries out
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::vector<std::uint32_t> m_requests;
+    std::vector<Delivery> m_deliveries;
+    bool m_stop{ false };
+
+    std::thread m_thread;
+
+};
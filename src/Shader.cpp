@@ -11,6 +11,8 @@
 #include <stdexcept>
 #include <cassert>
 
+#include "Trace.hpp"
+
 //==============================================================================
 Shader::Shader(const std::vector<Shader::Source> & shader_source)
 {
@@ -35,6 +37,8 @@ void Shader::reload(const std::vector<Shader::Source>& shader_source)
 //==============================================================================
 void Shader::load(const std::vector<Shader::Source>& shader_source)
 {
+  TRACE_SCOPE("Shader::load");
+
   std::vector<GLuint> shader_object_ids;
 
   // Create shader program
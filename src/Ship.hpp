@@ -1,24 +1,30 @@
 #pragma once
 
 #include <GL/gl3w.h>
-#include <vector>
+#include <array>
+#include <tuple>
 
 #include "Vec2.hpp"
-#include "Keyboard.hpp"
+#include "Input.hpp"
+#include "Polygon.hpp"
 #include "Projectile.hpp"
+#include "BodyId.hpp"
+#include "WorldSave.hpp"
 
-static const std::vector<Vec2> DEFAULT_SHIP_MODEL
-{
+static constexpr std::array<Vec2, 3> DEFAULT_SHIP_MODEL
+{{
     {  1.0f,  0.0f },
     { -1.0f, -0.5f },
     { -1.0f,  0.5f },
-};
+}};
 
 class Ship
 {
 public:
     //==========================================================================
-    Ship(float size, float movement_speed, float rotation_speed, float weapon_cool_down) :
+    Ship(float size, float movement_speed, float rotation_speed, float weapon_cool_down,
+         float projectile_speed = 0.6f, Vec2 projectile_size = { 0.03f, 0.01f }, float projectile_life_time = 1.5f) :
+        m_id       { next_body_id() },
         m_size     { std::max(0.0f, size) },
         m_position { 0.0f, 0.0f },
         m_direction{ 1.0f, 0.0f },
@@ -26,7 +32,9 @@ public:
         m_weapon_cool_down{ std::max(0.0f, weapon_cool_down) },
         m_movement_speed{ std::max(0.0f, movement_speed) },
         m_rotation_speed{ std::max(0.0f, rotation_speed) },
-        m_polygon  { DEFAULT_SHIP_MODEL }
+        m_projectile_speed{ projectile_speed },
+        m_projectile_size{ projectile_size },
+        m_projectile_life_time{ projectile_life_time }
     {
         const auto angle = -std::atan2(m_direction.y, m_direction.x);
 
@@ -36,14 +44,33 @@ public:
         m_rotation_matrix[3] =  std::cos(angle);
 
         // calculate AABB
-        std::vector<Vec2> polygon = m_polygon.vertices();
+        auto polygon = DEFAULT_SHIP_MODEL;
         // scale and rotate
         std::for_each(polygon.begin(), polygon.end(), [this](Vec2 & v){ v = multiply(v * m_size, m_rotation_matrix); });
 
-        const Vec2 size2 = AABB_to_size(compute_AABB_from_polygon(polygon));
+        const Vec2 size2 = AABB_to_size(compute_AABB_from_polygon(polygon.data(), polygon.size()));
         m_bounding_box = AABB{ { -size2.x, -size2.y }, size2 }; // symmetric AABB
     }
 
+    //==========================================================================
+    // Restores a saved ship exactly, the player fields are left to the caller
+    explicit Ship(const SavedShip & saved) :
+        m_id       { saved.id },
+        m_size     { saved.size },
+        m_position { saved.position },
+        m_direction{ saved.direction },
+        m_cool_down{ saved.cool_down },
+        m_weapon_cool_down{ saved.weapon_cool_down },
+        m_movement_speed{ saved.movement_speed },
+        m_rotation_speed{ saved.rotation_speed },
+        m_projectile_speed{ saved.projectile_speed },
+        m_projectile_size{ saved.projectile_size },
+        m_projectile_life_time{ saved.projectile_life_time },
+        m_bounding_box{ saved.box_min, saved.box_max }
+    {
+        std::copy(std::begin(saved.rotation_matrix), std::end(saved.rotation_matrix), std::begin(m_rotation_matrix));
+    }
+
     //==========================================================================
     Ship & operator = (const Ship & other)
     {
@@ -53,7 +80,8 @@ public:
     }
 
     //==========================================================================
-    Ship(Ship && other) :
+    Ship(Ship && other) noexcept :
+        m_id       { other.m_id        },
         m_size     { other.m_size      },
         m_position { other.m_position  },
         m_direction{ other.m_direction },
@@ -61,11 +89,14 @@ public:
         m_weapon_cool_down{ other.m_weapon_cool_down },
         m_movement_speed{ other.m_movement_speed },
         m_rotation_speed{ other.m_rotation_speed },
-        m_polygon  { std::move(other.m_polygon)  },
+        m_projectile_speed{ other.m_projectile_speed },
+        m_projectile_size{ other.m_projectile_size },
+        m_projectile_life_time{ other.m_projectile_life_time },
         m_bounding_box { other.m_bounding_box }
     {
         std::copy(std::begin(other.m_rotation_matrix), std::end(other.m_rotation_matrix), std::begin(m_rotation_matrix));
 
+        other.m_id        = 0;
         other.m_size      = 1.0f;
         other.m_position  = Vec2{ 0.0f, 0.0f };
         other.m_direction = Vec2{ 0.0f, 0.0f };
@@ -80,6 +111,7 @@ public:
     //==========================================================================
     Ship & operator = (Ship && other)
     {
+        m_id        = other.m_id;
         m_size      = other.m_size;
         m_position  = other.m_position;
         m_direction = other.m_direction;
@@ -87,10 +119,13 @@ public:
         m_weapon_cool_down = other.m_weapon_cool_down;
         m_movement_speed = other.m_movement_speed;
         m_rotation_speed = other.m_rotation_speed;
-        m_polygon   = std::move(other.m_polygon);
+        m_projectile_speed = other.m_projectile_speed;
+        m_projectile_size = other.m_projectile_size;
+        m_projectile_life_time = other.m_projectile_life_time;
         std::copy(std::begin(other.m_rotation_matrix), std::end(other.m_rotation_matrix), std::begin(m_rotation_matrix));
         m_bounding_box = other.m_bounding_box;
 
+        other.m_id        = 0;
         other.m_size      = 1.0f;
         other.m_position  = Vec2{ 0.0f, 0.0f };
         other.m_direction = Vec2{ 0.0f, 0.0f };
@@ -111,19 +146,17 @@ public:
     ~Ship() = default;
 
     //==========================================================================
-    void move(float delta_time)
+    void move(float delta_time, const InputFrame & input, float world_size)
     {
-        // using euler integration
+        // using euler integration, each action scaled by the fraction of the tick it was held
 
-        // rotation
-        if (Keyboard::getKeyStatus(GLFW_KEY_RIGHT) != Keyboard::getKeyStatus(GLFW_KEY_LEFT))
+        // rotation, positive is counter clockwise
+        const auto turn = input.heldFraction(Action::LEFT) - input.heldFraction(Action::RIGHT);
+        if (turn != 0.0f)
         {
-            // determine rotation direction
-            const auto right = Keyboard::getKeyStatus(GLFW_KEY_RIGHT) == Keyboard::KeyStatus::PRESSED;
-
             // rotation matrix elements
-            const auto cs = std::cos(6.2831853f * m_rotation_speed * delta_time);
-            const auto sn = std::sin(6.2831853f * m_rotation_speed * delta_time) * (right ? -1.0f : 1.0f);
+            const auto cs = std::cos(6.2831853f * m_rotation_speed * delta_time * turn);
+            const auto sn = std::sin(6.2831853f * m_rotation_speed * delta_time * turn);
 
             const auto old_direction = m_direction;
 
@@ -136,17 +169,12 @@ public:
         }
 
         // back and forwards
-        if (Keyboard::getKeyStatus(GLFW_KEY_UP) != Keyboard::getKeyStatus(GLFW_KEY_DOWN))
-            if (Keyboard::getKeyStatus(GLFW_KEY_UP) == Keyboard::KeyStatus::PRESSED)
-            {
-                m_position.x += m_direction.x * m_movement_speed * delta_time;
-                m_position.y += m_direction.y * m_movement_speed * delta_time;
-            }
-            else
-            {
-                m_position.x -= m_direction.x * m_movement_speed * delta_time;
-                m_position.y -= m_direction.y * m_movement_speed * delta_time;
-            }
+        const auto thrust = input.heldFraction(Action::FORWARD) - input.heldFraction(Action::BACKWARD);
+        if (thrust != 0.0f)
+        {
+            m_position.x += m_direction.x * m_movement_speed * delta_time * thrust;
+            m_position.y += m_direction.y * m_movement_speed * delta_time * thrust;
+        }
 
         // update rotation matrix
         const auto angle = -std::atan2(m_direction.y, m_direction.x);
@@ -156,23 +184,24 @@ public:
         m_rotation_matrix[3] =  std::cos(angle);
 
         // calculate AABB
-        std::vector<Vec2> polygon = m_polygon.vertices();
+        auto polygon = DEFAULT_SHIP_MODEL;
         std::for_each(polygon.begin(), polygon.end(), [this](Vec2 & v){ v = multiply(v * m_size, m_rotation_matrix); });
-        const Vec2 size = AABB_to_size(compute_AABB_from_polygon(polygon));
+        const Vec2 size = AABB_to_size(compute_AABB_from_polygon(polygon.data(), polygon.size()));
         m_bounding_box = AABB{ { -size.x, -size.y }, size }; // symmetric AABB
 
         // wrap/warp around
-        wrap_around(m_position, size);
+        wrap_around(m_position, size, world_size);
     }
 
     //==========================================================================
-    void draw(GLint scale_uniform, GLint rotation_uniform, GLint translation_uniform)
+    // Placement of the ship model
+    DrawTransform transform() const
     {
-        glUniform2f(scale_uniform, m_size, m_size);
-        glUniformMatrix2fv(rotation_uniform, 1, GL_FALSE, m_rotation_matrix);
-        glUniform2f(translation_uniform, m_position.x, m_position.y);
-
-        m_polygon.draw();
+        return DrawTransform{
+            { m_size, m_size },
+            { m_rotation_matrix[0], m_rotation_matrix[1], m_rotation_matrix[2], m_rotation_matrix[3] },
+            m_position
+        };
     }
 
     //==========================================================================
@@ -185,45 +214,87 @@ public:
     }
 
     //==========================================================================
-    const std::vector<Vec2> & polygon() const
+    SavedShip save() const
     {
-        return m_polygon.vertices();
+        SavedShip saved{};
+
+        saved.id = m_id;
+        saved.size = m_size;
+        saved.position = m_position;
+        saved.direction = m_direction;
+        saved.cool_down = m_cool_down;
+        saved.weapon_cool_down = m_weapon_cool_down;
+        saved.movement_speed = m_movement_speed;
+        saved.rotation_speed = m_rotation_speed;
+        saved.projectile_speed = m_projectile_speed;
+        saved.projectile_size = m_projectile_size;
+        saved.projectile_life_time = m_projectile_life_time;
+        saved.box_min = m_bounding_box.getMin();
+        saved.box_max = m_bounding_box.getMax();
+        std::copy(std::begin(m_rotation_matrix), std::end(m_rotation_matrix), std::begin(saved.rotation_matrix));
+
+        return saved;
     }
 
     //==========================================================================
-    std::tuple<bool, Projectile> shoot(float delta_time)
+    std::uint32_t id() const { return m_id; }
+    const Vec2 & position() const { return m_position; }
+    const Vec2 & direction() const { return m_direction; }
+    float size() const { return m_size; }
+
+    //==========================================================================
+    const std::array<Vec2, 3> & polygon() const
+    {
+        return DEFAULT_SHIP_MODEL;
+    }
+
+    //==========================================================================
+    std::tuple<bool, Projectile> shoot(float delta_time, const InputFrame & input, bool auto_fire = false)
     {
-        if (m_cool_down >= 0.0f)
-            m_cool_down -= delta_time;
+        // m_cool_down is the time until the weapon is ready, measured from the start of the tick
+        const auto ready = std::max(0.0f, m_cool_down) / delta_time;
+
+        // tick offsets of the first trigger press and of the end of the press
+        const auto pressed  = auto_fire ? 0.0f : input.firstDown(Action::FIRE);
+        const auto released = auto_fire ? 1.0f : pressed + input.heldFraction(Action::FIRE);
 
-        if (Keyboard::getKeyStatus(GLFW_KEY_SPACE) == Keyboard::KeyStatus::PRESSED && m_cool_down < 0.0f)
+        // fire at the first moment the trigger is down and the weapon is ready
+        const auto fire = std::max(ready, pressed);
+
+        if (fire < 1.0f && fire <= released)
         {
-            m_cool_down = m_weapon_cool_down;
+            m_cool_down = m_weapon_cool_down - (1.0f - fire) * delta_time;
+
+            // back date the projectile to the start of the tick, so the full tick
+            // move of the caller leaves it where it is after (1 - fire) of a tick
+            const auto velocity = m_direction * m_projectile_speed;
+            const auto back = fire * delta_time;
 
             return std::make_tuple(
                 true,
-                Projectile{ m_position, m_direction * 0.6f , Vec2{ 0.03f, 0.01f }, 1.5f }
+                Projectile{ m_position - velocity * back, velocity, m_projectile_size, m_projectile_life_time + back }
             );
         }
 
+        m_cool_down = std::max(0.0f, m_cool_down - delta_time);
+
         return std::make_tuple(false, Projectile{});
     }
 
     //==========================================================================
-    std::vector<Vec2> polygonSRT() const
+    std::array<Vec2, 3> polygonSRT() const
     {
-        const auto & vertices = m_polygon.vertices();
+        std::array<Vec2, 3> result;
 
-        std::vector<Vec2> result;
-        result.reserve(vertices.size());
-
-        for (const auto & v : vertices)
-            result.emplace_back(multiply(v, m_rotation_matrix) * m_size + m_position);
+        for (std::size_t i = 0; i < result.size(); ++i)
+            result[i] = multiply(DEFAULT_SHIP_MODEL[i], m_rotation_matrix) * m_size + m_position;
 
         return result;
     }
 
 private:
+    std::uint32_t m_id{ 0 };
+
     float m_size; // TODO: generalize Object (AABB size position velocity rotation matrix...)
     Vec2 m_position;
     Vec2 m_direction;
@@ -233,7 +304,9 @@ private:
     float m_movement_speed;
     float m_rotation_speed;
 
-    Polygon m_polygon;
+    float m_projectile_speed;
+    Vec2 m_projectile_size;
+    float m_projectile_life_time;
 
     AABB m_bounding_box;
     float m_rotation_matrix[4];
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <cassert>
+#include <type_traits>
+
+// Vector with N elements of inline storage. Stays off the heap as long as the
+// size does not exceed N, only then it spills into a heap allocation.
+// Restricted to trivially copyable types so elements can be moved with memcpy.
+template <typename T, std::size_t N>
+class SmallVector
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SmallVector requires trivially copyable elements");
+    static_assert(N > 0, "SmallVector requires inline capacity");
+
+public:
+    //==========================================================================
+    SmallVector() {}
+
+    //==========================================================================
+    SmallVector(const SmallVector & other)
+    {
+        assign(other.data(), other.size());
+    }
+
+    //==========================================================================
+    SmallVector(SmallVector && other)
+    {
+        if (other.onHeap())
+        {
+            m_data     = other.m_data;
+            m_size     = other.m_size;
+            m_capacity = other.m_capacity;
+
+            other.m_data     = other.m_inline;
+            other.m_size     = 0;
+            other.m_capacity = N;
+        }
+        else
+        {
+            assign(other.data(), other.size());
+            other.m_size = 0;
+        }
+    }
+
+    //==========================================================================
+    SmallVector & operator = (const SmallVector & other)
+    {
+        if (this != &other)
+            assign(other.data(), other.size());
+
+        return *this;
+    }
+
+    //==========================================================================
+    SmallVector & operator = (SmallVector && other)
+    {
+        if (this == &other)
+            return *this;
+
+        if (other.onHeap())
+        {
+            release();
+
+            m_data     = other.m_data;
+            m_size     = other.m_size;
+            m_capacity = other.m_capacity;
+
+            other.m_data     = other.m_inline;
+            other.m_size     = 0;
+            other.m_capacity = N;
+        }
+        else
+        {
+            assign(other.data(), other.size());
+            other.m_size = 0;
+        }
+
+        return *this;
+    }
+
+    //==========================================================================
+    ~SmallVector()
+    {
+        release();
+    }
+
+    //==========================================================================
+    void reserve(std::size_t capacity)
+    {
+        if (capacity <= m_capacity)
+            return;
+
+        T * data = new T[capacity];
+        std::memcpy(data, m_data, m_size * sizeof(T));
+
+        release();
+
+        m_data     = data;
+        m_capacity = capacity;
+    }
+
+    //==========================================================================
+    void push_back(const T & value)
+    {
+        if (m_size == m_capacity)
+            reserve(m_capacity * 2);
+
+        m_data[m_size++] = value;
+    }
+
+    //==========================================================================
+    template <typename ... Args>
+    T & emplace_back(Args && ... args)
+    {
+        push_back(T{ std::forward<Args>(args)... });
+        return m_data[m_size - 1];
+    }
+
+    //==========================================================================
+    void resize(std::size_t size)
+    {
+        reserve(size);
+        m_size = size;
+    }
+
+    //==========================================================================
+    void clear() { m_size = 0; }
+
+    //==========================================================================
+    std::size_t size() const { return m_size; }
+    std::size_t capacity() const { return m_capacity; }
+    bool empty() const { return m_size == 0; }
+    bool onHeap() const { return m_data != m_inline; }
+
+    //==========================================================================
+    T * data() { return m_data; }
+    const T * data() const { return m_data; }
+
+    T * begin() { return m_data; }
+    T * end() { return m_data + m_size; }
+    const T * begin() const { return m_data; }
+    const T * end() const { return m_data + m_size; }
+
+    T & operator [] (std::size_t i) { assert(i < m_size); return m_data[i]; }
+    const T & operator [] (std::size_t i) const { assert(i < m_size); return m_data[i]; }
+
+private:
+    //==========================================================================
+    void assign(const T * data, std::size_t size)
+    {
+        if (size > m_capacity)
+        {
+            release();
+
+            m_data     = new T[size];
+            m_capacity = size;
+        }
+
+        std::memcpy(m_data, data, size * sizeof(T));
+        m_size = size;
+    }
+
+    //==========================================================================
+    void release()
+    {
+        if (onHeap())
+            delete [] m_data;
+
+        m_data     = m_inline;
+        m_capacity = N;
+    }
+
+    T m_inline[N];
+    T * m_data{ m_inline };
+    std::size_t m_size{ 0 };
+    std::size_t m_capacity{ N };
+
+};
@@ -0,0 +1,102 @@
+#include "SpatialGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Rock.hpp"
+
+namespace
+{
+    //==========================================================================
+    // Cell index of a coordinate without wrapping, negative left of the world
+    long unwrapped_cell(float coordinate, float world_size, float cell_size)
+    {
+        return static_cast<long>(std::floor((coordinate + world_size) / cell_size));
+    }
+}
+
+//==============================================================================
+SpatialGrid::SpatialGrid(float world_size, float cell_size) :
+    m_world_size{ world_size },
+    m_cells{ std::max<std::size_t>(1, static_cast<std::size_t>(2.0f * world_size / cell_size)) },
+    m_cell_size{ 2.0f * world_size / static_cast<float>(m_cells) },
+    m_cell_start(m_cells * m_cells + 1)
+{
+}
+
+//==============================================================================
+std::size_t SpatialGrid::cellOf(float coordinate) const
+{
+    // rocks leave the square by up to their size before they wrap, they go to the edge cells
+    const long cell = unwrapped_cell(coordinate, m_world_size, m_cell_size);
+    return static_cast<std::size_t>(std::min(std::max(cell, 0L), static_cast<long>(m_cells) - 1));
+}
+
+//==============================================================================
+void SpatialGrid::build(const std::vector<Rock> & rocks)
+{
+    m_rock_cell.resize(rocks.size());
+    m_indices.resize(rocks.size());
+    std::fill(m_cell_start.begin(), m_cell_start.end(), 0);
+
+    // count the rocks per cell, shifted by one so the prefix sum gives the starts
+    for (std::size_t i = 0; i < rocks.size(); ++i)
+    {
+        const auto & p = rocks[i].position();
+        const auto cell = static_cast<std::uint32_t>(cellOf(p.y) * m_cells + cellOf(p.x));
+
+        m_rock_cell[i] = cell;
+        m_cell_start[cell + 1]++;
+    }
+
+    for (std::size_t c = 1; c < m_cell_start.size(); ++c)
+        m_cell_start[c] += m_cell_start[c - 1];
+
+    // scatter, every cell start advances as the write position of its cell and is shifted back after
+    for (std::size_t i = 0; i < rocks.size(); ++i)
+        m_indices[m_cell_start[m_rock_cell[i]]++] = static_cast<std::uint32_t>(i);
+
+    for (std::size_t c = m_cell_start.size() - 1; c > 0; --c)
+        m_cell_start[c] = m_cell_start[c - 1];
+    m_cell_start[0] = 0;
+}
+
+//==============================================================================
+void SpatialGrid::query(const AABB & region, float margin, std::vector<Candidate> & out) const
+{
+    const auto mn = region.getMin() - margin;
+    const auto mx = region.getMax() + margin;
+
+    const long cells = static_cast<long>(m_cells);
+    const float period = 2.0f * m_world_size;
+
+    // a region larger than the world visits every cell once
+    const long x0 = unwrapped_cell(mn.x, m_world_size, m_cell_size);
+    const long y0 = unwrapped_cell(mn.y, m_world_size, m_cell_size);
+    const long x1 = std::min(unwrapped_cell(mx.x, m_world_size, m_cell_size), x0 + cells - 1);
+    const long y1 = std::min(unwrapped_cell(mx.y, m_world_size, m_cell_size), y0 + cells - 1);
+
+    // cell of an unwrapped cell index and the periods between them
+    const auto wrap = [cells] (long cell, long & wrapped)
+    {
+        const long turns = cell >= 0 ? cell / cells : -((cells - 1 - cell) / cells);
+        wrapped = cell - turns * cells;
+        return static_cast<float>(turns);
+    };
+
+    for (long y = y0; y <= y1; ++y)
+    {
+        long cy;
+        const float oy = wrap(y, cy) * period;
+
+        for (long x = x0; x <= x1; ++x)
+        {
+            long cx;
+            const float ox = wrap(x, cx) * period;
+
+            const auto cell = static_cast<std::size_t>(cy * cells + cx);
+            for (auto i = m_cell_start[cell]; i < m_cell_start[cell + 1]; ++i)
+                out.push_back(Candidate{ m_indices[i], Vec2{ ox, oy } });
+        }
+    }
+}
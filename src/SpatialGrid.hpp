@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "Vec2.hpp"
+#include "AABB.hpp"
+
+class Rock;
+
+// Uniform grid of rock indices over the wrapping [-world_size, world_size]
+// square, for finding the rocks in view without visiting all of them.
+//
+// build() sorts the indices by cell with a counting sort into one array, the
+// rocks of a cell are a range of it. Rocks are binned by position, the ones
+// that left the square but have not wrapped yet into the edge cells, so a
+// query grows the region by a margin of twice the largest rock to find rocks
+// reaching in from a neighbour cell. Regions across the seam are split into
+// the cells on the other side, every candidate comes with the offset of the
+// copy of the rock inside the region. Candidates are only near the region,
+// the caller tests their boxes.
+class SpatialGrid
+{
+public:
+    struct Candidate
+    {
+        std::uint32_t index;
+        Vec2 offset;
+    };
+
+    // cells no smaller than cell_size, a whole number of them spans the world
+    SpatialGrid(float world_size, float cell_size);
+
+    void build(const std::vector<Rock> & rocks);
+
+    // Rocks in cells within margin of region, appended to out
+    void query(const AABB & region, float margin, std::vector<Candidate> & out) const;
+
+    std::size_t cellsPerAxis() const { return m_cells; }
+
+private:
+    std::size_t cellOf(float coordinate) const;
+
+    float m_world_size;
+    std::size_t m_cells;
+    float m_cell_size;
+
+    // rocks of cell c are m_indices[m_cell_start[c] .. m_cell_start[c + 1]), cells in rows of y
+    std::vector<std::uint32_t> m_cell_start;
+    std::vector<std::uint32_t> m_indices;
+
+    // cell of every rock, kept between builds so they allocate nothing
+    std::vector<std::uint32_t> m_rock_cell;
+
+};
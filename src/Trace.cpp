@@ -0,0 +1,150 @@
+#include "Trace.hpp"
+
+#include <stdexcept>
+
+#ifdef ASTEROIDS_TRACE
+
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+namespace
+{
+    struct ThreadTrace
+    {
+        std::string name;
+        TraceBuffer buffer;
+    };
+
+    // buffers outlive their threads so spans of finished threads can still be exported
+    std::mutex s_mutex;
+    std::vector<std::unique_ptr<ThreadTrace>> s_threads;
+
+    thread_local ThreadTrace * t_thread = nullptr;
+
+    //==========================================================================
+    ThreadTrace & thread_trace()
+    {
+        if (t_thread == nullptr)
+        {
+            std::lock_guard<std::mutex> lock{ s_mutex };
+
+            s_threads.push_back(std::make_unique<ThreadTrace>());
+            s_threads.back()->name = "thread " + std::to_string(s_threads.size());
+
+            t_thread = s_threads.back().get();
+        }
+
+        return *t_thread;
+    }
+
+    //==========================================================================
+    void write_string(std::ostream & out, const std::string & s)
+    {
+        out << '"';
+
+        for (const char c : s)
+            if (c == '"' || c == '\\')
+                out << '\\' << c;
+            else if (static_cast<unsigned char>(c) >= 0x20)
+                out << c;
+
+        out << '"';
+    }
+}
+
+//==============================================================================
+TraceBuffer & trace_thread_buffer()
+{
+    return thread_trace().buffer;
+}
+
+//==============================================================================
+void trace_set_thread_name(const char * name)
+{
+    auto & trace = thread_trace();
+
+    std::lock_guard<std::mutex> lock{ s_mutex };
+    trace.name = name;
+}
+
+//==============================================================================
+void trace_export(const std::string & file_name)
+{
+    std::ofstream file{ file_name };
+    if (file.is_open() == false)
+        throw std::runtime_error("Failed to open trace file: " + file_name);
+
+    std::lock_guard<std::mutex> lock{ s_mutex };
+
+    // snapshot every ring, writers keep running while this copies
+    std::vector<std::vector<TraceEvent>> events(s_threads.size());
+    std::uint64_t origin = std::numeric_limits<std::uint64_t>::max();
+
+    for (std::size_t t = 0; t < s_threads.size(); ++t)
+    {
+        const auto & buffer = s_threads[t]->buffer;
+
+        const auto written = buffer.written();
+        const auto first = written > TraceBuffer::CAPACITY ? written - TraceBuffer::CAPACITY : 0;
+
+        for (auto i = first; i < written; ++i)
+            events[t].push_back(buffer.event(i));
+
+        // drop events the writer overwrote during the copy
+        const auto after = buffer.written();
+        const auto overwritten = after > TraceBuffer::CAPACITY ? after - TraceBuffer::CAPACITY : 0;
+        if (overwritten > first)
+            events[t].erase(events[t].begin(), events[t].begin() + static_cast<std::ptrdiff_t>(std::min(overwritten - first, written - first)));
+
+        for (const auto & e : events[t])
+            origin = std::min(origin, e.begin);
+    }
+
+    // timestamps in microseconds relative to the first event, nanosecond precision
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[" << std::fixed << std::setprecision(3);
+
+    bool first_event = true;
+    const auto separator = [&file, &first_event]
+    {
+        if (first_event == false) file << ",\n";
+        first_event = false;
+    };
+
+    for (std::size_t t = 0; t < s_threads.size(); ++t)
+    {
+        separator();
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t + 1 << ",\"args\":{\"name\":";
+        write_string(file, s_threads[t]->name);
+        file << "}}";
+
+        for (const auto & e : events[t])
+        {
+            separator();
+            file << "{\"name\":";
+            write_string(file, e.name);
+            file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << t + 1
+                 << ",\"ts\":" << static_cast<double>(e.begin - origin) / 1000.0
+                 << ",\"dur\":" << static_cast<double>(e.end - e.begin) / 1000.0 << "}";
+        }
+    }
+
+    file << "]}\n";
+
+    if (!file)
+        throw std::runtime_error("Failed to write trace file: " + file_name);
+}
+
+#else
+
+//==============================================================================
+void trace_export(const std::string & file_name)
+{
+    throw std::runtime_error("Can't write " + file_name + ", built without ASTEROIDS_TRACE.");
+}
+
+#endif
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+// Scoped trace spans for looking at single frames on a timeline.
+//
+//     TRACE_SCOPE("broad phase");
+//
+// records the time from the macro to the end of the enclosing scope into a
+// ring buffer owned by the calling thread, so recording never takes a lock.
+// Names must be string literals, only the pointer is stored. Without
+// ASTEROIDS_TRACE the macros expand to nothing.
+#ifdef ASTEROIDS_TRACE
+
+#include <atomic>
+#include <chrono>
+
+constexpr bool TRACE_ENABLED = true;
+
+//==============================================================================
+inline std::uint64_t trace_now()
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count());
+}
+
+struct TraceEvent
+{
+    const char * name;
+    std::uint64_t begin;
+    std::uint64_t end;
+};
+
+// Single writer ring buffer, the oldest events are overwritten when full
+class TraceBuffer
+{
+public:
+    static constexpr std::size_t CAPACITY = 1 << 16;
+
+    //==========================================================================
+    void record(const char * name, std::uint64_t begin, std::uint64_t end)
+    {
+        const auto i = m_written.load(std::memory_order_relaxed);
+        m_events[i & (CAPACITY - 1)] = TraceEvent{ name, begin, end };
+        m_written.store(i + 1, std::memory_order_release);
+    }
+
+    //==========================================================================
+    std::uint64_t written() const { return m_written.load(std::memory_order_acquire); }
+    const TraceEvent & event(std::uint64_t i) const { return m_events[i & (CAPACITY - 1)]; }
+
+private:
+    std::atomic<std::uint64_t> m_written{ 0 };
+    TraceEvent m_events[CAPACITY];
+
+};
+
+// Buffer of the calling thread, created on first use
+TraceBuffer & trace_thread_buffer();
+
+// Name shown for the calling thread in the exported trace
+void trace_set_thread_name(const char * name);
+
+//==============================================================================
+class TraceScope
+{
+public:
+    explicit TraceScope(const char * name) :
+        m_name{ name },
+        m_begin{ trace_now() }
+    {
+    }
+
+    ~TraceScope()
+    {
+        trace_thread_buffer().record(m_name, m_begin, trace_now());
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope & operator = (const TraceScope &) = delete;
+
+private:
+    const char * m_name;
+    std::uint64_t m_begin;
+
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__){ name }
+#define TRACE_THREAD_NAME(name) trace_set_thread_name(name)
+
+#else
+
+constexpr bool TRACE_ENABLED = false;
+
+#define TRACE_SCOPE(name) do {} while (false)
+#define TRACE_THREAD_NAME(name) do {} while (false)
+
+#endif
+
+// Writes every recorded span as Chrome trace event JSON (loads in Perfetto and
+// chrome://tracing). Throws std::runtime_error if tracing is compiled out or
+// the file can't be written.
+void trace_export(const std::string & file_name);
@@ -1,12 +1,10 @@
 #pragma once
 
-#include <vector>
-
 struct Vec2
 {
-    Vec2(float a, float b) : x{ a }, y{ b } {}
-    Vec2(const Vec2 & a) : x{ a.x }, y{ a.y } {}
-    Vec2() {}
+    constexpr Vec2(float a, float b) : x{ a }, y{ b } {}
+    constexpr Vec2(const Vec2 & a) = default;
+    Vec2() = default;
 
     float x, y;
 };
@@ -25,8 +23,12 @@ Vec2 operator - (const Vec2 & v1, const Vec2 & v2);
 Vec2 operator / (const Vec2 & v1, const Vec2 & v2);
 Vec2 operator * (const Vec2 & v1, const Vec2 & v2);
 
-void wrap_around(Vec2 & point, const Vec2 & size);
+// Moves a body of half extent size that left the [-world_size, world_size]
+// square to the other side
+void wrap_around(Vec2 & point, const Vec2 & size, float world_size);
 
-Vec2 multiply(const Vec2 & v, const float m[4]);
+// Euler step followed by wrap_around. Out of line on purpose, network clients
+// dead reckon bodies with the same instructions the server used.
+void integrate_wrapped(Vec2 & position, const Vec2 & velocity, float delta_time, const Vec2 & size, float world_size);
 
-bool polygons_intersect(const std::vector<Vec2> & a, const std::vector<Vec2> & b);
+Vec2 multiply(const Vec2 & v, const float m[4]);
@@ -0,0 +1,126 @@
+#include "Vec2Gen.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#include <xmmintrin.h>
+#endif
+
+static_assert(sizeof(Vec2) == 2 * sizeof(float), "points are stored as float pairs");
+
+namespace
+{
+#if defined(__SSE2__)
+    //==========================================================================
+    // Low and high halves of the 32 x 32 bit products of every lane of a and m
+    void multiply_wide(__m128i a, std::uint32_t m, __m128i & lo, __m128i & hi)
+    {
+        const __m128i mm = _mm_set1_epi32(static_cast<int>(m));
+
+        const __m128i even = _mm_mul_epu32(a, mm);                      // lanes 0 and 2
+        const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), mm);   // lanes 1 and 3
+
+        // shifts and masks instead of shuffles, which all compete for one port
+        const __m128i low_words = _mm_set1_epi64x(0xFFFFFFFF);
+
+        lo = _mm_or_si128(_mm_and_si128(even, low_words), _mm_slli_epi64(odd, 32));
+        hi = _mm_or_si128(_mm_srli_epi64(even, 32), _mm_andnot_si128(low_words, odd));
+    }
+
+    //==========================================================================
+    __m128 unit(__m128i bits)
+    {
+        return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(bits, 8)), _mm_set1_ps(1.0f / 16777216.0f));
+    }
+
+    //==========================================================================
+    // Blocks index .. index + 4 * GROUPS - 1 of the stream, one block per lane,
+    // written as 8 points per group. The groups are independent, interleaving
+    // them hides the latency of the multiplies.
+    template <int GROUPS>
+    void philox_blocks(std::uint32_t seed, std::uint32_t stream, std::uint64_t index, float * out)
+    {
+        __m128i c0[GROUPS], c1[GROUPS], c2[GROUPS], c3[GROUPS];
+
+        for (int g = 0; g < GROUPS; ++g)
+        {
+            const auto word = [index, g] (int block, int shift) { return static_cast<int>(static_cast<std::uint32_t>((index + 4 * g + block) >> shift)); };
+
+            c0[g] = _mm_set_epi32(word(3, 0), word(2, 0), word(1, 0), word(0, 0));
+            c1[g] = _mm_set_epi32(word(3, 32), word(2, 32), word(1, 32), word(0, 32));
+            c2[g] = _mm_setzero_si128();
+            c3[g] = _mm_setzero_si128();
+        }
+
+        std::uint32_t k0 = seed;
+        std::uint32_t k1 = stream;
+
+        for (int round = 0; round < Vec2Gen::ROUNDS; ++round)
+        {
+            if (round > 0)
+            {
+                k0 += Vec2Gen::WEYL_0;
+                k1 += Vec2Gen::WEYL_1;
+            }
+
+            const __m128i key0 = _mm_set1_epi32(static_cast<int>(k0));
+            const __m128i key1 = _mm_set1_epi32(static_cast<int>(k1));
+
+            for (int g = 0; g < GROUPS; ++g)
+            {
+                __m128i lo0, hi0, lo1, hi1;
+                multiply_wide(c0[g], Vec2Gen::MULTIPLIER_0, lo0, hi0);
+                multiply_wide(c2[g], Vec2Gen::MULTIPLIER_1, lo1, hi1);
+
+                c0[g] = _mm_xor_si128(_mm_xor_si128(hi1, c1[g]), key0);
+                c1[g] = lo1;
+                c2[g] = _mm_xor_si128(_mm_xor_si128(hi0, c3[g]), key1);
+                c3[g] = lo0;
+            }
+        }
+
+        // lanes hold blocks, memory holds the 4 words of one block after the other
+        for (int g = 0; g < GROUPS; ++g)
+        {
+            __m128 r0 = unit(c0[g]);
+            __m128 r1 = unit(c1[g]);
+            __m128 r2 = unit(c2[g]);
+            __m128 r3 = unit(c3[g]);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+            float * o = out + 16 * g;
+            _mm_storeu_ps(o, r0);
+            _mm_storeu_ps(o + 4, r1);
+            _mm_storeu_ps(o + 8, r2);
+            _mm_storeu_ps(o + 12, r3);
+        }
+    }
+#endif
+}
+
+//==============================================================================
+void Vec2Gen::fill(Vec2 * out, std::size_t count)
+{
+    // up to the start of a block
+    while (count != 0 && m_state.counter % 2 != 0)
+    {
+        *out++ = get();
+        count--;
+    }
+
+#if defined(__SSE2__)
+    for (; count >= 32; count -= 32, out += 32)
+    {
+        philox_blocks<4>(m_state.seed, m_state.stream, m_state.counter / 2, reinterpret_cast<float *>(out));
+        m_state.counter += 32;
+    }
+
+    for (; count >= 8; count -= 8, out += 8)
+    {
+        philox_blocks<1>(m_state.seed, m_state.stream, m_state.counter / 2, reinterpret_cast<float *>(out));
+        m_state.counter += 8;
+    }
+#endif
+
+    for (; count != 0; --count)
+        *out++ = get();
+}
@@ -1,30 +1,110 @@
 #pragma once
 
-#include <random>
+#include <cstddef>
+#include <cstdint>
 
 #include "Vec2.hpp"
 
+// Uniform points in [0, 1) x [0, 1) from the Philox4x32-10 counter based
+// generator. Draw n of (seed, stream) is a pure function of the three, so any
+// number of independent streams can be derived from one seed, per thread or
+// per entity, and give the same values however the work is split. Every
+// Philox block holds two points.
 class Vec2Gen
 {
 public:
-    Vec2Gen(
-        std::minstd_rand::result_type seed = std::minstd_rand::default_seed
-    ) :
-        generator{ seed },
-        // according to standard this is a half range, but implementations use inclusive range
-        x_distribution{ 0.0f, 1.0f },
-        y_distribution{ 0.0f, 1.0f }
+    // Everything the sequence depends on, restoring it continues the exact same sequence
+    struct State
+    {
+        std::uint32_t seed{ 1 };
+        std::uint32_t stream{ 0 };
+        std::uint64_t counter{ 0 };     // points drawn so far
+
+        bool operator == (const State & other) const { return seed == other.seed && stream == other.stream && counter == other.counter; }
+        bool operator != (const State & other) const { return !(*this == other); }
+    };
+
+    Vec2Gen(std::uint32_t seed = 1, std::uint32_t stream = 0) :
+        m_state{ seed, stream, 0 }
     {}
 
     Vec2 get()
     {
-        return Vec2{ x_distribution(generator), y_distribution(generator) };
+        const auto block = m_state.counter / 2;
+        if (block != m_block_index)
+        {
+            philox(m_state.seed, m_state.stream, block, m_block);
+            m_block_index = block;
+        }
+
+        const auto lane = static_cast<std::size_t>(m_state.counter % 2) * 2;
+        m_state.counter++;
+
+        return Vec2{ unit(m_block[lane]), unit(m_block[lane + 1]) };
+    }
+
+    // The next count points, the same as count calls of get()
+    void fill(Vec2 * out, std::size_t count);
+
+    const State & state() const { return m_state; }
+
+    void restore(const State & state)
+    {
+        m_state = state;
+        m_block_index = NO_BLOCK;
     }
 
+    // Block index of the stream, 4 words of 32 random bits
+    static void philox(std::uint32_t seed, std::uint32_t stream, std::uint64_t index, std::uint32_t out[4])
+    {
+        std::uint32_t c[4]{ static_cast<std::uint32_t>(index), static_cast<std::uint32_t>(index >> 32), 0, 0 };
+        std::uint32_t k[2]{ seed, stream };
+
+        for (int round = 0; round < ROUNDS; ++round)
+        {
+            if (round > 0)
+            {
+                k[0] += WEYL_0;
+                k[1] += WEYL_1;
+            }
+
+            const std::uint64_t p0 = static_cast<std::uint64_t>(MULTIPLIER_0) * c[0];
+            const std::uint64_t p1 = static_cast<std::uint64_t>(MULTIPLIER_1) * c[2];
+
+            const std::uint32_t next[4]{
+                static_cast<std::uint32_t>(p1 >> 32) ^ c[1] ^ k[0],
+                static_cast<std::uint32_t>(p1),
+                static_cast<std::uint32_t>(p0 >> 32) ^ c[3] ^ k[1],
+                static_cast<std::uint32_t>(p0)
+            };
+
+            for (int i = 0; i < 4; ++i)
+                c[i] = next[i];
+        }
+
+        for (int i = 0; i < 4; ++i)
+            out[i] = c[i];
+    }
+
+    // The top 24 bits as a float in [0, 1), exact so the SIMD path matches
+    static float unit(std::uint32_t bits)
+    {
+        return static_cast<float>(static_cast<std::int32_t>(bits >> 8)) * (1.0f / 16777216.0f);
+    }
+
+    static constexpr int ROUNDS = 10;
+    static constexpr std::uint32_t MULTIPLIER_0 = 0xD2511F53;
+    static constexpr std::uint32_t MULTIPLIER_1 = 0xCD9E8D57;
+    static constexpr std::uint32_t WEYL_0 = 0x9E3779B9;
+    static constexpr std::uint32_t WEYL_1 = 0xBB67AE85;
+
 private:
-    std::minstd_rand generator;
+    static constexpr std::uint64_t NO_BLOCK = ~std::uint64_t{ 0 };
+
+    State m_state;
 
-    std::uniform_real_distribution<float> x_distribution;
-    std::uniform_real_distribution<float> y_distribution;
+    // cache of the block the latest point came from, not part of the state
+    std::uint64_t m_block_index{ NO_BLOCK };
+    std::uint32_t m_block[4]{};
 
 };
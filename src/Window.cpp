@@ -4,14 +4,19 @@
 #include "Keyboard.hpp"
 #include <stdexcept>
 
+#include "Trace.hpp"
+#include "GlHandle.hpp"
+
 //==============================================================================
-Window::Window()
+Window::Window(int samples)
 {
+    TRACE_SCOPE("Window::Window");
+
     // Initialize GLFW
     if (glfwInit() != GL_TRUE) throw std::runtime_error("Failed to initialize GLFW.");
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
-    glfwWindowHint(GLFW_SAMPLES, 16);
+    glfwWindowHint(GLFW_SAMPLES, samples);
 
     // Create window
     m_window = glfwCreateWindow(720, 720, "The Window :)", nullptr, nullptr);
@@ -33,11 +38,17 @@ Window::Window()
     glfwGetFramebufferSize(m_window, &fb_width, &fb_height);
     glViewport(0, 0, fb_width, fb_height);
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+    glGetIntegerv(GL_SAMPLES, &m_samples);
 }
 
 //==============================================================================
 Window::~Window()
 {
+    // GL objects dropped since the last frame still belong to this context
+    glfwMakeContextCurrent(m_window);
+    flush_gl_deletions();
+
     glfwDestroyWindow(m_window);
     glfwTerminate();
 }
@@ -54,6 +65,24 @@ double Window::aspectRatio() const
     return static_cast<double>(fb_width) / static_cast<double>(fb_height);
 }
 
+//==============================================================================
+int Window::width() const
+{
+    return fb_width;
+}
+
+//==============================================================================
+int Window::height() const
+{
+    return fb_height;
+}
+
+//==============================================================================
+int Window::samples() const
+{
+    return m_samples;
+}
+
 //==============================================================================
 void Window::swapResizeClearBuffer()
 {
@@ -63,6 +92,9 @@ void Window::swapResizeClearBuffer()
     glViewport(0, 0, fb_width, fb_height);
 
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // GL objects dropped during the frame, one glDelete* call per object type
+    flush_gl_deletions();
 }
 
 //==============================================================================
@@ -82,3 +114,27 @@ void Window::pollEvents()
 {
     glfwPollEvents();
 }
+
+//==============================================================================
+void Window::waitEvents()
+{
+    glfwWaitEvents();
+}
+
+//==============================================================================
+void Window::waitEvents(double timeout)
+{
+    glfwWaitEventsTimeout(timeout);
+}
+
+//==============================================================================
+bool Window::focused() const
+{
+    return glfwGetWindowAttrib(m_window, GLFW_FOCUSED) != 0;
+}
+
+//==============================================================================
+bool Window::iconified() const
+{
+    return glfwGetWindowAttrib(m_window, GLFW_ICONIFIED) != 0;
+}
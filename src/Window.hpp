@@ -6,13 +6,19 @@ class Window
 {
 public:
 
-    Window();
+    // samples of the default framebuffer, 0 for none
+    explicit Window(int samples = 16);
     ~Window();
 
     void makeContextCurrent();
 
     double aspectRatio() const;
 
+    int width() const;
+    int height() const;
+    // samples the default framebuffer got, may differ from the requested ones
+    int samples() const;
+
     void swapResizeClearBuffer();
 
     bool exitRequested();
@@ -20,9 +26,18 @@ public:
 
     void pollEvents();
 
+    // Blocks until events arrive and processes them, at most timeout seconds if given
+    void waitEvents();
+    void waitEvents(double timeout);
+
+    // as of the last processed events
+    bool focused() const;
+    bool iconified() const;
+
 private:
     GLFWwindow * m_window;
     int fb_width;
     int fb_height;
+    int m_samples{ 0 };
 
 };
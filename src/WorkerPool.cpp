@@ -0,0 +1,83 @@
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+
+#include "Trace.hpp"
+
+//==============================================================================
+WorkerPool::WorkerPool(std::size_t thread_count)
+{
+    if (thread_count == 0)
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+    for (std::size_t i = 1; i < thread_count; ++i)
+        m_threads.emplace_back(&WorkerPool::work, this, i);
+}
+
+//==============================================================================
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        m_stop = true;
+    }
+    m_start.notify_all();
+
+    for (auto & thread : m_threads)
+        thread.join();
+}
+
+//==============================================================================
+void WorkerPool::run(std::size_t task_count, const Task & task)
+{
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        m_task = &task;
+        m_task_count = task_count;
+        m_next_task.store(0, std::memory_order_relaxed);
+        m_busy = m_threads.size();
+        m_job++;
+    }
+    m_start.notify_all();
+
+    drain(0);
+
+    // every thread has to leave the job before the task goes out of scope
+    std::unique_lock<std::mutex> lock{ m_mutex };
+    m_done.wait(lock, [this] { return m_busy == 0; });
+    m_task = nullptr;
+}
+
+//==============================================================================
+void WorkerPool::work(std::size_t worker)
+{
+    TRACE_THREAD_NAME("worker");
+
+    std::uint64_t job = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock{ m_mutex };
+            m_start.wait(lock, [this, job] { return m_stop || m_job != job; });
+
+            if (m_stop)
+                return;
+
+            job = m_job;
+        }
+
+        drain(worker);
+
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        if (--m_busy == 0)
+            m_done.notify_one();
+    }
+}
+
+//==============================================================================
+void WorkerPool::drain(std::size_t worker)
+{
+    for (auto i = m_next_task.fetch_add(1); i < m_task_count; i = m_next_task.fetch_add(1))
+        (*m_task)(i, worker);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <cstdint>
+
+// Fixed set of threads that run the tasks of one job at a time. Tasks are
+// handed out through an atomic counter, so uneven tasks balance themselves,
+// and the calling thread works on the job too.
+class WorkerPool
+{
+public:
+    using Task = std::function<void(std::size_t task, std::size_t worker)>;
+
+    // threads including the caller, 0 for one per hardware thread
+    explicit WorkerPool(std::size_t thread_count = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool & operator = (const WorkerPool &) = delete;
+
+    std::size_t threadCount() const { return m_threads.size() + 1; }
+
+    // Runs task for every index in [0, task_count) and returns once all are
+    // done. worker is in [0, threadCount()), tasks of the same worker never
+    // run at the same time, so per worker scratch data needs no lock.
+    void run(std::size_t task_count, const Task & task);
+
+private:
+    void work(std::size_t worker);
+    void drain(std::size_t worker);
+
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+
+    const Task * m_task{ nullptr };
+    std::size_t m_task_count{ 0 };
+    std::atomic<std::size_t> m_next_task{ 0 };
+
+    std::uint64_t m_job{ 0 };
+    std::size_t m_busy{ 0 };    // threads that have not finished the current job
+    bool m_stop{ false };
+
+};
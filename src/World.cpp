@@ -0,0 +1,476 @@
+#include "World.hpp"
+
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+
+#include "Trace.hpp"
+#include "SectorStream.hpp"
+
+namespace
+{
+    //==========================================================================
+    // Vertex count of a new rock, a weighted pick from the tiers
+    int vertex_count(const std::vector<Scenario::VertexTier> & tiers, Vec2Gen & rng)
+    {
+        if (tiers.size() == 1)
+            return tiers.front().vertex_count;
+
+        float total = 0.0f;
+        for (const auto & t : tiers) total += t.weight;
+
+        float pick = rng.get().x * total;
+        for (const auto & t : tiers)
+        {
+            if (pick < t.weight)
+                return t.vertex_count;
+
+            pick -= t.weight;
+        }
+
+        return tiers.back().vertex_count;
+    }
+
+    //==========================================================================
+    // Projectile-rock pair of the broad phase, the rock is tested at its position plus offset
+    struct Candidate
+    {
+        std::uint32_t projectile;
+        std::uint32_t rock;
+        Vec2 offset;
+    };
+
+    //==========================================================================
+    // Seam crossing of every rock and the ghost proxies of those that cross, returns the number that cross
+    std::size_t make_rock_ghosts(const std::vector<Rock> & rocks, float world_size, ArenaVector<Vec2> & crossings, ArenaVector<GhostProxy> & ghosts)
+    {
+        crossings.clear();
+        ghosts.clear();
+        crossings.reserve(rocks.size());
+
+        std::size_t crossing_rocks = 0;
+
+        for (std::size_t i = 0; i < rocks.size(); ++i)
+        {
+            const auto crossing = seam_crossing(rocks[i].boundingBox(), world_size);
+            crossings.push_back(crossing);
+
+            Vec2 offsets[3];
+            const auto count = ghost_offsets(crossing, offsets);
+            for (std::size_t k = 0; k < count; ++k)
+                ghosts.push_back({ static_cast<std::uint32_t>(i), offsets[k] });
+
+            crossing_rocks += count != 0 ? 1 : 0;
+        }
+
+        return crossing_rocks;
+    }
+}
+
+//==============================================================================
+World::World(const Scenario & scenario, std::size_t ship_count) :
+    m_scenario{ scenario },
+    m_delta_time{ scenario.deltaTime() },
+    m_rng{ resolveSeed(scenario.seed) }
+{
+    for (std::size_t i = 0; i < ship_count; ++i)
+        addShip();
+
+    if (m_scenario.sector_size <= 0.0f)
+    {
+        generateRocks(m_scenario, m_rng, m_rocks, m_arena);
+        return;
+    }
+
+    // the sectors around the ships right away, the ring around them in the background
+    m_sectors = std::make_unique<SectorStream>(m_scenario, m_rng.state().seed);
+    for (const auto & player : m_players)
+        m_ship_positions.push_back(player.ship.position());
+    m_sectors->update(m_ship_positions.data(), m_ship_positions.size(), m_rocks);
+}
+
+//==============================================================================
+World::World(const Scenario & scenario, Restore) :
+    m_scenario{ scenario },
+    m_delta_time{ scenario.deltaTime() }
+{
+}
+
+//==============================================================================
+World::~World() = default;
+
+//==============================================================================
+std::uint32_t World::resolveSeed(std::uint32_t seed)
+{
+    if (seed != 0)
+        return seed;
+
+    // time based seed
+    const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>
+        (
+            std::chrono::high_resolution_clock::now().time_since_epoch()
+        ).count();
+
+    return static_cast<std::uint32_t>(now);
+}
+
+//==============================================================================
+World::Player World::newPlayer(const Scenario & s)
+{
+    return {
+        Ship{
+            s.ship_size, s.ship_speed, s.ship_rotation_speed, 1.0f / s.fire_rate,
+            s.projectile_speed, s.projectile_size, s.projectile_life_time
+        },
+        s.invincibility,
+        false
+    };
+}
+
+//==============================================================================
+void World::generateRocks(const Scenario & scenario, Vec2Gen & rng, std::vector<Rock> & rocks, MonotonicArena & arena)
+{
+    const float size_min = scenario.rock_size_min;
+    const float size_max = scenario.rock_size_max;
+
+    rocks.reserve(rocks.size() + scenario.rock_count);
+
+    for (std::size_t i = 0; i < scenario.rock_count; ++i)
+    {
+        // explicit order of random draws, function arguments have none
+        const float size = size_min + rng.get().x * (size_max - size_min);
+        const int vertices = vertex_count(scenario.vertex_tiers, rng);
+        const Vec2 position = (rng.get() * 2.0f - 1.0f) * scenario.world_size;
+        const Vec2 velocity = (rng.get() * 2.0f - 1.0f) * scenario.rock_speed_max;
+
+        rocks.emplace_back(rng, size, vertices, position, velocity, &arena);
+
+        arena.reset();
+    }
+}
+
+//==============================================================================
+void World::generateSectorRocks(const Scenario & scenario, Vec2Gen & rng, const Vec2 & origin, float extent, std::size_t count,
+                                std::vector<Rock> & rocks, MonotonicArena & arena)
+{
+    const float size_min = scenario.rock_size_min;
+    const float size_max = scenario.rock_size_max;
+
+    rocks.reserve(rocks.size() + count);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        // the same order of draws as generateRocks
+        const float size = size_min + rng.get().x * (size_max - size_min);
+        const int vertices = vertex_count(scenario.vertex_tiers, rng);
+        const Vec2 position = origin + rng.get() * extent;
+        const Vec2 velocity = (rng.get() * 2.0f - 1.0f) * scenario.rock_speed_max;
+
+        rocks.emplace_back(rng, size, vertices, position, velocity, &arena);
+
+        arena.reset();
+    }
+}
+
+//==============================================================================
+std::size_t World::addShip()
+{
+    m_players.push_back(newPlayer(m_scenario));
+    return m_players.size() - 1;
+}
+
+//==============================================================================
+bool World::over() const
+{
+    if (cleared())
+        return true;
+
+    if (m_players.empty())
+        return false;
+
+    return std::all_of(m_players.begin(), m_players.end(), [] (const Player & p) { return p.destroyed; });
+}
+
+//==============================================================================
+std::size_t World::Snapshot::memoryBytes() const
+{
+    return sizeof(Snapshot) +
+           players.capacity() * sizeof(Player) +
+           rocks.capacity() * sizeof(Rock) +
+           projectiles.capacity() * sizeof(Projectile);
+}
+
+//==============================================================================
+void World::snapshot(Snapshot & snapshot) const
+{
+    if (m_sectors)
+        throw std::runtime_error("Snapshots and rewind don't support sector streamed worlds.");
+
+    snapshot.tick_count = m_tick_count;
+    snapshot.rng_state = m_rng.state();
+    snapshot.score = m_score;
+    snapshot.players = m_players;
+    snapshot.rocks = m_rocks;
+    snapshot.projectiles = m_projectiles;
+}
+
+//==============================================================================
+void World::restore(const Snapshot & snapshot)
+{
+    m_tick_count = snapshot.tick_count;
+    m_rng.restore(snapshot.rng_state);
+    m_score = snapshot.score;
+    m_players = snapshot.players;
+    m_rocks = snapshot.rocks;
+    m_projectiles = snapshot.projectiles;
+}
+
+//==============================================================================
+void World::tick(const InputFrame * inputs, std::size_t count)
+{
+    const float delta_time = m_delta_time;
+    const float world_size = m_scenario.world_size;
+
+    m_explosions.clear();
+
+    if (m_sectors)
+    {
+        TRACE_SCOPE("sectors");
+
+        m_ship_positions.clear();
+        for (const auto & player : m_players)
+            if (!player.destroyed)
+                m_ship_positions.push_back(player.ship.position());
+
+        m_sectors->update(m_ship_positions.data(), m_ship_positions.size(), m_rocks);
+    }
+
+    {
+        TRACE_SCOPE("move");
+
+        // move ships and shoot
+        for (std::size_t i = 0; i < m_players.size(); ++i)
+        {
+            auto & player = m_players[i];
+            if (player.destroyed)
+                continue;
+
+            const InputFrame input = i < count ? inputs[i] : InputFrame{};
+
+            player.ship.move(delta_time, input, world_size);
+            const auto shot = player.ship.shoot(delta_time, input, m_scenario.auto_fire);
+            if (std::get<0>(shot) == true)
+                m_projectiles.emplace_back(std::get<1>(shot));
+        }
+
+        // move rocks
+        std::for_each(m_rocks.begin(), m_rocks.end(), [delta_time, world_size] (Rock & r) { r.move(delta_time, world_size); });
+        // move projectiles
+        std::for_each(m_projectiles.begin(), m_projectiles.end(), [delta_time, world_size] (Projectile & p) { p.move(delta_time, world_size); });
+
+        // remove projectiles that reached end of life
+        m_projectiles.erase(std::remove_if(m_projectiles.begin(), m_projectiles.end(), [] (const Projectile & p) { return p.isDead(); }), m_projectiles.end());
+    }
+
+    // perform projectile-rock collision detection and resolution
+    // used algorithm can miss collisions due to tunneling
+
+    // seam crossing of every rock and the ghosts of those that cross it, made
+    // once a tick and again for the ships if rocks were split
+    ArenaVector<Vec2> rock_crossings{ ArenaAllocator<Vec2>{ &m_arena } };
+    ArenaVector<GhostProxy> rock_ghosts{ ArenaAllocator<GhostProxy>{ &m_arena } };
+
+    m_ghost_statistics.seam_rocks = make_rock_ghosts(m_rocks, world_size, rock_crossings, rock_ghosts);
+    m_ghost_statistics.rock_proxies = rock_ghosts.size();
+    m_ghost_statistics.seam_bodies = 0;
+    m_ghost_statistics.body_proxies = 0;
+    m_ghost_statistics.total_proxies += rock_ghosts.size();
+
+    // counts the ghosts of one projectile or ship
+    const auto count_ghosts = [this] (std::size_t proxies)
+    {
+        m_ghost_statistics.seam_bodies += proxies != 0 ? 1 : 0;
+        m_ghost_statistics.body_proxies += proxies;
+        m_ghost_statistics.total_proxies += proxies;
+    };
+
+    // projectile-rock pairs with overlapping bounding boxes, projectile major order: the
+    // rocks, the ghosts of the rocks, the rocks against the ghosts of the projectile, then
+    // the corners. A ghost is never tested against a ghost across the same seam, that is
+    // the pair of originals moved together, but a rock crossing one seam and a projectile
+    // crossing the other only meet at the corner, the rock moved across both seams.
+    ArenaVector<Candidate> candidates{ ArenaAllocator<Candidate>{ &m_arena } };
+    {
+        TRACE_SCOPE("broad phase");
+
+        for (std::size_t ip = 0; ip < m_projectiles.size(); ++ip)
+        {
+            const auto box = m_projectiles[ip].boundingBox();
+            const auto projectile = static_cast<std::uint32_t>(ip);
+
+            for (std::size_t ir = 0; ir < m_rocks.size(); ++ir)
+                if (AABB::intersect(box, m_rocks[ir].boundingBox()))
+                    candidates.push_back({ projectile, static_cast<std::uint32_t>(ir), Vec2{ 0.0f, 0.0f } });
+
+            for (const auto & ghost : rock_ghosts)
+                if (AABB::intersect(box, m_rocks[ghost.index].boundingBox() + ghost.offset))
+                    candidates.push_back({ projectile, ghost.index, ghost.offset });
+
+            const auto crossing = seam_crossing(box, world_size);
+
+            Vec2 offsets[3];
+            const auto count = ghost_offsets(crossing, offsets);
+            count_ghosts(count);
+
+            for (std::size_t k = 0; k < count; ++k)
+            {
+                // the ghost of the projectile at offset is the rock at minus offset, unless the rock has that ghost itself
+                const Vec2 offset = Vec2{ 0.0f, 0.0f } - offsets[k];
+
+                for (std::size_t ir = 0; ir < m_rocks.size(); ++ir)
+                    if (!has_ghost(rock_crossings[ir], offset) && AABB::intersect(box, m_rocks[ir].boundingBox() + offset))
+                        candidates.push_back({ projectile, static_cast<std::uint32_t>(ir), offset });
+            }
+
+            for (std::size_t ir = 0; ir < m_rocks.size() && count != 0; ++ir)
+            {
+                Vec2 corners[2];
+                const auto corner_count = corner_offsets(crossing, rock_crossings[ir], corners);
+
+                for (std::size_t k = 0; k < corner_count; ++k)
+                    if (AABB::intersect(box, m_rocks[ir].boundingBox() + corners[k]))
+                        candidates.push_back({ projectile, static_cast<std::uint32_t>(ir), corners[k] });
+            }
+        }
+    }
+
+    // rocks in the order they were hit, split in that order so the random draws don't depend on the rock order
+    ArenaVector<std::uint32_t> hit_rocks{ ArenaAllocator<std::uint32_t>{ &m_arena } };
+    {
+        TRACE_SCOPE("narrow phase");
+
+        for (const auto & c : candidates)
+        {
+            auto & p = m_projectiles[c.projectile];
+            const auto & r = m_rocks[c.rock];
+
+            // projectile can only hit one rock and a rock can only be hit once
+            if (p.isDead() || r.isHit())
+                continue;
+
+            if (m_narrow_phase.intersect(p.id(), p.polygonSRT(), r.id(), r.shape(), r.scale(), r.position() + c.offset))
+            {
+                m_rocks[c.rock].markHit();
+                hit_rocks.push_back(c.rock);
+
+                // mark used projectile dead
+                p.kill();
+            }
+        }
+    }
+
+    if (hit_rocks.empty() == false)
+    {
+        TRACE_SCOPE("split");
+
+        // split hit rocks
+        ArenaVector<Rock> new_rocks{ ArenaAllocator<Rock>{ &m_arena } };
+
+        for (const auto i : hit_rocks)
+        {
+            const auto & rock = m_rocks[i];
+            const auto first = new_rocks.size();
+            m_score += rockPoints(rock.split(m_rng, new_rocks, m_scenario.split_speed_max, &m_arena));
+
+            if (m_sectors)
+                m_sectors->split(rock, new_rocks.data() + first, new_rocks.size() - first);
+            m_explosions.push_back({ rock.position(), rock.velocity(), rock.scale(), false });
+        }
+
+        // remove hit rocks, keeping the order of the others
+        m_rocks.erase(std::remove_if(m_rocks.begin(), m_rocks.end(), [] (const Rock & r) { return r.isHit(); }), m_rocks.end());
+
+        // insert new rocks
+        m_rocks.insert(m_rocks.end(), std::make_move_iterator(new_rocks.begin()), std::make_move_iterator(new_rocks.end()));
+    }
+
+    // remove projectiles that have hit rocks
+    m_projectiles.erase(std::remove_if(m_projectiles.begin(), m_projectiles.end(), [] (Projectile & p) { return p.isDead(); }), m_projectiles.end());
+
+    // perform ship-rock collision detection and resolution
+    {
+        TRACE_SCOPE("ship collision");
+
+        // the ghosts of the broad phase unless rocks have been split since
+        bool ghosts_valid = hit_rocks.empty();
+
+        for (auto & player : m_players)
+        {
+            if (player.destroyed)
+                continue;
+
+            player.invincibility_left -= delta_time;
+            if (player.invincibility_left >= 0.0f)
+                continue;
+
+            if (!ghosts_valid)
+            {
+                make_rock_ghosts(m_rocks, world_size, rock_crossings, rock_ghosts);
+                ghosts_valid = true;
+            }
+
+            const auto & ship = player.ship;
+            const auto box = ship.boundingBox();
+
+            // broad-phase then narrow-phase with the rock at its position plus offset
+            const auto hits = [this, &ship, &box] (const Rock & r, const Vec2 & offset)
+            {
+                return AABB::intersect(box, r.boundingBox() + offset) &&
+                       m_narrow_phase.intersect(ship, r.id(), r.shape(), r.scale(), r.position() + offset);
+            };
+
+            // used algorithm can miss collisions due to tunneling
+            bool hit = false;
+
+            for (std::size_t ir = 0; ir < m_rocks.size() && !hit; ++ir)
+                hit = hits(m_rocks[ir], Vec2{ 0.0f, 0.0f });
+
+            for (std::size_t g = 0; g < rock_ghosts.size() && !hit; ++g)
+                hit = hits(m_rocks[rock_ghosts[g].index], rock_ghosts[g].offset);
+
+            const auto crossing = seam_crossing(box, world_size);
+
+            Vec2 offsets[3];
+            const auto count = ghost_offsets(crossing, offsets);
+            count_ghosts(count);
+
+            for (std::size_t k = 0; k < count && !hit; ++k)
+            {
+                const Vec2 offset = Vec2{ 0.0f, 0.0f } - offsets[k];
+
+                for (std::size_t ir = 0; ir < m_rocks.size() && !hit; ++ir)
+                    hit = !has_ghost(rock_crossings[ir], offset) && hits(m_rocks[ir], offset);
+            }
+
+            for (std::size_t ir = 0; ir < m_rocks.size() && count != 0 && !hit; ++ir)
+            {
+                Vec2 corners[2];
+                const auto corner_count = corner_offsets(crossing, rock_crossings[ir], corners);
+
+                for (std::size_t k = 0; k < corner_count && !hit; ++k)
+                    hit = hits(m_rocks[ir], corners[k]);
+            }
+
+            if (hit)
+            {
+                player.destroyed = true;
+                m_explosions.push_back({ ship.position(), Vec2{ 0.0f, 0.0f }, ship.size(), true });
+            }
+        }
+    }
+
+    m_tick_count++;
+
+    // candidates, hit_rocks and new_rocks only hold dead data at this point
+    m_arena.reset();
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+#include "Scenario.hpp"
+#include "Vec2Gen.hpp"
+#include "Rock.hpp"
+#include "Ship.hpp"
+#include "Projectile.hpp"
+#include "NarrowPhase.hpp"
+#include "Arena.hpp"
+#include "Input.hpp"
+
+class SectorStream;
+
+// Simulation state of one game, no rendering and no GL
+class World
+{
+public:
+    // A ship and the state the world keeps for it
+    struct Player
+    {
+        Ship ship;
+        float invincibility_left;
+        bool destroyed;
+    };
+
+    // Everything the next tick depends on. Rocks share their immutable shapes
+    // with the world, so a snapshot costs a few floats per body.
+    struct Snapshot
+    {
+        std::uint64_t tick_count{ 0 };
+        Vec2Gen::State rng_state;
+        std::uint64_t score{ 0 };
+        std::vector<Player> players;
+        std::vector<Rock> rocks;
+        std::vector<Projectile> projectiles;
+
+        // heap and inline bytes of this snapshot, the shared rock shapes not included
+        std::size_t memoryBytes() const;
+    };
+
+    // A rock that broke or a ship that was destroyed, for effects
+    struct Explosion
+    {
+        Vec2 position;
+        Vec2 velocity;
+        float size;
+        bool ship;
+    };
+
+    explicit World(const Scenario & scenario, std::size_t ship_count = 1);
+    ~World();
+
+    // seed, or a time based one for 0
+    static std::uint32_t resolveSeed(std::uint32_t seed);
+
+    // Ship of a new player with fresh invincibility, at the center
+    static Player newPlayer(const Scenario & scenario);
+
+    // Appends the rocks of a new game, drawing from rng in the order every
+    // world does, so the same seed always starts the same game
+    static void generateRocks(const Scenario & scenario, Vec2Gen & rng, std::vector<Rock> & rocks, MonotonicArena & arena);
+
+    // Appends count rocks of the sector square of side extent at origin, see SectorStream
+    static void generateSectorRocks(const Scenario & scenario, Vec2Gen & rng, const Vec2 & origin, float extent, std::size_t count,
+                                    std::vector<Rock> & rocks, MonotonicArena & arena);
+
+    // Points of a shot rock by the number of fragments it broke into, smaller rocks are worth more
+    static std::uint64_t rockPoints(int fragments) { return fragments >= 2 ? 20 : fragments == 1 ? 50 : 100; }
+
+    // Adds a ship at the center with fresh invincibility, returns its index
+    std::size_t addShip();
+
+    // Advance the simulation by one tick of the scenario tick rate, input
+    // offsets are relative to the start of this tick
+    void tick(const InputFrame & input) { tick(&input, 1); }
+
+    // One input per ship in ship order, ships past count get no input
+    void tick(const InputFrame * inputs, std::size_t count);
+
+    bool shipDestroyed(std::size_t i = 0) const { return m_players[i].destroyed; }
+    // a sector streamed world is never cleared, there are always sectors further away
+    bool cleared() const { return m_rocks.empty() && !m_sectors; }
+
+    // every ship destroyed or every rock gone, a world without ships only ends when cleared
+    bool over() const;
+
+    const Scenario & scenario() const { return m_scenario; }
+    float deltaTime() const { return m_delta_time; }
+    std::uint64_t tickCount() const { return m_tick_count; }
+
+    // points of every rock shot so far, smaller rocks are worth more
+    std::uint64_t score() const { return m_score; }
+
+    std::size_t shipCount() const { return m_players.size(); }
+    const Ship & ship(std::size_t i = 0) const { return m_players[i].ship; }
+    float invincibilityLeft(std::size_t i = 0) const { return m_players[i].invincibility_left; }
+
+    const std::vector<Rock> & rocks() const { return m_rocks; }
+    const std::vector<Projectile> & projectiles() const { return m_projectiles; }
+
+    // explosions of the latest tick
+    const std::vector<Explosion> & explosions() const { return m_explosions; }
+
+    // Copies the state into snapshot, reusing its storage. Throws
+    // std::runtime_error for sector streamed worlds, the sectors are not part of it.
+    void snapshot(Snapshot & snapshot) const;
+
+    // Continues from a snapshot taken of this world. Ids are never handed out
+    // twice, so bodies made after a restore get other ids than the first time.
+    void restore(const Snapshot & snapshot);
+
+    // Writes the bodies, the players, the RNG state and the scenario, see
+    // WorldSave.hpp. Throws std::runtime_error for sector streamed worlds.
+    void save(const std::string & file_name) const;
+
+    // Restores a saved world, its next tick is bit-identical to the next tick
+    // of the saved one. Throws std::runtime_error if the file is no save of
+    // this format version.
+    static std::unique_ptr<World> load(const std::string & file_name);
+
+    // Ghost proxies of bodies crossing the seam of the wrapping square. The
+    // rocks are counted once a tick whether anything is tested against them or
+    // not, the projectiles and ships by the collision tests they take part in.
+    struct GhostStatistics
+    {
+        std::uint64_t seam_rocks{ 0 };      // latest tick
+        std::uint64_t rock_proxies{ 0 };    // latest tick
+        std::uint64_t seam_bodies{ 0 };     // projectiles and ships, latest tick
+        std::uint64_t body_proxies{ 0 };    // latest tick
+        std::uint64_t total_proxies{ 0 };
+    };
+
+    const GhostStatistics & ghostStatistics() const { return m_ghost_statistics; }
+
+    // rocks made per sector near the ships, null unless scenario.sector_size is set
+    const SectorStream * sectors() const { return m_sectors.get(); }
+
+    const NarrowPhase & narrowPhase() const { return m_narrow_phase; }
+    MonotonicArena::Statistics arenaStatistics() const { return m_arena.statistics(); }
+
+private:
+    // empty world for load() to fill
+    struct Restore {};
+    World(const Scenario & scenario, Restore);
+
+    Scenario m_scenario;
+    float m_delta_time;
+
+    Vec2Gen m_rng;
+
+    std::vector<Player> m_players;
+    std::vector<Rock> m_rocks;
+    std::vector<Projectile> m_projectiles;
+    std::vector<Explosion> m_explosions;
+
+    std::unique_ptr<SectorStream> m_sectors;
+    std::vector<Vec2> m_ship_positions;     // of the live ships, for the sectors
+
+    NarrowPhase m_narrow_phase;
+    GhostStatistics m_ghost_statistics;
+
+    // transient allocations of a single tick, reset at the end of every tick
+    MonotonicArena m_arena;
+
+    std::uint64_t m_tick_count{ 0 };
+    std::uint64_t m_score{ 0 };
+
+};
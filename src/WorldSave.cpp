@@ -0,0 +1,281 @@
+#include "World.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "WorldSave.hpp"
+#include "BodyId.hpp"
+
+namespace
+{
+    constexpr std::uint64_t SECTION_ALIGNMENT = 8;
+
+    //==========================================================================
+    std::uint64_t align(std::uint64_t offset)
+    {
+        return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+    }
+
+    //==========================================================================
+    // Read only mapping of a whole file
+    class MappedFile
+    {
+    public:
+        //======================================================================
+        explicit MappedFile(const std::string & file_name)
+        {
+            const int fd = ::open(file_name.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw std::runtime_error("Failed to open save file " + file_name + ": " + std::strerror(errno));
+
+            struct stat status{};
+            if (::fstat(fd, &status) != 0)
+            {
+                const int error = errno;
+                ::close(fd);
+                throw std::runtime_error("Failed to read save file " + file_name + ": " + std::strerror(error));
+            }
+
+            m_size = static_cast<std::size_t>(status.st_size);
+
+            // every page is read by the load, faulting them in at once is cheaper
+            if (m_size != 0)
+            {
+                m_data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+                if (m_data == MAP_FAILED)
+                {
+                    const int error = errno;
+                    ::close(fd);
+                    throw std::runtime_error("Failed to map save file " + file_name + ": " + std::strerror(error));
+                }
+            }
+
+            // the mapping stays valid without the descriptor
+            ::close(fd);
+        }
+
+        //======================================================================
+        ~MappedFile()
+        {
+            if (m_data != nullptr)
+                ::munmap(m_data, m_size);
+        }
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile & operator = (const MappedFile &) = delete;
+
+        //======================================================================
+        const unsigned char * data() const { return static_cast<const unsigned char *>(m_data); }
+        std::size_t size() const { return m_size; }
+
+    private:
+        void * m_data{ nullptr };
+        std::size_t m_size{ 0 };
+
+    };
+
+    //==========================================================================
+    // Records of a section, checked to lie inside the file
+    template <typename T>
+    const T * section(const MappedFile & file, std::uint64_t offset, std::uint64_t count, const std::string & file_name)
+    {
+        if (offset % alignof(T) != 0 || offset > file.size() || count > (file.size() - offset) / sizeof(T))
+            throw std::runtime_error("Corrupt save file: " + file_name);
+
+        return reinterpret_cast<const T *>(file.data() + offset);
+    }
+
+    //==========================================================================
+    // Shapes of all rocks of a save in one allocation, their outlines and
+    // hulls refer to one copy of the vertex and hull index sections. Every
+    // rock points at its shape through the block, the last one frees it.
+    struct LoadedShapes
+    {
+        explicit LoadedShapes(std::size_t count) : shapes{ new RockShape[count] } {}
+
+        std::vector<PolarVertex> vertices;
+        std::vector<std::uint16_t> hull_indices;
+        std::unique_ptr<RockShape[]> shapes;
+    };
+}
+
+//==============================================================================
+void World::save(const std::string & file_name) const
+{
+    if (m_sectors)
+        throw std::runtime_error("Saves don't support sector streamed worlds.");
+
+    std::vector<SavedShip> ships;
+    ships.reserve(m_players.size());
+
+    for (const auto & player : m_players)
+    {
+        auto saved = player.ship.save();
+        saved.invincibility_left = player.invincibility_left;
+        saved.destroyed = player.destroyed ? 1 : 0;
+        ships.push_back(saved);
+    }
+
+    std::vector<SavedRock> rocks;
+    std::vector<PolarVertex> vertices;
+    std::vector<std::uint16_t> hull_indices;
+    rocks.reserve(m_rocks.size());
+
+    for (const auto & rock : m_rocks)
+    {
+        if (rock.size() > 0xFFFF)
+            throw std::runtime_error("Rocks with more than 65535 vertices can not be saved.");
+
+        rocks.push_back(rock.save(vertices, hull_indices));
+    }
+
+    std::vector<SavedProjectile> projectiles;
+    projectiles.reserve(m_projectiles.size());
+
+    for (const auto & projectile : m_projectiles)
+        projectiles.push_back(projectile.save());
+
+    const auto scenario = m_scenario.text();
+
+    SaveHeader header{};
+    header.magic            = SAVE_MAGIC;
+    header.version          = SAVE_FORMAT_VERSION;
+    header.tick_count       = m_tick_count;
+    header.score            = m_score;
+    header.rng_counter      = m_rng.state().counter;
+    header.rng_seed         = m_rng.state().seed;
+    header.rng_stream       = m_rng.state().stream;
+    header.next_body_id     = body_id_counter().load();
+    header.ship_count       = static_cast<std::uint32_t>(ships.size());
+    header.rock_count       = static_cast<std::uint32_t>(rocks.size());
+    header.projectile_count = static_cast<std::uint32_t>(projectiles.size());
+    header.vertex_count     = static_cast<std::uint32_t>(vertices.size());
+    header.hull_index_count = static_cast<std::uint32_t>(hull_indices.size());
+    header.scenario_size    = static_cast<std::uint32_t>(scenario.size());
+
+    header.ship_offset       = align(sizeof(SaveHeader));
+    header.rock_offset       = align(header.ship_offset + ships.size() * sizeof(SavedShip));
+    header.projectile_offset = align(header.rock_offset + rocks.size() * sizeof(SavedRock));
+    header.vertex_offset     = align(header.projectile_offset + projectiles.size() * sizeof(SavedProjectile));
+    header.hull_index_offset = align(header.vertex_offset + vertices.size() * sizeof(PolarVertex));
+    header.scenario_offset   = align(header.hull_index_offset + hull_indices.size() * sizeof(std::uint16_t));
+    header.file_size         = header.scenario_offset + scenario.size();
+
+    std::ofstream file{ file_name, std::ios::binary | std::ios::trunc };
+    if (file.is_open() == false)
+        throw std::runtime_error("Failed to create save file: " + file_name);
+
+    std::uint64_t written = 0;
+    const auto write = [&file, &written] (std::uint64_t offset, const void * data, std::size_t size)
+    {
+        static const char s_padding[SECTION_ALIGNMENT]{};
+        file.write(s_padding, static_cast<std::streamsize>(offset - written));
+        file.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+        written = offset + size;
+    };
+
+    write(0,                        &header,             sizeof(header));
+    write(header.ship_offset,       ships.data(),        ships.size() * sizeof(SavedShip));
+    write(header.rock_offset,       rocks.data(),        rocks.size() * sizeof(SavedRock));
+    write(header.projectile_offset, projectiles.data(),  projectiles.size() * sizeof(SavedProjectile));
+    write(header.vertex_offset,     vertices.data(),     vertices.size() * sizeof(PolarVertex));
+    write(header.hull_index_offset, hull_indices.data(), hull_indices.size() * sizeof(std::uint16_t));
+    write(header.scenario_offset,   scenario.data(),     scenario.size());
+
+    if (file.flush().good() == false)
+        throw std::runtime_error("Failed to write save file: " + file_name);
+}
+
+//==============================================================================
+std::unique_ptr<World> World::load(const std::string & file_name)
+{
+    const MappedFile file{ file_name };
+
+    if (file.size() < sizeof(SaveHeader))
+        throw std::runtime_error("Not a save file: " + file_name);
+
+    const auto & header = *reinterpret_cast<const SaveHeader *>(file.data());
+
+    if (header.magic != SAVE_MAGIC)
+        throw std::runtime_error("Not a save file (or saved with the other byte order): " + file_name);
+    if (header.version != SAVE_FORMAT_VERSION)
+        throw std::runtime_error("Save file " + file_name + " has format version " + std::to_string(header.version) +
+                                 ", expected " + std::to_string(SAVE_FORMAT_VERSION));
+    if (header.file_size != file.size())
+        throw std::runtime_error("Truncated save file: " + file_name);
+
+    const auto ships        = section<SavedShip>(file, header.ship_offset, header.ship_count, file_name);
+    const auto rocks        = section<SavedRock>(file, header.rock_offset, header.rock_count, file_name);
+    const auto projectiles  = section<SavedProjectile>(file, header.projectile_offset, header.projectile_count, file_name);
+    const auto vertices     = section<PolarVertex>(file, header.vertex_offset, header.vertex_count, file_name);
+    const auto hull_indices = section<std::uint16_t>(file, header.hull_index_offset, header.hull_index_count, file_name);
+    const auto scenario     = section<char>(file, header.scenario_offset, header.scenario_size, file_name);
+
+    // rock ranges are trusted once they lie inside their sections
+    for (std::uint32_t i = 0; i < header.rock_count; ++i)
+    {
+        const auto & r = rocks[i];
+        if (r.vertex_count < 3 || r.vertex_offset > header.vertex_count || r.vertex_count > header.vertex_count - r.vertex_offset ||
+            r.hull_offset > header.hull_index_count || r.hull_count > header.hull_index_count - r.hull_offset)
+            throw std::runtime_error("Corrupt save file: " + file_name);
+
+        for (std::uint32_t h = 0; h < r.hull_count; ++h)
+            if (hull_indices[r.hull_offset + h] >= r.vertex_count)
+                throw std::runtime_error("Corrupt save file: " + file_name);
+    }
+
+    Scenario s;
+    std::istringstream scenario_text{ std::string{ scenario, header.scenario_size } };
+    s.read(scenario_text, file_name);
+    s.validate();
+
+    std::unique_ptr<World> world{ new World{ s, Restore{} } };
+
+    Vec2Gen::State rng_state;
+    rng_state.seed = header.rng_seed;
+    rng_state.stream = header.rng_stream;
+    rng_state.counter = header.rng_counter;
+    world->m_rng.restore(rng_state);
+    world->m_tick_count = header.tick_count;
+    world->m_score = header.score;
+
+    world->m_players.reserve(header.ship_count);
+    for (std::uint32_t i = 0; i < header.ship_count; ++i)
+        world->m_players.push_back({ Ship{ ships[i] }, ships[i].invincibility_left, ships[i].destroyed != 0 });
+
+    // the sections are copied in bulk, each rock only gets a view of its
+    // ranges. The mapping is not kept instead, saving over the loaded file
+    // would change the shapes under the rocks.
+    const auto shapes = std::make_shared<LoadedShapes>(header.rock_count);
+    shapes->vertices.assign(vertices, vertices + header.vertex_count);
+    shapes->hull_indices.assign(hull_indices, hull_indices + header.hull_index_count);
+
+    world->m_rocks.reserve(header.rock_count);
+    for (std::uint32_t i = 0; i < header.rock_count; ++i)
+    {
+        const auto & r = rocks[i];
+        auto & shape = shapes->shapes[i];
+
+        shape.polygon.view(shapes->vertices.data() + r.vertex_offset, r.vertex_count);
+        shape.hull = RockShape::HullIndices{ shapes->hull_indices.data() + r.hull_offset, r.hull_count };
+
+        world->m_rocks.emplace_back(r, std::shared_ptr<const RockShape>{ shapes, &shape });
+    }
+
+    world->m_projectiles.reserve(header.projectile_count);
+    for (std::uint32_t i = 0; i < header.projectile_count; ++i)
+        world->m_projectiles.emplace_back(projectiles[i]);
+
+    // bodies created from now on get the ids they would have had without the save
+    reserve_body_ids(header.next_body_id);
+
+    return world;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "Vec2.hpp"
+#include "PolarVertex.hpp"
+
+// Binary save file of a World, see World::save and World::load.
+//
+// The file is a header followed by sections of fixed size records in host
+// byte order, each section 8 byte aligned. It is mapped into memory and the
+// records are read in place, there is no parsing step apart from the
+// scenario, which is stored as "key = value" text.
+//
+//     SaveHeader
+//     SavedShip[ship_count]
+//     SavedRock[rock_count]
+//     SavedProjectile[projectile_count]
+//     PolarVertex[vertex_count]     rock outlines, quantized polar
+//     uint16[hull_index_count]      rock convex hulls, indices into the outline
+//     char[scenario_size]           scenario text
+//
+// Everything a tick depends on is stored exactly (no recomputation that could
+// round differently), so the tick after a restore is bit-identical to the
+// tick without one. Bump SAVE_FORMAT_VERSION with every layout change.
+
+constexpr std::uint32_t SAVE_MAGIC = 0x53545341; // "ASTS", reads differently on the other byte order
+constexpr std::uint32_t SAVE_FORMAT_VERSION = 4;
+
+//==============================================================================
+struct SaveHeader
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+
+    std::uint64_t tick_count;
+    std::uint64_t score;
+    std::uint64_t rng_counter;
+    std::uint32_t rng_seed;
+    std::uint32_t rng_stream;
+    std::uint32_t next_body_id;
+    std::uint32_t padding;          // keeps the offsets below 8 byte aligned
+
+    std::uint32_t ship_count;
+    std::uint32_t rock_count;
+    std::uint32_t projectile_count;
+    std::uint32_t vertex_count;
+    std::uint32_t hull_index_count;
+    std::uint32_t scenario_size;
+
+    // byte offsets from the start of the file
+    std::uint64_t ship_offset;
+    std::uint64_t rock_offset;
+    std::uint64_t projectile_offset;
+    std::uint64_t vertex_offset;
+    std::uint64_t hull_index_offset;
+    std::uint64_t scenario_offset;
+
+    std::uint64_t file_size;
+};
+
+//==============================================================================
+// Ship with the state the World keeps per player
+struct SavedShip
+{
+    std::uint32_t id;
+    float size;
+    Vec2 position;
+    Vec2 direction;
+
+    float cool_down;
+    float weapon_cool_down;
+    float movement_speed;
+    float rotation_speed;
+
+    float projectile_speed;
+    Vec2 projectile_size;
+    float projectile_life_time;
+
+    Vec2 box_min;
+    Vec2 box_max;
+    float rotation_matrix[4];
+
+    float invincibility_left;
+    std::uint32_t destroyed;
+};
+
+//==============================================================================
+// Outline and hull are ranges of the vertex and hull index sections
+struct SavedRock
+{
+    std::uint32_t id;
+    float size;
+    Vec2 position;
+    Vec2 velocity;
+
+    Vec2 box_min;
+    Vec2 box_max;
+
+    std::uint32_t vertex_offset;
+    std::uint32_t hull_offset;
+    std::uint16_t vertex_count;
+    std::uint16_t hull_count;
+};
+
+//==============================================================================
+struct SavedProjectile
+{
+    std::uint32_t id;
+    Vec2 size;
+    Vec2 position;
+    Vec2 velocity;
+    float time_left;
+
+    Vec2 box_min;
+    Vec2 box_max;
+    float rotation_matrix[4];
+};
+
+static_assert(std::is_trivially_copyable<SaveHeader>::value, "save records are read in place");
+static_assert(std::is_trivially_copyable<SavedShip>::value, "save records are read in place");
+static_assert(std::is_trivially_copyable<SavedRock>::value, "save records are read in place");
+static_assert(std::is_trivially_copyable<SavedProjectile>::value, "save records are read in place");
@@ -0,0 +1,139 @@
+#ifndef ASTEROIDS_H
+#define ASTEROIDS_H
+
+/*
+ * C interface of libasteroids, for driving simulations from other languages
+ * and tools without going through the executable.
+ *
+ * A simulation is a batch of independent single ship games of one scenario
+ * stepped in lockstep, a single world is a batch of one. The caller binds
+ * its own buffers once and every step writes the observations of all worlds
+ * straight into them, there are no allocations per step. Worlds whose game
+ * is over restart with their next seed within the step and flag done.
+ *
+ * Functions that can fail return ASTEROIDS_OK or ASTEROIDS_ERROR (or NULL),
+ * asteroids_last_error() describes the latest failure of the calling thread.
+ * A simulation must not be used by two threads at once, it steps its worlds
+ * on its own worker threads.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  if defined(ASTEROIDS_BUILD_LIBRARY)
+#    define ASTEROIDS_API __declspec(dllexport)
+#  else
+#    define ASTEROIDS_API __declspec(dllimport)
+#  endif
+#else
+#  define ASTEROIDS_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* bumped on any incompatible change of the functions or structs below */
+#define ASTEROIDS_ABI_VERSION 1
+
+#define ASTEROIDS_OK     0
+#define ASTEROIDS_ERROR -1
+
+/* action bits, one byte per world */
+#define ASTEROIDS_LEFT     0x01u
+#define ASTEROIDS_RIGHT    0x02u
+#define ASTEROIDS_FORWARD  0x04u
+#define ASTEROIDS_BACKWARD 0x08u
+#define ASTEROIDS_FIRE     0x10u
+
+/* floats per body in the observation buffers */
+#define ASTEROIDS_ROCK_FLOATS       5   /* x, y, vx, vy, size */
+#define ASTEROIDS_PROJECTILE_FLOATS 4   /* x, y, vx, vy */
+#define ASTEROIDS_SHIP_FLOATS       6   /* x, y, direction x, direction y, invincibility left, destroyed */
+
+typedef struct asteroids_scenario asteroids_scenario;
+typedef struct asteroids_sim asteroids_sim;
+
+/*
+ * Caller owned observation buffers, any of them may be NULL. World w starts
+ * at w * rock capacity * ASTEROIDS_ROCK_FLOATS in rocks, at
+ * w * projectile capacity * ASTEROIDS_PROJECTILE_FLOATS in projectiles, at
+ * w * ASTEROIDS_SHIP_FLOATS in ships and at w in the rest. Only the first
+ * rock_counts[w] and projectile_counts[w] bodies of a world are written.
+ */
+typedef struct asteroids_observation
+{
+    float * rocks;
+    uint32_t * rock_counts;
+    float * projectiles;
+    uint32_t * projectile_counts;
+    float * ships;
+    uint64_t * scores;          /* points of the current game */
+    uint8_t * done;             /* 1 if a game of the world ended during the step */
+} asteroids_observation;
+
+/* finished games of all worlds */
+typedef struct asteroids_statistics
+{
+    uint64_t games;
+    uint64_t cleared;
+    uint64_t score;
+    uint64_t ticks;
+} asteroids_statistics;
+
+ASTEROIDS_API uint32_t asteroids_abi_version(void);
+
+/* message of the latest failed call on this thread, empty if none */
+ASTEROIDS_API const char * asteroids_last_error(void);
+
+/* built-in preset by name, the default scenario if name is NULL */
+ASTEROIDS_API asteroids_scenario * asteroids_scenario_create(const char * name);
+ASTEROIDS_API void asteroids_scenario_destroy(asteroids_scenario * scenario);
+
+/* reads a scenario file over the current values */
+ASTEROIDS_API int asteroids_scenario_load(asteroids_scenario * scenario, const char * path);
+
+/* one scenario key, as in scenario files */
+ASTEROIDS_API int asteroids_scenario_set(asteroids_scenario * scenario, const char * key, const char * value);
+
+/* world_count games of a copy of scenario, thread_count 0 for one thread per hardware thread */
+ASTEROIDS_API asteroids_sim * asteroids_create(const asteroids_scenario * scenario, uint32_t world_count, uint32_t thread_count);
+ASTEROIDS_API void asteroids_destroy(asteroids_sim * sim);
+
+ASTEROIDS_API uint32_t asteroids_world_count(const asteroids_sim * sim);
+
+/* bodies per world, the sizes of the per world blocks of the observation buffers */
+ASTEROIDS_API uint32_t asteroids_rock_capacity(const asteroids_sim * sim);
+ASTEROIDS_API uint32_t asteroids_projectile_capacity(const asteroids_sim * sim);
+
+/* seconds per step */
+ASTEROIDS_API float asteroids_delta_time(const asteroids_sim * sim);
+
+/* seed of the current game of world */
+ASTEROIDS_API uint32_t asteroids_seed(const asteroids_sim * sim, uint32_t world);
+
+/*
+ * Binds observation buffers, NULL unbinds. The buffers must stay valid until
+ * unbound or the simulation is destroyed. Writes the current state at once.
+ */
+ASTEROIDS_API int asteroids_bind_observation(asteroids_sim * sim, const asteroids_observation * observation);
+
+/*
+ * Steps every world ticks times with the same actions, one ASTEROIDS_* bit
+ * mask per world or NULL for none, and writes the observations after the
+ * last tick. done is cleared first and set for worlds whose game ended in
+ * any of the ticks.
+ */
+ASTEROIDS_API int asteroids_step(asteroids_sim * sim, const uint8_t * actions, uint32_t ticks);
+
+/* starts the next game of world and writes its observation, done is left as it is */
+ASTEROIDS_API int asteroids_reset(asteroids_sim * sim, uint32_t world);
+
+ASTEROIDS_API void asteroids_statistics_get(const asteroids_sim * sim, asteroids_statistics * statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -3,14 +3,64 @@
 #include <chrono>
 #include <thread>
 #include <cassert>
+#include <memory>
+#include <string>
+#include <stdexcept>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
 
 #include "Shader.hpp"
 #include "Rock.hpp"
 #include "Ship.hpp"
+#include "FrameCapture.hpp"
+#include "Scenario.hpp"
+#include "World.hpp"
+#include "Rewind.hpp"
+#include "Particles.hpp"
+#include "Hud.hpp"
+#include "Headless.hpp"
+#include "Keyboard.hpp"
+#include "Input.hpp"
+#include "Autopilot.hpp"
+#include "GpuProfiler.hpp"
+#include "LatencyTracker.hpp"
+#include "Trace.hpp"
+#include "NetClient.hpp"
+#include "NetHeadless.hpp"
+#include "Camera.hpp"
+#include "SpatialGrid.hpp"
+#include "SectorStream.hpp"
+#include "RenderQueue.hpp"
+#include "RunState.hpp"
 
 constexpr bool DRAW_AABB = false;
 
-constexpr float SHIP_SIZE = 0.04f;
+// live explosion particles, emitting into a full pool drops the new ones
+constexpr std::size_t PARTICLE_CAPACITY = 1 << 18;
+
+// seconds over which the HUD averages frame rate and phase times, it changes no more often
+constexpr float HUD_INTERVAL = 0.5f;
+
+enum HudLine : std::size_t { HUD_SCORE, HUD_ROCKS, HUD_FPS, HUD_PHASES, HUD_STATE, HUD_LINE_COUNT };
+
+// render queue layers in drawing order, the GPU profiler section of each
+constexpr std::uint8_t DRAW_LAYER_SHIP        = static_cast<std::uint8_t>(GpuSection::SHIP);
+constexpr std::uint8_t DRAW_LAYER_PROJECTILES = static_cast<std::uint8_t>(GpuSection::PROJECTILES);
+constexpr std::uint8_t DRAW_LAYER_ROCKS       = static_cast<std::uint8_t>(GpuSection::ROCKS);
+constexpr std::uint8_t DRAW_LAYER_AABB        = static_cast<std::uint8_t>(GpuSection::AABB);
+
+constexpr Color SHIP_COLOR{ 1.0f, 0.0f, 0.7f };
+constexpr Color INVINCIBLE_SHIP_COLOR{ 0.0f, 1.0f, 0.5f };
+constexpr Color PROJECTILE_COLOR{ 0.6f, 0.5f, 1.0f };
+constexpr Color ROCK_COLOR{ 1.0f, 1.0f, 1.0f };
+constexpr Color AABB_COLOR{ 1.0f, 0.0f, 0.0f };
+
+// frames per anti-aliasing mode of --bench-aa, after the warm up ones
+constexpr int AA_BENCHMARK_FRAMES = 300;
+constexpr int AA_BENCHMARK_WARM_UP = 20;
 
 static const std::vector<Shader::Source> SHADER_SOURCE
 {
@@ -18,15 +68,21 @@ static const std::vector<Shader::Source> SHADER_SOURCE
     { "shader/line.frag", GL_FRAGMENT_SHADER }
 };
 
-static const std::vector<Vec2> AABB_MODEL
+// line AA, the geometry shader only takes lines so points keep SHADER_SOURCE
+static const std::vector<Shader::Source> LINE_AA_SHADER_SOURCE
 {
+    { "shader/line.vert", GL_VERTEX_SHADER },
+    { "shader/line_aa.geom", GL_GEOMETRY_SHADER },
+    { "shader/line_aa.frag", GL_FRAGMENT_SHADER }
+};
+
+static constexpr std::array<Vec2, 4> AABB_MODEL
+{{
     { -1.0f, -1.0f },
     {  1.0f, -1.0f },
     {  1.0f,  1.0f },
     { -1.0f,  1.0f }
-};
-
-static constexpr std::chrono::microseconds delta_time_ms{ 15'000ul };
+}};
 
 static constexpr float identity_matrix[4]
 {
@@ -34,14 +90,350 @@ static constexpr float identity_matrix[4]
     0.0f, 1.0f
 };
 
-int main()
+//==============================================================================
+// Rotation matrix of a direction in the layout Ship and Projectile use
+static void direction_matrix(const Vec2 & direction, float m[4])
+{
+    const auto angle = -std::atan2(direction.y, direction.x);
+
+    m[0] =  std::cos(angle);
+    m[1] = -std::sin(angle);
+    m[2] =  std::sin(angle);
+    m[3] =  std::cos(angle);
+}
+
+//==============================================================================
+// Camera transform of a program in use, world space is clip space without one
+static void set_identity_view(const Shader & shader)
+{
+    glUniform2f(glGetUniformLocation(shader.id(), "view_translation"), 0.0f, 0.0f);
+    glUniform1f(glGetUniformLocation(shader.id(), "view_scale"), 1.0f);
+}
+
+//==============================================================================
+// Program of the line draws for an anti-aliasing mode, the blending line AA
+// needs, in use with an identity view. Rocks take shader/rock.vert, which
+// decodes their polar vertices.
+static std::unique_ptr<Shader> make_line_shader(const AntiAliasing & aa, const std::string & vertex_shader = "shader/line.vert")
+{
+    const bool line_aa = aa.mode == AntiAliasing::Mode::LINE;
+
+    if (line_aa)
+    {
+        if (gl3wIsSupported(3, 2) != 1)
+            throw std::runtime_error("Line anti-aliasing needs OpenGL 3.2 geometry shaders.");
+
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+
+    auto source = line_aa ? LINE_AA_SHADER_SOURCE : SHADER_SOURCE;
+    source[0].file_name = vertex_shader;
+
+    auto shader = std::make_unique<Shader>(source);
+    shader->use();
+    set_identity_view(*shader);
+
+    return shader;
+}
+
+//==============================================================================
+// Program of the particle points in line AA mode, the particle uniforms never change
+static std::unique_ptr<Shader> make_point_shader(const AntiAliasing & aa)
+{
+    if (aa.mode != AntiAliasing::Mode::LINE)
+        return nullptr;
+
+    auto shader = std::make_unique<Shader>(SHADER_SOURCE);
+    shader->use();
+
+    glUniform3f(glGetUniformLocation(shader->id(), "color"), 1.0f, 0.8f, 0.4f);
+    glUniform2f(glGetUniformLocation(shader->id(), "scale"), 1.0f, 1.0f);
+    glUniform2f(glGetUniformLocation(shader->id(), "translation"), 0.0f, 0.0f);
+    glUniformMatrix2fv(glGetUniformLocation(shader->id(), "rotation"), 1, GL_FALSE, identity_matrix);
+    set_identity_view(*shader);
+
+    return shader;
+}
+
+//==============================================================================
+// Frame time of every anti-aliasing mode drawing the same world with a
+// window of its own, GPU time included by finishing every frame
+static int run_aa_benchmark(const Options & options)
 {
-    // window
-    Window window;
+    auto scenario = options.scenario_given ? options.scenario : Scenario::preset("stress-10k");
+    scenario.seed = World::resolveSeed(scenario.seed);
+
+    std::cout << "scenario " << scenario.name << ", " << scenario.rock_count << " rocks, "
+              << AA_BENCHMARK_FRAMES << " frames per mode" << std::endl;
+
+    std::cout << std::left
+              << std::setw(12) << "aa"
+              << std::right
+              << std::setw(10) << "samples"
+              << std::setw(12) << "mean ms"
+              << std::setw(12) << "p99 ms" << std::endl;
+
+    for (const auto & name : { "none", "line", "msaa2", "msaa4", "msaa8", "msaa16" })
+    {
+        const auto aa = AntiAliasing::parse(name);
+
+        Window window{ aa.framebufferSamples() };
+        window.makeContextCurrent();
+
+        const auto rock_shader = make_line_shader(aa, "shader/rock.vert");
+        const auto shader = make_line_shader(aa);
+
+        GlStateCache cache;
+        const auto program = cache.addProgram(*shader);
+        const auto rock_program = cache.addProgram(*rock_shader);
+        RenderQueue queue;
+
+        World world{ scenario };
+        const InputFrame input;
+
+        Polygon ship_polygon{ DEFAULT_SHIP_MODEL };
+        Polygon projectile_polygon{ DEFAULT_PROJECTILE_MODEL };
+
+        std::vector<double> times;
+        times.reserve(AA_BENCHMARK_FRAMES);
+
+        for (int frame = 0; frame < AA_BENCHMARK_WARM_UP + AA_BENCHMARK_FRAMES && !window.exitRequested(); ++frame)
+        {
+            window.pollEvents();
+            world.tick(input);
+
+            const auto start = std::chrono::steady_clock::now();
+
+            cache.invalidate();
+            for (const auto p : { rock_program, program })
+            {
+                cache.useProgram(p);
+                cache.setViewport(static_cast<float>(window.width()), static_cast<float>(window.height()));
+            }
+
+            const Vec2 origin{ 0.0f, 0.0f };
+
+            queue.clear();
+            for (std::size_t i = 0; i < world.shipCount(); ++i)
+                queue.draw(DRAW_LAYER_SHIP, program, ship_polygon, SHIP_COLOR, world.ship(i).transform(), origin);
+            for (const auto & p : world.projectiles())
+                queue.draw(DRAW_LAYER_PROJECTILES, program, projectile_polygon, PROJECTILE_COLOR, p.transform(), origin);
+            for (const auto & r : world.rocks())
+                queue.draw(DRAW_LAYER_ROCKS, rock_program, r.mesh(), ROCK_COLOR, r.transform(), origin);
+
+            queue.submit(cache, [] (std::uint8_t, bool) {});
+
+            glFinish();
+
+            if (frame >= AA_BENCHMARK_WARM_UP)
+                times.push_back(std::chrono::duration<double, std::milli>{ std::chrono::steady_clock::now() - start }.count());
+
+            window.swapResizeClearBuffer();
+        }
+
+        if (times.empty())
+            return 0;
+
+        double total = 0.0;
+        for (const auto t : times) total += t;
+        std::sort(times.begin(), times.end());
+
+        std::cout << std::left
+                  << std::setw(12) << aa.name()
+                  << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(10) << window.samples()
+                  << std::setw(12) << total / static_cast<double>(times.size())
+                  << std::setw(12) << times[static_cast<std::size_t>(0.99 * static_cast<double>(times.size() - 1))] << std::endl;
+    }
+
+    return 0;
+}
+
+//==============================================================================
+// Window of a client in client/server mode, draws the world rebuilt from snapshots
+static int run_client(const Options & options, Window & window, GLint translation_uniform, GLint scale_uniform,
+                      GLint color_uniform, GLint rotation_uniform, GLint viewport_uniform)
+{
+    NetClient client{ NetAddress::parse(options.net.server), options.net.conditions, 1 };
+
+    InputTimeline input_timeline;
+
+    Polygon ship_polygon{ DEFAULT_SHIP_MODEL };
+    Polygon projectile_polygon{ DEFAULT_PROJECTILE_MODEL };
+
+    const auto start = std::chrono::steady_clock::now();
+
+    while (!window.exitRequested())
+    {
+        auto start_time = std::chrono::steady_clock::now();
+        const auto now = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(start_time - start).count());
+
+        window.pollEvents();
+
+        const auto input = input_timeline.consume(Keyboard::events(), start_time);
+
+        client.update(now);
+        client.sendInput(input.bitmask(), now);
+
+        const auto & state = client.state();
+        float matrix[4];
+
+        glUniform2f(viewport_uniform, static_cast<float>(window.width()), static_cast<float>(window.height()));
+
+        // draw ships, own ship in the single player colors
+        for (std::size_t i = 0; i < state.ships.size(); ++i)
+        {
+            const auto & ship = state.ships[i];
+            if (ship.flags & SHIP_DESTROYED)
+                continue;
+
+            if (i != state.own_ship)
+                glUniform3f(color_uniform, 0.4f, 0.4f, 1.0f);
+            else if (ship.flags & SHIP_INVINCIBLE)
+                glUniform3f(color_uniform, 0.0f, 1.0f, 0.5f);
+            else
+                glUniform3f(color_uniform, 1.0f, 0.0f, 0.7f);
+
+            const auto position = ship.position();
+            direction_matrix(ship.direction(), matrix);
+
+            glUniform2f(scale_uniform, options.scenario.ship_size, options.scenario.ship_size);
+            glUniformMatrix2fv(rotation_uniform, 1, GL_FALSE, matrix);
+            glUniform2f(translation_uniform, position.x, position.y);
+
+            ship_polygon.draw();
+        }
+
+        // draw projectiles
+        glUniform3f(color_uniform, 0.6f, 0.5f, 1.0f);
+        for (const auto & p : state.projectiles)
+        {
+            direction_matrix(p.velocity, matrix);
+
+            glUniform2f(scale_uniform, p.size.x, p.size.y);
+            glUniformMatrix2fv(rotation_uniform, 1, GL_FALSE, matrix);
+            glUniform2f(translation_uniform, p.position.x, p.position.y);
+
+            projectile_polygon.draw();
+        }
+
+        // draw rocks
+        glUniform3f(color_uniform, 1.0f, 1.0f, 1.0f);
+        glUniformMatrix2fv(rotation_uniform, 1, 0, identity_matrix);
+        for (const auto & r : state.rocks)
+        {
+            glUniform2f(scale_uniform, r.size, r.size);
+            glUniform2f(translation_uniform, r.position.x, r.position.y);
+
+            r.shape->draw();
+        }
+
+        // the server's tick rate once connected
+        const float tick_rate = client.connected() ? client.tickRate() : options.scenario.tick_rate;
+        start_time += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>{ 1.0f / tick_rate });
+        std::this_thread::sleep_until(start_time);
+
+        window.swapResizeClearBuffer();
+    }
+
+    return 0;
+}
+
+//==============================================================================
+static int run(const Options & options)
+{
+    if (options.trace_path.empty() == false && TRACE_ENABLED == false)
+        throw std::runtime_error("--trace needs a build with ASTEROIDS_TRACE enabled.");
+
+    TRACE_THREAD_NAME("main");
+
+    // spans recorded so far as Chrome trace event JSON
+    const auto export_trace = [&options]
+    {
+        if (options.trace_path.empty() == false)
+            trace_export(options.trace_path);
+    };
+
+    if (options.mode == Options::Mode::HEADLESS)
+    {
+        const int result = run_headless(options);
+        export_trace();
+        return result;
+    }
+
+    if (options.mode == Options::Mode::BENCHMARK)
+    {
+        std::vector<Scenario> scenarios;
+        if (options.scenario_given)
+            scenarios.push_back(options.scenario);
+        else
+            for (const auto & name : Scenario::presetNames())
+                scenarios.push_back(Scenario::preset(name));
+
+        const int result = run_benchmark(scenarios);
+        export_trace();
+        return result;
+    }
+
+    if (options.mode == Options::Mode::PARTICLE_BENCHMARK)
+        return run_particle_benchmark();
+
+    if (options.mode == Options::Mode::BATCH_BENCHMARK)
+    {
+        const int result = run_batch_benchmark(options);
+        export_trace();
+        return result;
+    }
+
+    if (options.mode == Options::Mode::AA_BENCHMARK)
+        return run_aa_benchmark(options);
+
+    if (options.mode == Options::Mode::SERVER)
+        return run_server(options.scenario, options.net);
+
+    if (options.mode == Options::Mode::NET_TEST)
+    {
+        // without a scenario, show how bandwidth grows with the rock count
+        std::vector<Scenario> scenarios;
+        if (options.scenario_given)
+            scenarios.push_back(options.scenario);
+        else
+            for (const std::size_t rock_count : { 100, 1'000, 10'000 })
+            {
+                auto scenario = Scenario::preset("stress-10k");
+                scenario.name = "net-" + std::to_string(rock_count);
+                scenario.rock_count = rock_count;
+                scenario.ticks = 1'000;
+                scenarios.push_back(scenario);
+            }
+
+        return run_net_test(scenarios, options.net);
+    }
+
+    // window, a capture does the multisampling in its own framebuffer and
+    // blits the resolved frame, which needs a single sampled window
+    const auto & capture_path = options.capture_path;
+    Window window{ capture_path.empty() ? options.aa.framebufferSamples() : 0 };
     window.makeContextCurrent();
 
-    // shader
-    Shader shader{ SHADER_SOURCE };
+    // frame capture, "*.png" paths are printf patterns, anything else is a raw RGBA stream
+    std::unique_ptr<FrameCapture> capture;
+    if (capture_path.empty() == false)
+    {
+        const bool png = capture_path.size() > 4 && capture_path.compare(capture_path.size() - 4, 4, ".png") == 0;
+
+        capture = std::make_unique<FrameCapture>(
+            window.width(), window.height(), options.aa.framebufferSamples(), capture_path,
+            png ? FrameCapture::Format::PNG : FrameCapture::Format::RAW
+        );
+    }
+
+    // shaders, with line AA the particles go through a program of their own
+    const auto point_shader = make_point_shader(options.aa);
+    const auto rock_shader = make_line_shader(options.aa, "shader/rock.vert");
+    const auto line_shader = make_line_shader(options.aa);
+    const Shader & shader = *line_shader;
 
     shader.use();
 
@@ -49,144 +441,425 @@ int main()
     const GLint scale_uniform       = glGetUniformLocation(shader.id(), "scale");
     const GLint color_uniform       = glGetUniformLocation(shader.id(), "color");
     const GLint rotation_uniform    = glGetUniformLocation(shader.id(), "rotation");
+    const GLint viewport_uniform    = glGetUniformLocation(shader.id(), "viewport");     // -1 without line AA
+    const GLint view_translation_uniform = glGetUniformLocation(shader.id(), "view_translation");
+
+    if (options.mode == Options::Mode::CLIENT)
+        return run_client(options, window, translation_uniform, scale_uniform, color_uniform, rotation_uniform, viewport_uniform);
 
-    // random number generator
-    const auto seed = std::chrono::duration_cast<std::chrono::nanoseconds>
-        (
-            std::chrono::high_resolution_clock::now().time_since_epoch()
-        ).count();
+    // simulation, a new one or continued from a save
+    const auto world_ptr = options.load_path.empty() ? std::make_unique<World>(options.scenario) : World::load(options.load_path);
+    auto & world = *world_ptr;
 
-    Vec2Gen rng{ static_cast<uint32_t>(seed) };
+    // last rewind_seconds of ticks
+    std::unique_ptr<RewindBuffer> rewind;
+    if (options.rewind_seconds > 0.0f)
+    {
+        rewind = std::make_unique<RewindBuffer>(rewind_capacity(options.rewind_seconds, world.scenario().tick_rate));
+        rewind->record(world);
+    }
 
-    // rocks
-    std::vector<Rock> rocks;
+    const auto & rocks = world.rocks();
+    const auto & projectiles = world.projectiles();
+    const auto & scenario = world.scenario();
 
-    for(std::size_t i = 0; i < 6; ++i)
-        rocks.emplace_back(rng,
-            (rng.get().x + 2.0f) / 14.0f, 10,
-            (rng.get() * 2.0f - 1.0f), (rng.get() * 2.0f - 1.0f) * 0.15f
-        );
+    // view following the first ship, in a world larger than the view only the
+    // rocks the grid finds near it are drawn
+    Camera camera{ scenario.world_size, scenario.view_size };
+    const bool cull = !camera.coversWorld();
 
-    // ship
-    Ship ship{ SHIP_SIZE, 0.5f, 0.8f, 0.6f }; // TODO: figure out why collision with ship is not correct
+    SpatialGrid grid{ scenario.world_size, 0.5f * scenario.view_size };
+    std::vector<SpatialGrid::Candidate> candidates;
 
-    // projectiles
-    std::vector<Projectile> projectiles;
+    // shared models
+    Polygon ship_polygon{ DEFAULT_SHIP_MODEL };
+    Polygon projectile_polygon{ DEFAULT_PROJECTILE_MODEL };
 
     // axis aligned bounding box
     Polygon aabb_polygon{ AABB_MODEL };
 
-    float invincibility_left = 3.0f;
+    // explosion debris
+    ParticleSystem particles{ PARTICLE_CAPACITY, scenario.world_size };
+
+    // line shader draws of the frame, sorted and submitted through the state cache
+    GlStateCache state_cache;
+    const auto line_program = state_cache.addProgram(shader);
+    const auto rock_program = state_cache.addProgram(*rock_shader);
+    RenderQueue render_queue;
 
-    float delta_time = static_cast<float>(static_cast<double>(delta_time_ms.count()) / 1'000'000.0);
+    // score, rocks left, frame rate, CPU time of the loop phases and GL state changes, H toggles it
+    Hud hud{ HUD_LINE_COUNT };
+    bool hud_visible = true;
+    bool hud_key_down = false;
+
+    std::uint64_t hud_score = ~std::uint64_t{ 0 };
+    std::size_t hud_rocks = ~std::size_t{ 0 };
+    std::size_t hud_drawn = ~std::size_t{ 0 };
+    std::size_t hud_sectors = ~std::size_t{ 0 };
+    std::size_t drawn_rocks = 0;
+
+    struct HudTimes
+    {
+        std::uint32_t frames{ 0 };
+        double tick{ 0.0 };
+        double draw{ 0.0 };
+        double wait{ 0.0 };
+    } hud_times;
+    auto hud_interval_start = std::chrono::steady_clock::now();
+
+    const auto milliseconds = [] (std::chrono::steady_clock::duration d)
+    {
+        return std::chrono::duration<double, std::milli>{ d }.count();
+    };
+
+    const auto tick_duration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<float>{ world.deltaTime() }
+    );
+
+    // GPU time per draw group and input to present latency, reported at exit
+    std::unique_ptr<GpuProfiler> profiler;
+    if (options.profile)
+        profiler = std::make_unique<GpuProfiler>();
+
+    LatencyTracker latency;
+    std::vector<InputClock::time_point> event_times;
+    std::uint64_t frame = 0;
+
+    // keyboard, key events since the previous tick with their offsets inside the tick, or the autopilot
+    std::unique_ptr<InputSource> input_source;
+    if (options.autopilot)
+        input_source = std::make_unique<Autopilot>();
+    else
+        input_source = std::make_unique<KeyboardInput>(profiler ? &event_times : nullptr);
+
+    const auto gpu_begin = [&profiler](GpuSection section) { if (profiler) profiler->begin(section); };
+    const auto gpu_end   = [&profiler](GpuSection section) { if (profiler) profiler->end(section); };
+
+    // unfocused or iconified the game stops and the loop blocks in the event
+    // wait, unattended runs (autopilot, capture) keep going
+    const bool pausable = options.pause && !options.autopilot && capture_path.empty();
+    const auto background_interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<float>{ options.background_fps > 0.0f ? 1.0f / options.background_fps : 0.0f }
+    );
+    auto next_background_frame = std::chrono::steady_clock::now();
+
+    RunStateClock run_states;
 
     while(!window.exitRequested())
     {
-        auto start_time = std::chrono::steady_clock::now();
+        const auto frame_start = std::chrono::steady_clock::now();
+        auto start_time = frame_start;
 
-        window.pollEvents();
+        {
+            TRACE_SCOPE("poll");
+            window.pollEvents();
+        }
 
-        // move ship and shoot
-        ship.move(delta_time);
-        const auto shot = ship.shoot(delta_time);
-        if (std::get<0>(shot) == true)
-            projectiles.emplace_back(std::get<1>(shot));
-
-        // move rocks
-        std::for_each(rocks.begin(), rocks.end(), [delta_time] (Rock & r) { r.move(delta_time); });
-        // move projectiles
-        std::for_each(projectiles.begin(), projectiles.end(), [delta_time] (Projectile & p) { p.move(delta_time); });
-
-        // remove projectiles that reached end of life
-        projectiles.erase(std::remove_if(projectiles.begin(), projectiles.end(), [] (const Projectile & p) { return p.isDead(); }), projectiles.end());
-
-        // perform projectile-rock collision detection and resolution
-        std::vector<Rock> new_rocks;
-
-        // used algorithm can miss collisions due to tunneling
-        for (auto & p : projectiles)
-            for (auto i = rocks.begin(); i != rocks.end(); ++i)
-                if (AABB::intersect(p.boundingBox(), i->boundingBox())) // broad-phase
-                    if (polygons_intersect(p.polygonSRT(), i->polygonSRT())) // narrow-phase
-                    {
-                        // split hit rock
-                        const auto new_rock = i->split(rng);
-
-                        if (std::get<0>(new_rock) >= 1) new_rocks.emplace_back(std::get<1>(new_rock));
-                        if (std::get<0>(new_rock) == 2) new_rocks.emplace_back(std::get<2>(new_rock));
-
-                        rocks.erase(i);
-
-                        // mark used projectile dead
-                        p.kill();
-
-                        // projectile can only hit one rock (this also prevents using invalidated iterators)
-                        break;
-                    }
-
-        // insert new rocks
-        rocks.insert(rocks.end(), new_rocks.begin(), new_rocks.end());
-
-        // remove projectiles that have hit rocks
-        projectiles.erase(std::remove_if(projectiles.begin(), projectiles.end(), [] (Projectile & p) { return p.isDead(); }), projectiles.end());
-
-        // perform ship-rock collision detection and resolution
-        invincibility_left -= delta_time;
-        if (invincibility_left < 0.0f)
-            // used algorithm can miss collisions due to tunneling
-            for (auto & p : rocks)
-                if (AABB::intersect(ship.boundingBox(), p.boundingBox())) // broad-phase
-                    if (polygons_intersect(ship.polygonSRT(), p.polygonSRT())) // narrow-phase
-                    {
-                        window.scheduleExit();
-                        break;
-                    }
-
-        // draw ship
-        if (invincibility_left >= 0.0f)
-            glUniform3f(color_uniform, 0.0f, 1.0f, 0.5f);
-        else
-            glUniform3f(color_uniform, 1.0f, 0.0f, 0.7f);
+        auto run_state = RunState::RUNNING;
+        if (pausable && window.iconified())
+            run_state = RunState::PAUSED;
+        else if (pausable && !window.focused())
+            run_state = RunState::BACKGROUND;
 
-        ship.draw(scale_uniform, rotation_uniform, translation_uniform);
+        if (run_states.enter(run_state))
+        {
+            // background frames don't count for the frame rate and phase times
+            hud_times = HudTimes{};
+            hud_interval_start = frame_start;
+            next_background_frame = frame_start;
 
-        // draw projectiles
-        glUniform3f(color_uniform, 0.6f, 0.5f, 1.0f);
-        std::for_each(projectiles.begin(), projectiles.end(), [scale_uniform, rotation_uniform, translation_uniform] (Projectile & p) { p.draw(scale_uniform, rotation_uniform, translation_uniform); });
+            if (run_state != RunState::RUNNING)
+                hud.setLine(HUD_FPS, "paused");
+        }
 
-        // draw rocks
-        glUniform3f(color_uniform, 1.0f, 1.0f, 1.0f);
-        glUniformMatrix2fv(rotation_uniform, 1, 0, identity_matrix);
-        std::for_each(rocks.begin(), rocks.end(), [translation_uniform, scale_uniform] (const Rock & r) { r.draw(translation_uniform, scale_uniform); });
+        // iconified, or unfocused without background frames, nothing happens until an event
+        if (run_state == RunState::PAUSED || (run_state == RunState::BACKGROUND && options.background_fps <= 0.0f))
+        {
+            TRACE_SCOPE("idle");
+            window.waitEvents();
+            continue;
+        }
+
+        // unfocused, the stopped game is drawn at the background frame rate
+        if (run_state == RunState::BACKGROUND)
+        {
+            if (frame_start < next_background_frame)
+            {
+                TRACE_SCOPE("idle");
+                window.waitEvents(std::chrono::duration<double>{ next_background_frame - frame_start }.count());
+                continue;
+            }
+
+            next_background_frame = frame_start + background_interval;
+        }
+
+        const bool simulate = run_state == RunState::RUNNING;
+        event_times.clear();
+
+        if (simulate)
+        {
+            TRACE_SCOPE("tick");
+            const auto input = input_source->next(world, 0);
+
+            // holding R steps back one recorded tick per frame instead of ticking
+            if (rewind && Keyboard::getKeyStatus(GLFW_KEY_R) == Keyboard::KeyStatus::PRESSED)
+                rewind->rewind(world, 1);
+            else
+            {
+                world.tick(input);
+                if (rewind)
+                    rewind->record(world);
+
+                for (const auto & e : world.explosions())
+                {
+                    if (e.ship)
+                        particles.emit(e.position, e.velocity, 400, 0.4f, 1.5f);
+                    else
+                        particles.emit(e.position, e.velocity, 16 + static_cast<std::size_t>(e.size * 400.0f), 0.3f, 0.8f);
+                }
+            }
+
+            particles.update(world.deltaTime());
+        }
+
+        const auto tick_end = std::chrono::steady_clock::now();
+
+        // H toggles the HUD on key down
+        const bool hud_key = Keyboard::getKeyStatus(GLFW_KEY_H) == Keyboard::KeyStatus::PRESSED;
+        if (hud_key && !hud_key_down)
+            hud_visible = !hud_visible;
+        hud_key_down = hud_key;
+
+        // only text that changed is rebuilt
+        if (world.score() != hud_score)
+        {
+            hud_score = world.score();
+            hud.setLine(HUD_SCORE, "score " + std::to_string(hud_score));
+        }
+        const auto sectors = world.sectors() ? world.sectors()->statistics().active : 0;
+        if (rocks.size() != hud_rocks || drawn_rocks != hud_drawn || sectors != hud_sectors)
+        {
+            hud_rocks = rocks.size();
+            hud_drawn = drawn_rocks;
+            hud_sectors = sectors;
+            hud.setLine(HUD_ROCKS, "rocks " + std::to_string(hud_rocks) +
+                                   (cull ? ", drawn " + std::to_string(hud_drawn) : "") +
+                                   (world.sectors() ? ", sectors " + std::to_string(hud_sectors) : ""));
+        }
+
+        if (profiler)
+        {
+            latency.submit(frame, event_times);
+            profiler->beginFrame(frame);
+        }
+
+        if (capture)
+            capture->beginFrame();
 
-        // draw bounding boxes
-        if (DRAW_AABB)
         {
-            auto draw_aabb = [translation_uniform, scale_uniform, &aabb_polygon](const auto & element)
+            TRACE_SCOPE("draw");
+
+            // particles and HUD went around the cache last frame
+            state_cache.invalidate();
+
+            // bodies are drawn at the copy nearest the camera, the view translation moves them there
+            if (world.shipCount() > 0)
+                camera.follow(world.ship(0).position());
+
+            for (const auto program : { rock_program, line_program })
+            {
+                state_cache.useProgram(program);
+                state_cache.setViewport(static_cast<float>(window.width()), static_cast<float>(window.height()));
+                state_cache.setViewScale(camera.scale());
+            }
+
+            const AABB view = camera.view();
+            const auto view_translation = [&camera] (const Vec2 & offset)
             {
-                Vec2 position, size;
+                return Vec2{ offset.x - camera.center().x, offset.y - camera.center().y };
+            };
+
+            // record ships, projectiles and rocks, the queue sorts them by mesh and color
+            render_queue.clear();
+
+            for (std::size_t i = 0; i < world.shipCount(); ++i)
+            {
+                const auto & color = world.invincibilityLeft(i) >= 0.0f ? INVINCIBLE_SHIP_COLOR : SHIP_COLOR;
+                render_queue.draw(DRAW_LAYER_SHIP, line_program, ship_polygon, color, world.ship(i).transform(),
+                                  view_translation(camera.offset(world.ship(i).position())));
+            }
+
+            for (const auto & p : projectiles)
+            {
+                render_queue.draw(DRAW_LAYER_PROJECTILES, line_program, projectile_polygon, PROJECTILE_COLOR, p.transform(),
+                                  view_translation(camera.offset(p.position())));
+            }
+
+            if (cull)
+            {
+                grid.build(rocks);
+                candidates.clear();
+                grid.query(view, 2.0f * scenario.rock_size_max, candidates);
+
+                drawn_rocks = 0;
+
+                for (const auto & c : candidates)
+                {
+                    const auto & r = rocks[c.index];
+                    if (!AABB::intersect(r.boundingBox() + c.offset, view))
+                        continue;
+
+                    render_queue.draw(DRAW_LAYER_ROCKS, rock_program, r.mesh(), ROCK_COLOR, r.transform(), view_translation(c.offset));
+                    drawn_rocks++;
+                }
+            }
+            else
+            {
+                const auto rock_view_translation = view_translation(Vec2{ 0.0f, 0.0f });
+                for (const auto & r : rocks)
+                    render_queue.draw(DRAW_LAYER_ROCKS, rock_program, r.mesh(), ROCK_COLOR, r.transform(), rock_view_translation);
+
+                drawn_rocks = rocks.size();
+            }
 
-                position_size_from_AABB(element.boundingBox(), position, size);
+            // bounding boxes
+            if (DRAW_AABB)
+            {
+                const auto aabb_view_translation = view_translation(Vec2{ 0.0f, 0.0f });
+                const auto draw_aabb = [&] (const AABB & box)
+                {
+                    Vec2 position, size;
+                    position_size_from_AABB(box, position, size);
+
+                    const DrawTransform transform{ size, { 1.0f, 0.0f, 0.0f, 1.0f }, position };
+                    render_queue.draw(DRAW_LAYER_AABB, line_program, aabb_polygon, AABB_COLOR, transform, aabb_view_translation);
+                };
+
+                for (const auto & p : projectiles)
+                    draw_aabb(p.boundingBox());
+                for (const auto & r : rocks)
+                    draw_aabb(r.boundingBox());
+                for (std::size_t i = 0; i < world.shipCount(); ++i)
+                    draw_aabb(world.ship(i).boundingBox());
+            }
+
+            render_queue.submit(state_cache, [&] (std::uint8_t layer, bool begin)
+            {
+                if (begin)
+                    gpu_begin(static_cast<GpuSection>(layer));
+                else
+                    gpu_end(static_cast<GpuSection>(layer));
+            });
 
-                glUniform2f(scale_uniform, size.x, size.y);
-                glUniform2f(translation_uniform, position.x, position.y);
+            // draw particles, positions are already in world space, again for the copies across a seam in view
+            Vec2 seam_offsets[3];
+            const auto seam_count = cull ? ghost_offsets(seam_crossing(view, scenario.world_size), seam_offsets) : 0;
 
-                aabb_polygon.draw();
+            const auto draw_particles = [&] (GLint particle_view_translation)
+            {
+                glUniform2f(particle_view_translation, -camera.center().x, -camera.center().y);
+                particles.draw();
+
+                for (std::size_t i = 0; i < seam_count; ++i)
+                {
+                    glUniform2f(particle_view_translation, -seam_offsets[i].x - camera.center().x, -seam_offsets[i].y - camera.center().y);
+                    particles.draw();
+                }
             };
 
-            glUniform3f(color_uniform, 1.0f, 0.0f, 0.0f);
+            gpu_begin(GpuSection::PARTICLES);
+            if (point_shader)
+            {
+                point_shader->use();
+                glUniform1f(glGetUniformLocation(point_shader->id(), "view_scale"), camera.scale());
+                draw_particles(glGetUniformLocation(point_shader->id(), "view_translation"));
+                shader.use();
+            }
+            else
+            {
+                state_cache.useProgram(line_program);
+                state_cache.setColor(Color{ 1.0f, 0.8f, 0.4f });
+                state_cache.setTransform(DrawTransform{ { 1.0f, 1.0f }, { 1.0f, 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f } });
+                draw_particles(view_translation_uniform);
+            }
+            gpu_end(GpuSection::PARTICLES);
+
+            // particles set the view translation and bind their vertex array around the cache
+            state_cache.invalidate();
+
+            // draw HUD, one batch of lines for all text, in clip space
+            if (hud_visible)
+            {
+                gpu_begin(GpuSection::HUD);
+                state_cache.useProgram(line_program);
+                state_cache.setColor(Color{ 0.7f, 0.9f, 0.7f });
+                state_cache.setTransform(DrawTransform{ { 1.0f, 1.0f }, { 1.0f, 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f } });
+                state_cache.setViewTranslation(Vec2{ 0.0f, 0.0f });
+                state_cache.setViewScale(1.0f);
+                hud.draw(scale_uniform, translation_uniform, window.width(), window.height());
+                gpu_end(GpuSection::HUD);
+            }
+        }
+
+        const auto draw_end = std::chrono::steady_clock::now();
 
-            std::for_each(projectiles.begin(), projectiles.end(), draw_aabb);
-            std::for_each(rocks.begin(), rocks.end(), draw_aabb);
-            draw_aabb(ship);
+        if (capture)
+        {
+            TRACE_SCOPE("capture");
+            capture->endFrame(window.width(), window.height());
         }
 
-        start_time += delta_time_ms;
-        std::this_thread::sleep_until(start_time);
+        start_time += tick_duration;
+        if (simulate)
+        {
+            TRACE_SCOPE("sleep");
+            std::this_thread::sleep_until(start_time);
+        }
 
-        window.swapResizeClearBuffer();
+        {
+            TRACE_SCOPE("swap");
+            gpu_begin(GpuSection::SWAP);
+            window.swapResizeClearBuffer();
+            gpu_end(GpuSection::SWAP);
+        }
 
-        if (rocks.size() == 0)
+        if (profiler)
+            profiler->endFrame(latency);
+        frame++;
+
+        // frame rate and mean phase times of the interval that just ended
+        const auto frame_end = std::chrono::steady_clock::now();
+
+        hud_times.frames++;
+        hud_times.tick += milliseconds(tick_end - frame_start);
+        hud_times.draw += milliseconds(draw_end - tick_end);
+        hud_times.wait += milliseconds(frame_end - draw_end);
+
+        const auto interval = std::chrono::duration<float>{ frame_end - hud_interval_start }.count();
+        if (simulate && interval >= HUD_INTERVAL)
+        {
+            const double n = hud_times.frames;
+            char text[96];
+
+            std::snprintf(text, sizeof(text), "fps %.1f", n / interval);
+            hud.setLine(HUD_FPS, text);
+
+            std::snprintf(text, sizeof(text), "tick %.2f  draw %.2f  wait %.2f ms",
+                          hud_times.tick / n, hud_times.draw / n, hud_times.wait / n);
+            hud.setLine(HUD_PHASES, text);
+
+            const auto & state = state_cache.statistics();
+            std::snprintf(text, sizeof(text), "draws %.0f  state changes %.0f  avoided %.0f",
+                          static_cast<double>(state.draws) / n, static_cast<double>(state.changes) / n, static_cast<double>(state.avoided) / n);
+            hud.setLine(HUD_STATE, text);
+            state_cache.resetStatistics();
+
+            hud_times = HudTimes{};
+            hud_interval_start = frame_end;
+        }
+
+        // a game that can be rewound stays open after it is over
+        if (world.over() && !rewind)
             window.scheduleExit();
 
         {
@@ -194,4 +867,45 @@ int main()
             assert(r == GL_NO_ERROR);
         }
     }
+
+    if (profiler)
+    {
+        profiler->report();
+        latency.report();
+    }
+
+    run_states.report();
+
+    if (options.save_path.empty() == false)
+        world.save(options.save_path);
+
+    export_trace();
+
+    return 0;
+}
+
+//==============================================================================
+int main(int argc, char * argv[])
+{
+    // a bad command line gets the usage, any other error only its message
+    Options options;
+    try
+    {
+        options = Options::parse(argc, argv);
+    }
+    catch (const std::runtime_error & e)
+    {
+        std::cerr << e.what() << std::endl << std::endl << Options::usage();
+        return 2;
+    }
+
+    try
+    {
+        return run(options);
+    }
+    catch (const std::exception & e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
 }
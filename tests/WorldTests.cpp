@@ -0,0 +1,246 @@
+#include <iostream>
+#include <algorithm>
+#include <memory>
+
+#include "World.hpp"
+#include "BatchWorld.hpp"
+#include "Rewind.hpp"
+#include "Autopilot.hpp"
+
+namespace
+{
+    // ticks played before the rewind, longer than the buffer holds
+    constexpr std::uint64_t REWIND_TICKS = 600;
+    constexpr float REWIND_SECONDS = 2.0f;
+
+    // worlds of a batch whose first game is replayed on World and the ticks they play
+    constexpr std::size_t BATCH_WORLDS = 4;
+    constexpr std::uint64_t BATCH_TICKS = 600;
+
+    //==========================================================================
+    // Same state apart from body ids, which are never handed out twice
+    bool same_state(const World::Snapshot & a, const World::Snapshot & b)
+    {
+        const auto same = [] (const Vec2 & u, const Vec2 & v) { return u.x == v.x && u.y == v.y; };
+
+        if (a.tick_count != b.tick_count || a.rng_state != b.rng_state || a.score != b.score ||
+            a.players.size() != b.players.size() || a.rocks.size() != b.rocks.size() || a.projectiles.size() != b.projectiles.size())
+            return false;
+
+        for (std::size_t i = 0; i < a.players.size(); ++i)
+        {
+            const auto & p = a.players[i];
+            const auto & q = b.players[i];
+
+            if (!same(p.ship.position(), q.ship.position()) || !same(p.ship.direction(), q.ship.direction()) ||
+                p.invincibility_left != q.invincibility_left || p.destroyed != q.destroyed)
+                return false;
+        }
+
+        for (std::size_t i = 0; i < a.rocks.size(); ++i)
+        {
+            const auto & r = a.rocks[i];
+            const auto & s = b.rocks[i];
+
+            if (!same(r.position(), s.position()) || !same(r.velocity(), s.velocity()) || r.scale() != s.scale() ||
+                !std::equal(r.mesh().begin(), r.mesh().end(), s.mesh().begin(), s.mesh().end()))
+                return false;
+        }
+
+        for (std::size_t i = 0; i < a.projectiles.size(); ++i)
+        {
+            const auto & p = a.projectiles[i];
+            const auto & q = b.projectiles[i];
+
+            if (!same(p.position(), q.position()) || !same(p.velocity(), q.velocity()))
+                return false;
+        }
+
+        return true;
+    }
+
+    //==========================================================================
+    // A rock crossing the bottom seam near the right edge and a projectile
+    // crossing the left seam near the top, they only meet across the corner.
+    // The tick after placing them has to find the hit.
+    bool corner_hit()
+    {
+        const Scenario scenario;
+        const float w = scenario.world_size;
+
+        World world{ scenario };
+        World::Snapshot snapshot;
+        world.snapshot(snapshot);
+
+        // the outline once at the origin to find its lowest vertex
+        const float size = 0.1f * w;
+        Vec2Gen shape_rng{ 1 };
+        const Rock model{ shape_rng, size, 8, Vec2{ 0.0f, 0.0f }, Vec2{ 0.0f, 0.0f } };
+
+        Vec2 lowest = model.polygon().front();
+        for (const auto & v : model.polygon())
+            if (v.y < lowest.y)
+                lowest = v;
+
+        // the box ends just left of the right edge, the lowest vertex is below the bottom one
+        const auto half = model.modelBoundingBox().getMax();
+        const Vec2 position{ 0.995f * w - half.x, -1.08f * w - lowest.y * size };
+
+        Vec2Gen rng{ 1 };
+        snapshot.rocks.clear();
+        snapshot.rocks.emplace_back(rng, size, 8, position, Vec2{ 0.0f, 0.0f });
+
+        // the lowest vertex moved across both seams is inside the projectile's box
+        snapshot.projectiles.clear();
+        snapshot.projectiles.emplace_back(Vec2{ -0.95f * w, 0.65f * w }, Vec2{ 0.0f, 0.0f }, Vec2{ 0.3f * w, 0.3f * w }, 1.0f);
+
+        world.restore(snapshot);
+        world.tick(InputFrame{});
+
+        return world.score() != 0;
+    }
+
+    //==========================================================================
+    // Rewinds the whole buffer of an autopiloted game, plays the same ticks
+    // again and compares the result with the state before the rewind
+    bool rewind_replay()
+    {
+        const Scenario scenario;
+
+        World world{ scenario };
+        Autopilot autopilot;
+        RewindBuffer rewind{ rewind_capacity(REWIND_SECONDS, scenario.tick_rate) };
+
+        while (world.tickCount() < REWIND_TICKS && !world.over())
+        {
+            world.tick(autopilot.next(world, 0));
+            rewind.record(world);
+        }
+
+        World::Snapshot before;
+        world.snapshot(before);
+
+        const auto ticks = rewind.rewind(world, rewind.size() - 1);
+        if (ticks + 1 != rewind.capacity())
+            return false;
+
+        for (std::size_t i = 0; i < ticks; ++i)
+            world.tick(autopilot.next(world, 0));
+
+        World::Snapshot after;
+        world.snapshot(after);
+
+        return same_state(before, after);
+    }
+
+    //==========================================================================
+    // Same state of a batch world and a World, apart from body ids
+    bool same_state(const BatchWorld & batch, std::size_t w, const World & world)
+    {
+        const auto same = [] (const Vec2 & u, const Vec2 & v) { return u.x == v.x && u.y == v.y; };
+
+        if (batch.tickCount(w) != world.tickCount() || batch.score(w) != world.score() ||
+            batch.shipDestroyed(w) != world.shipDestroyed() || batch.invincibilityLeft(w) != world.invincibilityLeft() ||
+            !same(batch.ship(w).position(), world.ship().position()) || !same(batch.ship(w).direction(), world.ship().direction()) ||
+            batch.rockCount(w) != world.rocks().size() || batch.projectileCount(w) != world.projectiles().size())
+            return false;
+
+        for (std::size_t i = 0; i < world.rocks().size(); ++i)
+        {
+            const auto & r = world.rocks()[i];
+            if (!same(batch.rockPosition(w, i), r.position()) || !same(batch.rockVelocity(w, i), r.velocity()) ||
+                batch.rockSize(w, i) != r.scale())
+                return false;
+        }
+
+        for (std::size_t i = 0; i < world.projectiles().size(); ++i)
+        {
+            const auto & p = world.projectiles()[i];
+            if (!same(batch.projectilePosition(w, i), p.position()) || !same(batch.projectileVelocity(w, i), p.velocity()))
+                return false;
+        }
+
+        return true;
+    }
+
+    //==========================================================================
+    // Plays the first game of every world of a small batch on World too and
+    // compares them after every tick, even worlds turn, odd ones thrust
+    bool batch_matches_world()
+    {
+        const auto bit = [] (Action a) { return 1u << static_cast<std::uint32_t>(a); };
+
+        const Scenario scenario;
+        BatchWorld batch{ scenario, BATCH_WORLDS, 2 };
+
+        std::vector<std::unique_ptr<World>> worlds;
+        std::vector<InputFrame> inputs;
+        for (std::size_t w = 0; w < BATCH_WORLDS; ++w)
+        {
+            auto world_scenario = scenario;
+            world_scenario.seed = batch.seed(w);
+            worlds.push_back(std::make_unique<World>(world_scenario));
+            inputs.push_back(InputFrame::fromBitmask(w % 2 == 0 ? bit(Action::FIRE) | bit(Action::LEFT)
+                                                                : bit(Action::FIRE) | bit(Action::RIGHT) | bit(Action::FORWARD)));
+        }
+
+        std::uint64_t compared = 0;
+
+        for (std::uint64_t tick = 0; tick < BATCH_TICKS; ++tick)
+        {
+            batch.tick(inputs.data());
+
+            for (std::size_t w = 0; w < BATCH_WORLDS; ++w)
+            {
+                // the batch has moved on to the next game
+                if (!worlds[w])
+                    continue;
+
+                worlds[w]->tick(inputs[w]);
+
+                if (worlds[w]->over())
+                {
+                    worlds[w].reset();
+                    continue;
+                }
+
+                if (!same_state(batch, w, *worlds[w]))
+                    return false;
+
+                compared++;
+            }
+        }
+
+        return compared != 0;
+    }
+
+    struct Test
+    {
+        const char * name;
+        bool (*run)();
+    };
+
+    const Test TESTS[] =
+    {
+        { "rock and projectile meet across the corner", corner_hit },
+        { "rewound ticks replay identically", rewind_replay },
+        { "batch worlds play like World", batch_matches_world },
+    };
+}
+
+//==============================================================================
+int main()
+{
+    int result = 0;
+
+    for (const auto & test : TESTS)
+    {
+        const bool passed = test.run();
+        std::cout << (passed ? "ok      " : "FAILED  ") << test.name << std::endl;
+
+        if (!passed)
+            result = 1;
+    }
+
+    return result;
+}